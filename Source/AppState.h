@@ -1,6 +1,8 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "LogBuffer.h"
+#include "SampleRateConverter.h"
 
 //==============================================================================
 /**
@@ -24,9 +26,32 @@ enum class ProcessingStatus
 {
     pending,
     processing,
+    finalising,     // Captured, output file still being closed in the background
     completed,
     failed,
-    invalidSampleRate
+    invalidSampleRate   // No usable rate in the header - other rates are converted, not rejected
+};
+
+/**
+ * Parts of the application state that views refresh independently
+ * See AppState::markChanged() and StateWatcher
+ */
+enum class StateSection
+{
+    devices,    // Device list, selected device and channel pairs
+    files,      // The queue: entries, their status and selection, files still being added
+    progress,   // Operation flags and batch/preview position
+    settings,   // ProcessingSettings and measurements (latency, impulse response)
+    numSections
+};
+
+/** Orders the file list can be sorted in */
+enum class FileSortKey
+{
+    name,
+    status,
+    sampleRate,
+    duration
 };
 
 //==============================================================================
@@ -41,6 +66,8 @@ struct AudioDevice
     int outputChannelCount = 0;
     juce::String uniqueID;        // Real identifier from getIdentifierString()
     juce::String deviceTypeName;  // Type name (e.g., "CoreAudio", "ASIO")
+    juce::Array<double> sampleRates;  // As reported by the driver - empty if the device couldn't be opened
+    juce::Array<int> bufferSizes;
 
     /** Returns true if this is a built-in Apple device */
     bool isBuiltIn() const
@@ -116,12 +143,28 @@ class AudioFile
 public:
     AudioFile() : id(juce::Uuid().toString()) {}
 
+    /** Header information read by probe() */
+    struct Metadata
+    {
+        bool readable = false;
+        double sampleRate = 0.0;
+        juce::int64 durationSamples = 0;
+        int numChannels = 0;
+    };
+
     explicit AudioFile(const juce::File& file)
         : id(juce::Uuid().toString()), url(file)
     {
         loadMetadata();
     }
 
+    /** For metadata probed elsewhere (e.g. on a FileIngester worker) */
+    AudioFile(const juce::File& file, const Metadata& metadata)
+        : id(juce::Uuid().toString()), url(file)
+    {
+        applyMetadata(metadata);
+    }
+
     juce::String id;
     juce::File url;
     ProcessingStatus status = ProcessingStatus::pending;
@@ -134,39 +177,77 @@ public:
         return url.getFileName();
     }
 
-    /** Returns true if file sample rate matches target (44.1kHz) */
+    /** Returns true if the file has a usable sample rate (any rate - others than the device's are converted on load) */
     bool isValid() const
     {
-        return std::abs(sampleRate - 44100.0) < 1.0; // Allow small tolerance
+        return sampleRate > 0.0;
+    }
+
+    /** Returns true if the file has to be converted to play at the given (device) rate */
+    bool needsConversion(double targetRate) const
+    {
+        return SampleRateConverter::isNeeded(sampleRate, targetRate);
     }
 
     /** Loads audio file metadata (sample rate, duration) */
     void loadMetadata()
     {
-        if (!url.existsAsFile())
+        applyMetadata(probe(url));
+    }
+
+    void applyMetadata(const Metadata& metadata)
+    {
+        if (!metadata.readable)
         {
             status = ProcessingStatus::failed;
             return;
         }
 
-        juce::AudioFormatManager formatManager;
-        formatManager.registerBasicFormats();
-
-        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(url));
+        sampleRate = metadata.sampleRate;
+        durationSamples = metadata.durationSamples;
 
-        if (reader == nullptr)
+        if (!isValid())
         {
-            status = ProcessingStatus::failed;
-            return;
+            status = ProcessingStatus::invalidSampleRate;
         }
+    }
 
-        sampleRate = reader->sampleRate;
-        durationSamples = reader->lengthInSamples;
+    /** Reads the header of a file - safe to call from any thread */
+    static Metadata probe(const juce::File& file)
+    {
+        Metadata metadata;
 
-        if (!isValid())
+        if (!file.existsAsFile())
+            return metadata;
+
+        std::unique_ptr<juce::AudioFormatReader> reader(getFormatManager().createReaderFor(file));
+
+        if (reader != nullptr)
         {
-            status = ProcessingStatus::invalidSampleRate;
+            metadata.readable = true;
+            metadata.sampleRate = reader->sampleRate;
+            metadata.durationSamples = reader->lengthInSamples;
+            metadata.numChannels = (int)reader->numChannels;
         }
+
+        return metadata;
+    }
+
+    /**
+     * Shared reader factory for probing
+     * Registered once and never modified afterwards (don't register more formats on it),
+     * so concurrent createReaderFor() calls only read it - the basic formats keep no
+     * per-reader state in the format object
+     */
+    static juce::AudioFormatManager& getFormatManager()
+    {
+        struct SharedFormatManager : public juce::AudioFormatManager
+        {
+            SharedFormatManager() { registerBasicFormats(); }
+        };
+
+        static SharedFormatManager formatManager;  // Thread-safe one-off initialisation
+        return formatManager;
     }
 
     bool operator==(const AudioFile& other) const
@@ -190,7 +271,8 @@ struct ProcessingSettings
     // MARK: - Processing Settings
 
     BufferSize bufferSize = BufferSize::samples256;
-    int measuredLatencySamples = -1;  // -1 means not measured
+    int measuredLatencyFrames = -1;  // -1 means not measured; whole frames common to both returns
+    juce::Array<double> measuredChannelLatencyFrames;  // Per return, to a fraction of a frame
     BufferSize lastBufferSizeWhenMeasured = BufferSize::samples256;
     float measuredNoiseFloorDb = 0.0f;
     bool hasNoiseFloorMeasurement = false;
@@ -199,11 +281,25 @@ struct ProcessingSettings
     bool useReverbMode = false;  // Stop on noise floor instead of fixed length
     float noiseFloorMarginPercent = 10.0f;  // % above noise floor to stop recording
     int silenceBetweenFilesMs = 150;  // Gap between files in preview/processing
-    float thresholdDb = -40.0f;
+    int maxReverbTailSeconds = 60;  // Safety limit for reverb mode if the tail never decays
+    bool useOneTakeMode = false;  // Send all files as one continuous take, then split it offline
+    bool useOfflinePluginRender = false;  // Render through a hosted plugin instead of the audio device
+    juce::String offlinePluginPath;  // VST3 bundle or LV2 URI used by the offline render
+    int offlineRenderThreads = 0;  // 0 = one per physical core
+    bool useImpulseResponseRender = false;  // Convolve with the captured chain response instead of the device
+    float impulseSweepSeconds = 6.0f;  // Length of each measurement sweep
+    float impulseResponseSeconds = 4.0f;  // Length of the captured response (also the longest reverb tail rendered)
+    float thresholdDb = -40.0f;  // Silence trim threshold
+    float outputGainDb = 0.0f;  // Applied to every output file
+    bool ditherEnabled = true;  // TPDF dither when quantising to 24 bits
+
+    // Sources at another rate than sampleRate are converted on load (and cached)
+    SampleRateConverter::Quality resampleQuality = SampleRateConverter::Quality::standard;
+    bool convertCapturesToSourceRate = false;  // Write each output at its source's rate instead of sampleRate
 
     // Output settings
     juce::String outputFolderPath;
-    juce::String outputPostfix;  // Empty = same filename
+    juce::String outputPostfix;  // Empty = same base name (outputs are always .wav)
 
     // Monitoring settings
     bool enableMonitoring = true;  // Monitor preview/process through main outputs
@@ -214,32 +310,72 @@ struct ProcessingSettings
     int sendOutputBusRangeEnd = 4;
     int returnInputBus = 3;
     bool blockStereoOut = true;
-    bool trimEnabled = true;
+    bool trimEnabled = false;  // Trim leading/trailing silence below thresholdDb (breaks sample alignment with the source)
     bool dcRemovalEnabled = true;
     int postPlaybackSafetyMs = 250;
 
     /** Returns true if latency needs to be re-measured (buffer size changed) */
     bool needsLatencyRemeasurement() const
     {
-        if (measuredLatencySamples < 0)
+        if (measuredLatencyFrames < 0)
             return true;  // Never measured
 
         return lastBufferSizeWhenMeasured != bufferSize;
     }
 
+    /** Forgets the measured latency, so the next batch measures it again */
+    void invalidateLatency()
+    {
+        measuredLatencyFrames = -1;
+        measuredChannelLatencyFrames.clear();
+    }
+
+    /** Returns the whole frames skipped at the start of every capture */
+    int getLatencyFrames() const
+    {
+        return juce::jmax(0, measuredLatencyFrames);
+    }
+
+    /**
+     * Returns how far each return lags behind the skipped whole frames, in frames
+     * Non-negative, and empty when nothing is left to align (see FractionalDelay)
+     */
+    juce::Array<double> getChannelLatencyResiduals() const
+    {
+        juce::Array<double> residuals;
+
+        if (measuredLatencyFrames < 0)
+            return residuals;
+
+        for (auto latency : measuredChannelLatencyFrames)
+            residuals.add(juce::jmax(0.0, latency - getLatencyFrames()));
+
+        return residuals;
+    }
+
     /** Returns the measured latency in milliseconds */
     double getLatencyInMs() const
     {
-        if (measuredLatencySamples < 0)
+        if (measuredLatencyFrames < 0)
             return 0.0;
 
-        return (static_cast<double>(measuredLatencySamples) / sampleRate) * 1000.0;
+        return (static_cast<double>(measuredLatencyFrames) / sampleRate) * 1000.0;
     }
 
     /** Returns the recording length in samples for a given source file length */
-    int getRecordingLength(int sourceFileSamples, int latencySamples) const
+    int getRecordingLength(int sourceFileSamples, int latencyFrames) const
+    {
+        return sourceFileSamples + latencyFrames + (latencyFrames * 4);
+    }
+
+    /**
+     * Returns the silent guard after each file in one-take mode, in frames
+     * Long enough for the return to arrive plus the safety margin, so the
+     * next file's send never overlaps the previous capture
+     */
+    int getOneTakeGuardFrames(int latencyFrames) const
     {
-        return sourceFileSamples + latencySamples + (latencySamples * 4);
+        return latencyFrames + (int)(postPlaybackSafetyMs * sampleRate / 1000.0);
     }
 
     /** Returns the threshold in linear amplitude for the given dB value */
@@ -265,6 +401,21 @@ struct ProcessingSettings
  */
 struct AppState
 {
+    //==============================================================================
+    /**
+     * Call after changing a section, so views refresh it on their next frame
+     * Any thread (prepareToPlay updates the settings from the device thread)
+     */
+    void markChanged(StateSection section) noexcept
+    {
+        ++versions[(size_t)section];
+    }
+
+    juce::uint32 getVersion(StateSection section) const noexcept
+    {
+        return versions[(size_t)section].load();
+    }
+
     // Settings
     ProcessingSettings settings;
 
@@ -279,16 +430,15 @@ struct AppState
     // File management
     juce::Array<AudioFile> files;
     int currentFileIndex = 0;
+    int filesBeingAdded = 0;  // Found by the file ingester, headers not read yet
 
-    // Operation flags
+    // Operation flags (message thread only - the audio thread is driven by EngineCommands)
     bool isProcessing = false;
     bool isMeasuringLatency = false;
     bool isPreviewing = false;
     bool isTestingHardware = false;
-
-    // Audio buffers (for processing)
-    juce::AudioBuffer<float> currentPlaybackBuffer;
-    juce::AudioBuffer<float> recordingBuffer;
+    bool isCapturingImpulseResponse = false;
+    bool isCalibratingRoutes = false;  // Device open on every channel until the capture is in
 
     // Progress tracking
     double processingProgress = 0.0;
@@ -297,18 +447,17 @@ struct AppState
     double previewProgress = 0.0;
     juce::Array<juce::String> previewPlaylist;
 
-    // Logging
-    juce::StringArray logLines;
+    // Logging (bounded in memory, full history in LogBuffer::getDefaultFile())
+    LogBuffer logBuffer;
 
     // Playback state (for getNextAudioBlock)
     juce::int64 playbackPosition = 0;
     juce::int64 recordingPosition = 0;
     bool shouldSaveFile = false;
 
-    // Latency measurement state
-    bool impulseNotYetSent = true;
-    juce::AudioBuffer<float> latencyCaptureBuffer;
-    int latencyPeakPosition = -1;
+    // Impulse response of the selected send/return chain (see SweepMeasurement)
+    juce::AudioBuffer<float> chainImpulseResponse;  // 4 channels: L->L, L->R, R->L, R->R, latency removed
+    double chainImpulseResponseSampleRate = 0.0;
 
     // Hardware test state
     float hardwareTestPhase = 0.0f;
@@ -378,11 +527,41 @@ struct AppState
         return !selectedDeviceID.isEmpty() && hasInputPair && hasOutputPair;
     }
 
-    /** Add a log message with timestamp */
+    // Bumped by markChanged()
+    std::array<std::atomic<juce::uint32>, (size_t)StateSection::numSections> versions {};
+
+    /** Add a log message with timestamp - safe from any thread */
     void appendLog(const juce::String& message)
     {
-        juce::Time now = juce::Time::getCurrentTime();
-        juce::String timestamp = now.formatted("[%Y-%m-%dT%H:%M:%S]");
-        logLines.add(timestamp + " " + message);
+        logBuffer.append(message);
     }
 };
+
+//==============================================================================
+/**
+ * Remembers which version of each AppState section a view last showed
+ * hasChanged() is true the first time it is asked and then once per change
+ */
+class StateWatcher
+{
+public:
+    StateWatcher()
+    {
+        seenVersions.fill(std::numeric_limits<juce::uint32>::max());
+    }
+
+    bool hasChanged(const AppState& state, StateSection section) noexcept
+    {
+        const juce::uint32 version = state.getVersion(section);
+        auto& seen = seenVersions[(size_t)section];
+
+        if (seen == version)
+            return false;
+
+        seen = version;
+        return true;
+    }
+
+private:
+    std::array<juce::uint32, (size_t)StateSection::numSections> seenVersions;
+};
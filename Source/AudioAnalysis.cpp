@@ -0,0 +1,234 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "AudioAnalysis.h"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>   // SSE2 is part of the x86-64 baseline, no extra compiler flags needed
+ #define F9_ANALYSIS_SSE2 1
+#elif JUCE_ARM && (defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (_M_ARM64))
+ #include <arm_neon.h>
+ #define F9_ANALYSIS_NEON 1
+#endif
+
+namespace
+{
+// Float lanes are folded into the double totals after this many samples
+constexpr int accumulateBlock = 4096;
+
+void analyseScalar(const float* data, int start, int end, AudioAnalysis::ChannelStats& stats) noexcept
+{
+    for (int i = start; i < end; ++i)
+    {
+        const float sample = data[i];
+        const float magnitude = std::abs(sample);
+
+        stats.sum += sample;
+        stats.sumOfSquares += (double)sample * sample;
+
+        if (magnitude > stats.peak)
+        {
+            stats.peak = magnitude;
+            stats.peakIndex = i;
+        }
+    }
+}
+
+/** Folds per-lane peaks into stats, keeping the earliest index on ties */
+void reducePeakLanes(const float* peaks, const int32_t* indices, AudioAnalysis::ChannelStats& stats) noexcept
+{
+    for (int lane = 0; lane < 4; ++lane)
+    {
+        if (indices[lane] < 0)
+            continue;
+
+        if (peaks[lane] > stats.peak || (peaks[lane] == stats.peak && indices[lane] < stats.peakIndex))
+        {
+            stats.peak = peaks[lane];
+            stats.peakIndex = indices[lane];
+        }
+    }
+}
+}
+
+namespace AudioAnalysis
+{
+
+//==============================================================================
+// Fused Analysis
+
+ChannelStats analyseChannel(const float* data, int numSamples) noexcept
+{
+    ChannelStats stats;
+    int i = 0;
+
+   #if F9_ANALYSIS_SSE2 || F9_ANALYSIS_NEON
+    const int vectorEnd = numSamples & ~3;
+    alignas(16) float sums[4], squareSums[4], peaks[4];
+    alignas(16) int32_t indices[4];
+   #endif
+
+   #if F9_ANALYSIS_SSE2
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128i step = _mm_set1_epi32(4);
+    __m128 peak = _mm_setzero_ps();
+    __m128i peakIndex = _mm_set1_epi32(-1);
+    __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+
+    while (i < vectorEnd)
+    {
+        const int blockEnd = juce::jmin(vectorEnd, i + accumulateBlock);
+        __m128 sum = _mm_setzero_ps();
+        __m128 squares = _mm_setzero_ps();
+
+        for (; i < blockEnd; i += 4)
+        {
+            const __m128 samples = _mm_loadu_ps(data + i);
+            const __m128 magnitude = _mm_and_ps(samples, absMask);
+            const __m128i greater = _mm_castps_si128(_mm_cmpgt_ps(magnitude, peak));
+
+            sum = _mm_add_ps(sum, samples);
+            squares = _mm_add_ps(squares, _mm_mul_ps(samples, samples));
+            peak = _mm_max_ps(peak, magnitude);
+            peakIndex = _mm_or_si128(_mm_and_si128(greater, index), _mm_andnot_si128(greater, peakIndex));
+            index = _mm_add_epi32(index, step);
+        }
+
+        _mm_store_ps(sums, sum);
+        _mm_store_ps(squareSums, squares);
+
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            stats.sum += sums[lane];
+            stats.sumOfSquares += squareSums[lane];
+        }
+    }
+
+    _mm_store_ps(peaks, peak);
+    _mm_store_si128(reinterpret_cast<__m128i*>(indices), peakIndex);
+    reducePeakLanes(peaks, indices, stats);
+
+   #elif F9_ANALYSIS_NEON
+    const int32_t firstIndices[4] = { 0, 1, 2, 3 };
+    const int32x4_t step = vdupq_n_s32(4);
+    float32x4_t peak = vdupq_n_f32(0.0f);
+    int32x4_t peakIndex = vdupq_n_s32(-1);
+    int32x4_t index = vld1q_s32(firstIndices);
+
+    while (i < vectorEnd)
+    {
+        const int blockEnd = juce::jmin(vectorEnd, i + accumulateBlock);
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        float32x4_t squares = vdupq_n_f32(0.0f);
+
+        for (; i < blockEnd; i += 4)
+        {
+            const float32x4_t samples = vld1q_f32(data + i);
+            const float32x4_t magnitude = vabsq_f32(samples);
+            const uint32x4_t greater = vcgtq_f32(magnitude, peak);
+
+            sum = vaddq_f32(sum, samples);
+            squares = vmlaq_f32(squares, samples, samples);
+            peak = vmaxq_f32(peak, magnitude);
+            peakIndex = vbslq_s32(greater, index, peakIndex);
+            index = vaddq_s32(index, step);
+        }
+
+        vst1q_f32(sums, sum);
+        vst1q_f32(squareSums, squares);
+
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            stats.sum += sums[lane];
+            stats.sumOfSquares += squareSums[lane];
+        }
+    }
+
+    vst1q_f32(peaks, peak);
+    vst1q_s32(indices, peakIndex);
+    reducePeakLanes(peaks, indices, stats);
+   #endif
+
+    // Tail (and the whole channel on other targets)
+    analyseScalar(data, i, numSamples, stats);
+    return stats;
+}
+
+BufferStats analyse(const juce::AudioBuffer<float>& buffer) noexcept
+{
+    BufferStats stats;
+    const int numSamples = buffer.getNumSamples();
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        const ChannelStats channel = analyseChannel(buffer.getReadPointer(ch), numSamples);
+
+        stats.sumOfSquares += channel.sumOfSquares;
+        stats.numSamples += numSamples;
+
+        if (channel.peak > stats.peak)
+        {
+            stats.peak = channel.peak;
+            stats.peakChannel = ch;
+            stats.peakIndex = channel.peakIndex;
+        }
+    }
+
+    return stats;
+}
+
+float BufferStats::getRMS() const noexcept
+{
+    if (numSamples == 0)
+        return 0.0f;
+
+    return (float)std::sqrt(sumOfSquares / (double)numSamples);
+}
+
+float BufferStats::getNoiseFloorDb() const noexcept
+{
+    return 20.0f * std::log10(juce::jmax(getRMS(), 1e-6f));
+}
+
+//==============================================================================
+// Analysis Helpers
+
+int findPeakPosition(const juce::AudioBuffer<float>& buffer, float threshold) noexcept
+{
+    const BufferStats stats = analyse(buffer);
+
+    if (stats.peak > threshold)
+        return stats.peakIndex;
+
+    return -1; // No peak found
+}
+
+float calculateNoiseFloorDb(const juce::AudioBuffer<float>& buffer) noexcept
+{
+    return analyse(buffer).getNoiseFloorDb();
+}
+
+float calculateRMS(const juce::AudioBuffer<float>& buffer) noexcept
+{
+    return analyse(buffer).getRMS();
+}
+
+juce::uint64 hashContent(const juce::AudioBuffer<float>& buffer) noexcept
+{
+    // FNV-1a over whole 32-bit sample words rather than bytes - a quarter of the multiplies
+    juce::uint64 hash = 0xcbf29ce484222325ull;
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        const float* data = buffer.getReadPointer(ch);
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            juce::uint32 word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * 0x100000001b3ull;
+        }
+    }
+
+    return hash;
+}
+
+} // namespace AudioAnalysis
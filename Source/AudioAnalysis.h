@@ -0,0 +1,60 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * Analysis kernels
+ *
+ * Stateless functions over whole buffers, shared by the engine and the kernel
+ * benchmark (post-processing lives in CaptureOutput). All of them are allocation-free and can be called from the
+ * audio thread.
+ *
+ * The reductions all come from one fused pass (analyseChannel) that gathers
+ * sum, sum of squares, absolute peak and peak index together, four samples at
+ * a time with SSE2 on x86-64 or NEON on ARM. Lanes accumulate in float for a
+ * few thousand samples at a time and are then folded into doubles, so long
+ * captures keep the precision of a per-sample double loop.
+ */
+namespace AudioAnalysis
+{
+    /** One channel, gathered in a single pass */
+    struct ChannelStats
+    {
+        double sum = 0.0;
+        double sumOfSquares = 0.0;
+        float peak = 0.0f;           // Largest absolute value
+        int peakIndex = -1;          // First sample holding it, -1 if every sample is silent
+    };
+
+    /** Every channel of a buffer; the peak is the first occurrence, scanning channel by channel */
+    struct BufferStats
+    {
+        double sumOfSquares = 0.0;
+        juce::int64 numSamples = 0;  // Frames x channels
+        float peak = 0.0f;
+        int peakChannel = -1;
+        int peakIndex = -1;
+
+        float getRMS() const noexcept;
+
+        /** RMS in dB, floored at -120 dB */
+        float getNoiseFloorDb() const noexcept;
+    };
+
+    ChannelStats analyseChannel(const float* data, int numSamples) noexcept;
+
+    BufferStats analyse(const juce::AudioBuffer<float>& buffer) noexcept;
+
+    /** Find peak position in captured audio (for latency detection), -1 if nothing exceeds threshold */
+    int findPeakPosition(const juce::AudioBuffer<float>& buffer, float threshold) noexcept;
+
+    /** Calculate noise floor in dB */
+    float calculateNoiseFloorDb(const juce::AudioBuffer<float>& buffer) noexcept;
+
+    /** Calculate RMS level of audio buffer */
+    float calculateRMS(const juce::AudioBuffer<float>& buffer) noexcept;
+
+    /** 64-bit hash of the samples, for telling files apart (not cryptographic) */
+    juce::uint64 hashContent(const juce::AudioBuffer<float>& buffer) noexcept;
+}
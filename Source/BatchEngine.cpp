@@ -0,0 +1,2206 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "BatchEngine.h"
+
+namespace
+{
+// Added to a saved file's log line when DC removal had no latency or pre-roll to measure the bias in
+const juce::String dcOffsetSkippedNote = " - DC offset not removed (no latency or pre-roll to measure it in)";
+}
+
+//==============================================================================
+BatchEngine::BatchEngine(juce::AudioDeviceManager& deviceManagerToUse)
+    : deviceManager(deviceManagerToUse),
+      deviceProber(deviceManagerToUse),
+      fileIngester(metadataIndex)
+{
+    deviceProber.onDevicesChanged = [this](bool scanFinished) { handleDevicesChanged(scanFinished); };
+    fileIngester.onFilesProbed = [this](const juce::Array<FileIngester::Result>& results) { handleFilesProbed(results); };
+    captureWriter.onTakeFinished = [this](const CaptureWriter::Result& result) { handleTakeFinished(result); };
+    playbackLoader.onFileLoaded = [this](const PlaybackLoader::Result& result) { handleFileLoaded(result); };
+    latencyMeasurement.onAnalysed = [this](const LatencyMeasurement::Result& result) { completeLatencyMeasurement(result); };
+    routeCalibration.onAnalysed = [this](const RouteCalibration::Result& result) { completeRouteCalibration(result); };
+    takeSplitter.onSegmentFinished = [this](const TakeSplitter::Result& result) { handleSegmentSplit(result); };
+    offlineRenderer.onFileRendered = [this](const OfflineRenderer::Result& result) { handleOfflineFileRendered(result); };
+
+    // Hardware-free loopback, listed with the real interfaces
+    // The platform types are created first - the manager only creates them while its type list is empty
+    deviceManager.getAvailableDeviceTypes();
+
+    auto loopbackType = std::make_unique<VirtualLoopbackDeviceType>();
+    loopbackDeviceType = loopbackType.get();
+    deviceManager.addAudioDeviceType(std::move(loopbackType));
+
+    // Waking the message thread from the audio callback would post an OS message, which can lock or allocate
+    startTimer(eventPollIntervalMs);
+}
+
+BatchEngine::~BatchEngine()
+{
+    stopTimer();
+}
+
+//==============================================================================
+// AudioSource Overrides
+
+void BatchEngine::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    // CRITICAL: Update appState with ACTUAL device settings
+    appState.settings.sampleRate = sampleRate;
+    appState.settings.bufferSize = static_cast<BufferSize>(samplesPerBlockExpected);
+    appState.markChanged(StateSection::settings);
+
+    // Allocate our input buffer (for capturing device inputs)
+    // Some drivers deliver larger blocks than announced, so leave headroom
+    auto* device = deviceManager.getCurrentAudioDevice();
+    if (device != nullptr)
+    {
+        int numInputChannels = device->getActiveInputChannels().countNumberOfSetBits();
+        inputBuffer.setSize(numInputChannels, samplesPerBlockExpected * 4);
+        appState.appendLog("Input buffer allocated: " + juce::String(numInputChannels) + " channels");
+    }
+
+    // Captures stream through a 10 second FIFO to the writer thread, whatever their length
+    captureWriter.prepare(2, static_cast<int>(sampleRate * 10));
+
+    // Restart the engine from idle - any running operation is abandoned and its
+    // playback buffers are handed back to the loader
+    bool operationInterrupted = engineMode != EngineMode::idle;
+
+    EngineCommand discarded;
+    while (commandQueue.pop(discarded))
+    {
+        operationInterrupted = operationInterrupted || discarded.type != EngineCommand::Type::stop;
+        releasePlaybackBuffer(discarded.playbackBuffer);
+    }
+
+    abandonCurrentOperation();
+    lastXRunCount = deviceManager.getXRunCount();
+
+    // The callback is stopped while preparing, so the event queue still has a single producer
+    postEngineEvent(EngineEvent::Type::engineReset, -1, engineSampleClock.load(), operationInterrupted ? 1 : 0);
+
+    appState.appendLog("Audio system prepared: " + juce::String(sampleRate) + " Hz, " +
+                       juce::String(samplesPerBlockExpected) + " samples/block");
+}
+
+void BatchEngine::releaseResources()
+{
+    appState.appendLog("Audio resources released");
+}
+
+void BatchEngine::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    const int numSamples = bufferToFill.numSamples;
+    const int numChannels = bufferToFill.buffer->getNumChannels();
+
+    // Copy device inputs out before the shared buffer is cleared for output
+    const int numInputChannels = juce::jmin(inputBuffer.getNumChannels(), numChannels);
+    const int numInputSamples = juce::jmin(inputBuffer.getNumSamples(), numSamples);
+    for (int ch = 0; ch < numInputChannels; ++ch)
+        inputBuffer.copyFrom(ch, 0, *bufferToFill.buffer, ch, bufferToFill.startSample, numInputSamples);
+
+    // Clear all outputs by default
+    bufferToFill.clearActiveBufferRegion();
+
+    processPendingCommands();
+
+    // Report dropouts so a capture can be flagged as suspect
+    const int xruns = deviceManager.getXRunCount();
+    if (xruns != lastXRunCount)
+    {
+        lastXRunCount = xruns;
+        postEngineEvent(EngineEvent::Type::xrun, activeCommand.fileIndex, engineSampleClock.load(), xruns);
+    }
+
+    // State machine based on the active command
+    switch (engineMode)
+    {
+        case EngineMode::testingHardware:  renderHardwareTest(bufferToFill); break;
+        case EngineMode::measuringLatency:
+        case EngineMode::capturingImpulseResponse: renderStimulusCapture(bufferToFill); break;
+        case EngineMode::calibratingRoutes: renderRouteCalibration(bufferToFill); break;
+        case EngineMode::idle:             break;
+
+        case EngineMode::processing:
+        case EngineMode::previewing:
+        {
+            // A file can finish mid-block - the armed next file starts on the very next frame
+            int blockOffset = 0;
+            while (blockOffset < numSamples && (engineMode == EngineMode::processing || engineMode == EngineMode::previewing))
+                blockOffset += renderPlayback(bufferToFill, blockOffset);
+            break;
+        }
+    }
+
+    engineSampleClock.fetch_add(numSamples);
+}
+
+//==============================================================================
+// Audio Thread Helpers
+
+void BatchEngine::processPendingCommands()
+{
+    EngineCommand command;
+
+    while (commandQueue.pop(command))
+    {
+        const bool isPlaybackCommand = command.type == EngineCommand::Type::startProcessingFile
+                                    || command.type == EngineCommand::Type::startPreviewFile
+                                    || command.type == EngineCommand::Type::closeTake;
+        const bool isPlaying = engineMode == EngineMode::processing || engineMode == EngineMode::previewing;
+
+        // Arm the next file so it starts the moment the current one finishes
+        if (isPlaybackCommand && command.queueAfterCurrent && isPlaying)
+        {
+            // The loader only has two buffers, so the queue can't fill up in practice
+            jassert(numArmedCommands < maxArmedCommands);
+
+            if (numArmedCommands < maxArmedCommands)
+                armedCommands[(size_t)numArmedCommands++] = command;
+            else
+                releasePlaybackBuffer(command.playbackBuffer);
+            continue;
+        }
+
+        abandonCurrentOperation();
+        activateCommand(command);
+    }
+}
+
+void BatchEngine::activateCommand(const EngineCommand& command)
+{
+    // Pre-roll only applies when starting from idle - an armed file follows the previous gap directly
+    const bool startingFromIdle = engineMode == EngineMode::idle;
+
+    activeCommand = command;
+    playbackSamplePosition = 0;
+    recordingSamplePosition = 0;
+    consecutiveSilentBuffers = 0;
+
+    if (command.playbackBuffer != nullptr)
+        activeCommand.playbackFrames = juce::jmin(command.playbackFrames, (juce::int64)command.playbackBuffer->getNumSamples());
+
+    enterTransportPhase(startingFromIdle ? TransportPhase::preRoll : TransportPhase::play);
+
+    switch (command.type)
+    {
+        case EngineCommand::Type::stop:
+            engineMode = EngineMode::idle;
+            break;
+
+        case EngineCommand::Type::startProcessingFile:
+            // One-take mode: every file after the first joins the take that is already open
+            if (capturingTakeId != command.takeId)
+                beginCapture(command.takeId);
+            engineMode = EngineMode::processing;
+            break;
+
+        case EngineCommand::Type::startPreviewFile:
+            engineMode = EngineMode::previewing;
+            break;
+
+        case EngineCommand::Type::startLatencyMeasurement:
+            engineMode = EngineMode::measuringLatency;
+            break;
+
+        case EngineCommand::Type::startHardwareTest:
+            sinePhase = 0.0f;
+            engineMode = EngineMode::testingHardware;
+            break;
+
+        case EngineCommand::Type::startImpulseResponseCapture:
+            engineMode = EngineMode::capturingImpulseResponse;
+            break;
+
+        case EngineCommand::Type::startRouteCalibration:
+            engineMode = EngineMode::calibratingRoutes;
+            break;
+
+        case EngineCommand::Type::closeTake:
+            endCapture(false);
+            engineMode = EngineMode::idle;
+            break;
+    }
+}
+
+void BatchEngine::abandonCurrentOperation()
+{
+    // A capture interrupted by any new command is discarded
+    endCapture(true);
+
+    if (engineMode == EngineMode::processing || engineMode == EngineMode::previewing)
+        releasePlaybackBuffer(activeCommand.playbackBuffer);
+
+    for (int i = 0; i < numArmedCommands; ++i)
+        releasePlaybackBuffer(armedCommands[(size_t)i].playbackBuffer);
+    numArmedCommands = 0;
+
+    engineMode = EngineMode::idle;
+}
+
+void BatchEngine::enterTransportPhase(TransportPhase phase)
+{
+    transportPhase = phase;
+
+    switch (phase)
+    {
+        case TransportPhase::preRoll: phaseFramesRemaining = activeCommand.preRollFrames; break;
+        case TransportPhase::play:
+            phaseFramesRemaining = activeCommand.playbackFrames;
+            recordingSamplePosition = 0; // Captured length counts from the first frame sent
+            break;
+        case TransportPhase::tail:    phaseFramesRemaining = activeCommand.captureFrames - activeCommand.playbackFrames; break;
+        case TransportPhase::gap:     phaseFramesRemaining = activeCommand.gapFrames; break;
+    }
+
+    phaseFramesRemaining = juce::jmax((juce::int64)0, phaseFramesRemaining);
+}
+
+void BatchEngine::startArmedFileOrIdle()
+{
+    engineMode = EngineMode::idle;
+
+    if (numArmedCommands == 0)
+        return;
+
+    const EngineCommand next = armedCommands[0];
+
+    for (int i = 1; i < numArmedCommands; ++i)
+        armedCommands[(size_t)(i - 1)] = armedCommands[(size_t)i];
+    --numArmedCommands;
+
+    // One-take mode: the stream has ended, so the take can be written out
+    if (next.type == EngineCommand::Type::closeTake)
+    {
+        endCapture(false);
+        return;
+    }
+
+    // Pointer exchange to the prefetched next file
+    engineMode = next.type == EngineCommand::Type::startProcessingFile ? EngineMode::processing
+                                                                       : EngineMode::previewing;
+    activateCommand(next);
+}
+
+void BatchEngine::beginCapture(int takeId)
+{
+    captureWriter.beginTake(takeId);
+    capturingTakeId = takeId;
+    takeSamplePosition = 0;
+}
+
+void BatchEngine::endCapture(bool aborted)
+{
+    if (capturingTakeId < 0)
+        return;
+
+    captureWriter.endTake(aborted);
+    capturingTakeId = -1;
+}
+
+void BatchEngine::releasePlaybackBuffer(juce::AudioBuffer<float>* buffer)
+{
+    if (buffer == nullptr)
+        return;
+
+    EngineEvent event;
+    event.type = EngineEvent::Type::playbackReleased;
+    event.playbackBuffer = buffer;
+    eventQueue.push(event);
+}
+
+void BatchEngine::renderHardwareTest(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    // ============================================================
+    // HARDWARE TEST MODE: Generate 1kHz sine wave (stereo for now)
+    // ============================================================
+
+    if (bufferToFill.buffer->getNumChannels() < 2)
+        return;
+
+    const int numSamples = bufferToFill.numSamples;
+    const float amplitude = 0.5f;
+    const float phaseIncrement = (sineFrequency * 2.0f * juce::MathConstants<float>::pi) /
+                                 (float)appState.settings.sampleRate;
+
+    float* leftData = bufferToFill.buffer->getWritePointer(0, bufferToFill.startSample);
+    float* rightData = bufferToFill.buffer->getWritePointer(1, bufferToFill.startSample);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float sample = amplitude * std::sin(sinePhase);
+        leftData[i] = sample;
+        rightData[i] = sample;
+
+        sinePhase += phaseIncrement;
+        if (sinePhase >= 2.0f * juce::MathConstants<float>::pi)
+            sinePhase -= 2.0f * juce::MathConstants<float>::pi;
+    }
+}
+
+int BatchEngine::renderPlayback(const juce::AudioSourceChannelInfo& bufferToFill, int blockOffset)
+{
+    const int available = bufferToFill.numSamples - blockOffset;
+    const bool captureReturn = engineMode == EngineMode::processing;
+
+    // One-take mode captures the whole stream, silences included
+    const bool captureStream = captureReturn && activeCommand.continuousTake;
+
+    // If the next file of a one-take render is late, keep capturing silence rather than break the take
+    const bool holdingTake = captureStream && transportPhase == TransportPhase::gap
+                          && phaseFramesRemaining <= 0 && numArmedCommands == 0;
+
+    const int frames = holdingTake ? available
+                                   : (int)juce::jlimit((juce::int64)0, (juce::int64)available, phaseFramesRemaining);
+    const juce::int64 phaseStartClock = engineSampleClock.load() + blockOffset;
+    const juce::int64 phaseEndClock = phaseStartClock + frames;
+
+    phaseFramesRemaining = juce::jmax((juce::int64)0, phaseFramesRemaining - frames);
+
+    switch (transportPhase)
+    {
+        case TransportPhase::preRoll:
+        {
+            // Silence while the chain settles before the first file
+            if (captureStream)
+                captureReturnFrames(blockOffset, frames);
+
+            if (phaseFramesRemaining <= 0)
+                enterTransportPhase(TransportPhase::play);
+            break;
+        }
+
+        case TransportPhase::play:
+        {
+            // One-take mode: report where this file starts in the take so it can be split out later
+            if (captureStream && playbackSamplePosition == 0)
+                postEngineEvent(EngineEvent::Type::segmentStarted, activeCommand.fileIndex, phaseStartClock, takeSamplePosition);
+
+            const auto& source = *activeCommand.playbackBuffer;
+            const int numOutputs = juce::jmin(2, bufferToFill.buffer->getNumChannels(), source.getNumChannels());
+
+            for (int ch = 0; ch < numOutputs; ++ch)
+                bufferToFill.buffer->copyFrom(ch, bufferToFill.startSample + blockOffset, source, ch,
+                                              (int)playbackSamplePosition, frames);
+            playbackSamplePosition += frames;
+
+            if (captureReturn)
+                captureReturnFrames(blockOffset, frames);
+
+            if (phaseFramesRemaining > 0)
+                break;
+
+            // Source fully sent - the buffer goes back to the loader straight away
+            releasePlaybackBuffer(activeCommand.playbackBuffer);
+            activeCommand.playbackBuffer = nullptr;
+
+            if (captureReturn)
+            {
+                enterTransportPhase(TransportPhase::tail);
+            }
+            else
+            {
+                postEngineEvent(EngineEvent::Type::previewFileFinished, activeCommand.fileIndex, phaseEndClock);
+                enterTransportPhase(TransportPhase::gap);
+            }
+            break;
+        }
+
+        case TransportPhase::tail:
+        {
+            // Latency + safety (or reverb tail) after the source, captured but not sent
+            captureReturnFrames(blockOffset, frames);
+
+            bool finished = phaseFramesRemaining <= 0;
+
+            // Reverb mode: stop when the tail decays into the noise floor
+            const int windowFrames = juce::jmin(frames, inputBuffer.getNumSamples() - blockOffset);
+
+            if (!finished && activeCommand.stopOnNoiseFloor && windowFrames > 0)
+            {
+                juce::AudioBuffer<float> window(inputBuffer.getArrayOfWritePointers(), inputBuffer.getNumChannels(),
+                                                blockOffset, windowFrames);
+
+                if (isReverbTailBelowNoiseFloor(window, activeCommand.noiseFloorThresholdDb))
+                    finished = ++consecutiveSilentBuffers >= requiredConsecutiveSilentBuffers;
+                else
+                    consecutiveSilentBuffers = 0;
+            }
+
+            if (!finished)
+                break;
+
+            if (!activeCommand.continuousTake)
+                endCapture(false);
+
+            postEngineEvent(EngineEvent::Type::fileFinished, activeCommand.fileIndex, phaseEndClock, recordingSamplePosition);
+            enterTransportPhase(TransportPhase::gap);
+            break;
+        }
+
+        case TransportPhase::gap:
+        {
+            // Silence between files, counted in frames
+            if (captureStream)
+                captureReturnFrames(blockOffset, frames);
+
+            if (phaseFramesRemaining <= 0 && !holdingTake)
+                startArmedFileOrIdle();
+            break;
+        }
+    }
+
+    return frames;
+}
+
+void BatchEngine::captureReturnFrames(int blockOffset, int numFrames)
+{
+    const int framesToRecord = juce::jmax(0, juce::jmin(numFrames, inputBuffer.getNumSamples() - blockOffset));
+
+    if (framesToRecord > 0)
+        captureWriter.pushFrames(inputBuffer, blockOffset, framesToRecord);
+
+    recordingSamplePosition += framesToRecord;
+    takeSamplePosition += framesToRecord;
+}
+
+void BatchEngine::renderStimulusCapture(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    const auto& stimulus = *activeCommand.playbackBuffer;
+    auto& capture = *activeCommand.captureBuffer;
+    const int position = (int)recordingSamplePosition;
+    const int frames = juce::jlimit(0, bufferToFill.numSamples, capture.getNumSamples() - position);
+
+    // Send: the stimulus on the selected output pair
+    const int framesToSend = juce::jlimit(0, frames, stimulus.getNumSamples() - position);
+    const int numOutputs = juce::jmin(2, bufferToFill.buffer->getNumChannels(), stimulus.getNumChannels());
+
+    for (int ch = 0; ch < numOutputs && framesToSend > 0; ++ch)
+        bufferToFill.buffer->copyFrom(ch, bufferToFill.startSample, stimulus, ch, position, framesToSend);
+
+    // Return: both inputs of the selected pair
+    const int framesToRecord = juce::jmin(frames, inputBuffer.getNumSamples());
+    const int numReturns = juce::jmin(capture.getNumChannels(), inputBuffer.getNumChannels());
+
+    for (int ch = 0; ch < numReturns; ++ch)
+        capture.copyFrom(ch, position, inputBuffer, ch, 0, framesToRecord);
+
+    recordingSamplePosition += frames;
+
+    if (recordingSamplePosition >= capture.getNumSamples())
+    {
+        const auto completed = engineMode == EngineMode::measuringLatency ? EngineEvent::Type::latencyCaptureComplete
+                                                                          : EngineEvent::Type::impulseResponseCaptureComplete;
+        engineMode = EngineMode::idle;
+        postEngineEvent(completed, -1, engineSampleClock.load() + frames, recordingSamplePosition);
+    }
+}
+
+void BatchEngine::renderRouteCalibration(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    const auto& sequence = *activeCommand.playbackBuffer;
+    auto& capture = *activeCommand.captureBuffer;
+    const int sequenceFrames = sequence.getNumSamples();
+    const juce::int64 spacing = juce::jmax((juce::int64)1, activeCommand.codeSpacingFrames);
+    const juce::int64 prefix = activeCommand.prefixFrames;
+    const juce::int64 position = recordingSamplePosition;  // From the first frame sent
+    const juce::int64 totalFrames = prefix + activeCommand.captureFrames;
+    const int frames = (int)juce::jlimit((juce::int64)0, (juce::int64)bufferToFill.numSamples, totalFrames - position);
+
+    // Send: the sequence on every output pair, each shifted by one more slot (channels beyond the codes stay silent)
+    const int numOutputs = (int)juce::jmin((juce::int64)bufferToFill.buffer->getNumChannels(), 2 * (sequenceFrames / spacing));
+
+    for (int ch = 0; ch < numOutputs && frames > 0; ++ch)
+    {
+        if (ch / 2 < 64 && ((activeCommand.silentOutputPairs >> (ch / 2)) & 1) != 0)
+            continue;
+
+        juce::int64 index = (position - prefix - (ch / 2) * spacing) % sequenceFrames;
+        if (index < 0)
+            index += sequenceFrames;
+
+        // The sequence repeats - a block wraps at most once
+        const int firstChunk = (int)juce::jmin((juce::int64)frames, sequenceFrames - index);
+        bufferToFill.buffer->copyFrom(ch, bufferToFill.startSample, sequence, 0, (int)index, firstChunk);
+
+        if (firstChunk < frames)
+            bufferToFill.buffer->copyFrom(ch, bufferToFill.startSample + firstChunk, sequence, 0, 0, frames - firstChunk);
+    }
+
+    // Return: every input, once the prefix has made all of them periodic
+    const int captureStart = (int)juce::jlimit((juce::int64)0, (juce::int64)frames, prefix - position);
+    const int framesToRecord = juce::jmin(frames, inputBuffer.getNumSamples()) - captureStart;
+    const int numInputs = juce::jmin(capture.getNumChannels(), inputBuffer.getNumChannels());
+
+    for (int ch = 0; ch < numInputs && framesToRecord > 0; ++ch)
+        capture.copyFrom(ch, (int)(position + captureStart - prefix), inputBuffer, ch, captureStart, framesToRecord);
+
+    recordingSamplePosition += frames;
+
+    if (recordingSamplePosition >= totalFrames)
+    {
+        engineMode = EngineMode::idle;
+        postEngineEvent(EngineEvent::Type::routeCalibrationCaptureComplete, -1, engineSampleClock.load() + frames,
+                        activeCommand.captureFrames);
+    }
+}
+
+void BatchEngine::postEngineEvent(EngineEvent::Type type, int fileIndex, juce::int64 samplePosition, juce::int64 value)
+{
+    EngineEvent event;
+    event.type = type;
+    event.sessionId = activeCommand.sessionId;
+    event.fileIndex = fileIndex;
+    event.samplePosition = samplePosition;
+    event.value = value;
+
+    // If the queue is full the message thread is badly behind; dropping is preferable to blocking
+    eventQueue.push(event);
+}
+
+//==============================================================================
+// Engine Messaging (Message Thread)
+
+void BatchEngine::sendEngineCommand(EngineCommand command)
+{
+    command.sessionId = engineSessionId;
+    command.issuedAtSample = engineSampleClock.load();
+
+    if (!commandQueue.push(command))
+        appState.appendLog("Error: Audio engine command queue full");
+}
+
+void BatchEngine::timerCallback()
+{
+    EngineEvent event;
+    while (eventQueue.pop(event))
+        handleEngineEvent(event);
+}
+
+void BatchEngine::handleEngineEvent(const EngineEvent& event)
+{
+    switch (event.type)
+    {
+        case EngineEvent::Type::fileFinished:
+        {
+            if (!appState.isProcessing || event.sessionId != engineSessionId)
+                break; // Stale event from a stopped batch
+
+            // The engine has already moved on to the prefetched file and the capture
+            // writer is finalising this one - just keep the loader fed
+            appState.recordingPosition = event.value;
+            appState.currentFileIndex = event.fileIndex + 1;
+            appState.markChanged(StateSection::progress);
+
+            if (oneTakeSession)
+            {
+                if (auto* segment = findOneTakeSegment(event.fileIndex))
+                    segment->capturedFrames = event.value;
+            }
+            else if (juce::isPositiveAndBelow(event.fileIndex, appState.files.size()))
+            {
+                // Its take may already have been written if the finaliser beat this event here
+                auto& file = appState.files.getReference(event.fileIndex);
+
+                if (file.status == ProcessingStatus::processing)
+                {
+                    file.status = ProcessingStatus::finalising;
+                    notifyFileStatusChanged(event.fileIndex);
+                }
+            }
+
+            filesInEngine = juce::jmax(0, filesInEngine - 1);
+            prefetchNextProcessingFile();
+            break;
+        }
+
+        case EngineEvent::Type::previewFileFinished:
+        {
+            if (!appState.isPreviewing || event.sessionId != engineSessionId)
+                break;
+
+            appState.currentPreviewFileIndex = event.fileIndex + 1;
+            appState.markChanged(StateSection::progress);
+            filesInEngine = juce::jmax(0, filesInEngine - 1);
+            prefetchNextPreviewFile();
+            break;
+        }
+
+        case EngineEvent::Type::segmentStarted:
+        {
+            if (!oneTakeSession || event.sessionId != engineSessionId)
+                break;
+
+            if (auto* segment = findOneTakeSegment(event.fileIndex))
+                segment->sendOffset = event.value;
+            break;
+        }
+
+        case EngineEvent::Type::playbackReleased:
+            playbackLoader.releaseBuffer(event.playbackBuffer);
+            break;
+
+        case EngineEvent::Type::latencyCaptureComplete:
+            // isMeasuringLatency stays set until the correlation is in
+            if (appState.isMeasuringLatency)
+                latencyMeasurement.analyseCapture();
+            break;
+
+        case EngineEvent::Type::impulseResponseCaptureComplete:
+            if (appState.isCapturingImpulseResponse)
+                completeImpulseResponseCapture();
+            break;
+
+        case EngineEvent::Type::routeCalibrationCaptureComplete:
+            // isCalibratingRoutes stays set until the correlation is in, but the device is free again
+            if (appState.isCalibratingRoutes)
+            {
+                routeCalibration.analyseCapture();
+                restoreSelectedChannels();
+                appState.appendLog("Calibration captured - decoding the route matrix...");
+            }
+            break;
+
+        case EngineEvent::Type::engineReset:
+            handleEngineReset(event.value != 0);
+            break;
+
+        case EngineEvent::Type::xrun:
+            appState.appendLog("Warning: Audio dropout detected (" + juce::String(event.value) + " total)" +
+                               (appState.isProcessing ? " while processing file " + juce::String(event.fileIndex + 1) : juce::String()));
+            break;
+    }
+}
+
+void BatchEngine::handleEngineReset(bool operationInterrupted)
+{
+    // A batch or preview through the device can't carry on: its captures are gone and the rate may have
+    // changed. The measurements reopen the device around their own capture, so only a cut-short one counts
+    const bool deviceSessionRunning = (appState.isProcessing && !offlineSession) || appState.isPreviewing;
+    const bool measurementInterrupted = operationInterrupted
+        && (appState.isMeasuringLatency || appState.isTestingHardware || appState.isCapturingImpulseResponse || appState.isCalibratingRoutes);
+
+    if (!deviceSessionRunning && !measurementInterrupted)
+        return;
+
+    appState.appendLog("Error: The audio device restarted - stopping the running operation");
+
+    // Takes that were lost report as failed through handleTakeFinished
+    stopAllAudio();
+}
+
+//==============================================================================
+// Device Management
+
+void BatchEngine::refreshDevices()
+{
+    // Probing happens on the prober's thread - until it reports, the list is last session's
+    deviceProber.rescan();
+    populateDeviceList();
+
+    appState.appendLog("Scanning audio devices...");
+}
+
+bool BatchEngine::waitForDeviceScan(int timeoutMs)
+{
+    return deviceProber.waitForScan(timeoutMs);
+}
+
+void BatchEngine::handleDevicesChanged(bool scanFinished)
+{
+    populateDeviceList();
+
+    if (scanFinished)
+        appState.appendLog("Found " + juce::String(appState.devices.size()) + " external audio devices");
+}
+
+void BatchEngine::selectDevice(const juce::String& deviceID)
+{
+    appState.selectedDeviceID = deviceID;
+
+    // Auto-select first input and output pairs
+    auto inputPairs = appState.getAvailableInputPairs();
+    auto outputPairs = appState.getAvailableOutputPairs();
+
+    if (!inputPairs.isEmpty())
+    {
+        appState.selectedInputPair = inputPairs[0];
+        appState.hasInputPair = true;
+        appState.appendLog("Auto-selected input: " + inputPairs[0].getDisplayName());
+    }
+    else
+    {
+        appState.hasInputPair = false;
+    }
+
+    if (!outputPairs.isEmpty())
+    {
+        appState.selectedOutputPair = outputPairs[0];
+        appState.hasOutputPair = true;
+        appState.appendLog("Auto-selected output: " + outputPairs[0].getDisplayName());
+    }
+    else
+    {
+        appState.hasOutputPair = false;
+    }
+
+    appState.markChanged(StateSection::devices);
+    configureAudioDevice();
+}
+
+void BatchEngine::selectInputPair(const StereoPair& pair)
+{
+    appState.selectedInputPair = pair;
+    appState.hasInputPair = true;
+    appState.markChanged(StateSection::devices);
+    appState.appendLog("Selected input: " + pair.getDisplayName());
+    configureAudioDevice();
+}
+
+void BatchEngine::selectOutputPair(const StereoPair& pair)
+{
+    appState.selectedOutputPair = pair;
+    appState.hasOutputPair = true;
+    appState.markChanged(StateSection::devices);
+    appState.appendLog("Selected output: " + pair.getDisplayName());
+    configureAudioDevice();
+}
+
+void BatchEngine::populateDeviceList()
+{
+    appState.devices.clear();
+
+    auto addIfExternal = [this](const AudioDevice& device)
+    {
+        // Filter out built-in devices
+        if (!device.isBuiltIn())
+            appState.devices.add(device);
+    };
+
+    for (const auto& device : deviceProber.getDevices())
+        addIfExternal(device);
+
+    // The loopback type lives in the device manager only - it costs nothing to probe, so it is done here
+    loopbackDeviceType->scanForDevices();
+
+    for (const auto& name : loopbackDeviceType->getDeviceNames(false))
+        addIfExternal(DeviceProber::probeDevice(*loopbackDeviceType, name));
+
+    appState.markChanged(StateSection::devices);
+}
+
+void BatchEngine::configureAudioDevice()
+{
+    // Configure the selected device
+    if (appState.selectedDeviceID.isEmpty())
+    {
+        appState.appendLog("Warning: No device selected");
+        return;
+    }
+
+    // Find the selected device to get its type name
+    AudioDevice* selectedDevice = appState.getSelectedDevice();
+    if (selectedDevice == nullptr)
+    {
+        appState.appendLog("Error: Selected device not found");
+        return;
+    }
+
+    // A running batch or preview cannot survive the device restart
+    if (appState.isProcessing || appState.isPreviewing || appState.isMeasuringLatency || appState.isTestingHardware
+        || appState.isCapturingImpulseResponse || appState.isCalibratingRoutes)
+        stopAllAudio();
+
+    // CRITICAL: Set the device type FIRST, before calling setAudioDeviceSetup
+    // This ensures we're targeting the correct CoreAudio device type
+    deviceManager.setCurrentAudioDeviceType(selectedDevice->deviceTypeName, true);
+    appState.appendLog("Set device type: " + selectedDevice->deviceTypeName);
+
+    // Get current setup and modify it (don't create from scratch)
+    juce::AudioDeviceManager::AudioDeviceSetup setup;
+    deviceManager.getAudioDeviceSetup(setup);
+
+    // Update setup with our selected device and settings
+    setup.outputDeviceName = selectedDevice->name;
+    setup.inputDeviceName = selectedDevice->name;
+    setup.sampleRate = appState.settings.sampleRate;
+    setup.bufferSize = static_cast<int>(appState.settings.bufferSize);
+
+    // Don't use default channels - we set specific ones
+    setup.useDefaultInputChannels = false;
+    setup.useDefaultOutputChannels = false;
+
+    setup.inputChannels.clear();
+    setup.outputChannels.clear();
+
+    auto setStereoBits = [](juce::BigInteger& bitset, const StereoPair& pair)
+    {
+        // Channels are 1-indexed in UI, but 0-indexed in JUCE
+        bitset.setBit(juce::jmax(0, pair.leftChannel - 1));
+        bitset.setBit(juce::jmax(0, pair.rightChannel - 1));
+    };
+
+    // Set the specific input and output channels we want
+    if (appState.hasInputPair)
+    {
+        setStereoBits(setup.inputChannels, appState.selectedInputPair);
+        appState.appendLog("Input channels: " + juce::String(appState.selectedInputPair.leftChannel) +
+                         ", " + juce::String(appState.selectedInputPair.rightChannel));
+    }
+
+    if (appState.hasOutputPair)
+    {
+        setStereoBits(setup.outputChannels, appState.selectedOutputPair);
+        appState.appendLog("Output channels: " + juce::String(appState.selectedOutputPair.leftChannel) +
+                         ", " + juce::String(appState.selectedOutputPair.rightChannel));
+    }
+
+    // Apply the setup - this will reconfigure the already-running audio system
+    juce::String error = deviceManager.setAudioDeviceSetup(setup, true);
+
+    if (error.isNotEmpty())
+    {
+        appState.appendLog("Error configuring device: " + error);
+        return;
+    }
+
+    // Verify the device was opened correctly
+    auto* device = deviceManager.getCurrentAudioDevice();
+    if (device == nullptr)
+    {
+        appState.appendLog("Error: Device failed to open");
+        return;
+    }
+
+    // CRITICAL: Update appState to match ACTUAL device settings
+    // The device may not support the requested sample rate and will open at its preferred rate
+    double actualSampleRate = device->getCurrentSampleRate();
+    int actualBufferSize = device->getCurrentBufferSizeSamples();
+
+    appState.settings.sampleRate = actualSampleRate;
+    appState.settings.bufferSize = static_cast<BufferSize>(actualBufferSize);
+
+    // Log success with actual device info
+    appState.appendLog("Device configured: " + device->getName());
+    appState.appendLog("Device type: " + selectedDevice->deviceTypeName);
+    appState.appendLog("Sample rate: " + juce::String(actualSampleRate) + " Hz");
+    appState.appendLog("Buffer size: " + juce::String(actualBufferSize) + " samples");
+
+    // Invalidate latency measurement if sample rate or buffer changed - unless this setup was measured before
+    appState.settings.invalidateLatency();
+    appState.settings.hasNoiseFloorMeasurement = false;
+    restoreLatencyProfile();
+    appState.markChanged(StateSection::settings);
+
+    // Apply device setup
+    juce::String error2 = deviceManager.setAudioDeviceSetup(setup, true);
+
+    if (!error2.isEmpty())
+    {
+        appState.appendLog("Error applying device setup: " + error2);
+    }
+    else
+    {
+        appState.appendLog("Device configured successfully");
+    }
+}
+
+//==============================================================================
+// File Management
+
+void BatchEngine::addFiles(const juce::Array<juce::File>& files)
+{
+    const int firstIndex = appState.files.size();
+
+    for (const auto& file : files)
+        addFile(AudioFile(file, metadataIndex.getMetadata(file)));
+
+    logFilesAdded(firstIndex);
+
+    metadataIndex.save();
+}
+
+void BatchEngine::ingestFiles(const juce::Array<juce::File>& filesOrFolders)
+{
+    fileIngester.addPaths(filesOrFolders);
+    appState.filesBeingAdded = fileIngester.getNumPending();
+    appState.markChanged(StateSection::files);
+}
+
+void BatchEngine::addFile(const AudioFile& audioFile)
+{
+    appState.files.add(audioFile);
+    appState.markChanged(StateSection::files);
+
+    if (!audioFile.needsConversion(appState.settings.sampleRate) && !audioFile.isValid())
+        appState.appendLog("Warning: Invalid sample rate - " + audioFile.getFileName());
+}
+
+void BatchEngine::logFilesAdded(int firstIndex)
+{
+    // One line per delivery - a dropped folder can bring thousands of files in one pass
+    int numAdded = 0;
+    int numConverted = 0;
+
+    for (int i = firstIndex; i < appState.files.size(); ++i)
+    {
+        const AudioFile& file = appState.files.getReference(i);
+
+        if (file.needsConversion(appState.settings.sampleRate))
+            ++numConverted;
+        else if (!file.isValid())
+            continue;
+
+        ++numAdded;
+    }
+
+    if (numAdded == 0)
+        return;
+
+    juce::String line = "Added " + juce::String(numAdded) + (numAdded == 1 ? " file" : " files");
+
+    if (numConverted > 0)
+        line += " (" + juce::String(numConverted) + " converted to " +
+                juce::String(appState.settings.sampleRate / 1000.0, 1) + " kHz on load)";
+
+    appState.appendLog(line);
+}
+
+void BatchEngine::handleFilesProbed(const juce::Array<FileIngester::Result>& results)
+{
+    const int firstIndex = appState.files.size();
+
+    for (const auto& result : results)
+        addFile(AudioFile(result.file, result.metadata));
+
+    logFilesAdded(firstIndex);
+
+    appState.filesBeingAdded = fileIngester.getNumPending();
+    appState.markChanged(StateSection::files);
+
+    if (appState.filesBeingAdded == 0 && !fileIngester.isBusy())
+        metadataIndex.save();
+}
+
+void BatchEngine::clearFiles()
+{
+    fileIngester.cancel();
+    appState.filesBeingAdded = 0;
+
+    appState.files.clear();
+    appState.markChanged(StateSection::files);
+    appState.appendLog("File list cleared");
+}
+
+void BatchEngine::toggleFileSelection(int fileIndex)
+{
+    if (juce::isPositiveAndBelow(fileIndex, appState.files.size()))
+    {
+        appState.files.getReference(fileIndex).isSelected =
+            !appState.files.getReference(fileIndex).isSelected;
+        appState.markChanged(StateSection::files);
+    }
+}
+
+void BatchEngine::setFileSelection(const juce::SparseSet<int>& selectedIndices)
+{
+    for (int i = 0; i < appState.files.size(); ++i)
+        appState.files.getReference(i).isSelected = selectedIndices.contains(i);
+
+    appState.markChanged(StateSection::files);
+}
+
+void BatchEngine::sortFiles(FileSortKey key, bool ascending)
+{
+    if (appState.isProcessing || appState.isPreviewing)
+    {
+        appState.appendLog("Warning: Files can't be reordered while processing or previewing");
+        return;
+    }
+
+    struct FileComparator
+    {
+        FileSortKey key;
+        bool ascending;
+
+        int compareElements(const AudioFile& a, const AudioFile& b) const
+        {
+            int result = 0;
+
+            switch (key)
+            {
+                case FileSortKey::name:       result = a.getFileName().compareNatural(b.getFileName()); break;
+                case FileSortKey::status:     result = (int)a.status - (int)b.status; break;
+                case FileSortKey::sampleRate: result = a.sampleRate < b.sampleRate ? -1 : (a.sampleRate > b.sampleRate ? 1 : 0); break;
+                case FileSortKey::duration:   result = a.durationSamples < b.durationSamples ? -1 : (a.durationSamples > b.durationSamples ? 1 : 0); break;
+            }
+
+            return ascending ? result : -result;
+        }
+    };
+
+    // Stable, so equal keys keep their current order
+    FileComparator comparator { key, ascending };
+    appState.files.sort(comparator, true);
+    appState.markChanged(StateSection::files);
+}
+
+//==============================================================================
+// Processing Operations
+
+void BatchEngine::startProcessing()
+{
+    // A preview is stopped below; anything else would be abandoned by the engine without ever reporting back
+    if (appState.isProcessing || appState.isMeasuringLatency || appState.isTestingHardware
+        || appState.isCapturingImpulseResponse || appState.isCalibratingRoutes)
+    {
+        appState.appendLog("Error: Stop the current operation first");
+        return;
+    }
+
+    const bool offline = appState.settings.useOfflinePluginRender || appState.settings.useImpulseResponseRender;
+
+    if (!offline && !appState.canMeasureLatency())
+    {
+        appState.appendLog("Error: Please select input and output devices first");
+        return;
+    }
+
+    if (!offline && appState.settings.measuredLatencyFrames < 0)
+    {
+        appState.appendLog("Error: Latency not measured - please measure latency first");
+        return;
+    }
+
+    if (appState.settings.useImpulseResponseRender)
+    {
+        if (appState.chainImpulseResponse.getNumSamples() == 0)
+        {
+            appState.appendLog("Error: No impulse response captured - please capture one first");
+            return;
+        }
+
+        if (appState.chainImpulseResponseSampleRate != appState.settings.sampleRate)
+        {
+            appState.appendLog("Error: Impulse response was captured at a different sample rate - please capture it again");
+            return;
+        }
+    }
+    else if (offline && appState.settings.offlinePluginPath.isEmpty())
+    {
+        appState.appendLog("Error: No plugin selected for offline render");
+        return;
+    }
+
+    if (appState.files.isEmpty())
+    {
+        appState.appendLog("Error: No files to process");
+        return;
+    }
+
+    if (appState.settings.outputFolderPath.isEmpty())
+    {
+        appState.appendLog("Error: No output folder selected");
+        return;
+    }
+
+    if (appState.isPreviewing)
+        stopPreview();
+
+    if (offline)
+    {
+        beginOfflineRender();
+        return;
+    }
+
+    // Start processing
+    beginEngineSession();
+    appState.currentFileIndex = 0;
+    appState.isProcessing = true;
+    appState.markChanged(StateSection::progress);
+    outstandingTakes = 0;
+    offlineSession = false;
+
+    oneTakeSession = appState.settings.useOneTakeMode;
+    if (oneTakeSession)
+        beginOneTakeRender();
+
+    appState.appendLog("Starting " + juce::String(oneTakeSession ? "one-take " : "") + "batch processing of " +
+                     juce::String(appState.files.size()) + " files");
+
+    // Fill both playback buffers: the first file plays while the second decodes
+    prefetchNextProcessingFile();
+    prefetchNextProcessingFile();
+}
+
+void BatchEngine::stopAllAudio()
+{
+    EngineCommand command;
+    command.type = EngineCommand::Type::stop;
+    sendEngineCommand(command);
+    playbackLoader.cancelPendingLoads();
+    takeSplitter.cancelPendingJobs();
+    offlineRenderer.cancel();
+    latencyMeasurement.cancel();
+    routeCalibration.cancel();
+
+    const bool wasCalibratingRoutes = appState.isCalibratingRoutes;
+
+    appState.isProcessing = false;
+    appState.isPreviewing = false;
+    appState.isMeasuringLatency = false;
+    appState.isTestingHardware = false;
+    appState.isCapturingImpulseResponse = false;
+    appState.isCalibratingRoutes = false;
+    appState.markChanged(StateSection::progress);
+
+    // The calibration may have left the device open on every channel
+    if (wasCalibratingRoutes)
+        restoreSelectedChannels();
+
+    appState.appendLog("Stopped");
+}
+
+void BatchEngine::startLatencyMeasurement()
+{
+    if (!appState.canMeasureLatency())
+    {
+        appState.appendLog("Error: Please select input and output devices first");
+        return;
+    }
+
+    if (appState.isProcessing || appState.isPreviewing || appState.isMeasuringLatency || appState.isTestingHardware
+        || appState.isCapturingImpulseResponse || appState.isCalibratingRoutes)
+    {
+        appState.appendLog("Error: Stop the current operation first");
+        return;
+    }
+
+    latencyMeasurement.prepare(appState.settings.sampleRate);
+    auto& capture = latencyMeasurement.getCapture();
+
+    appState.isMeasuringLatency = true;
+    appState.markChanged(StateSection::progress);
+
+    EngineCommand command;
+    command.type = EngineCommand::Type::startLatencyMeasurement;
+    command.playbackBuffer = &latencyMeasurement.getStimulus();
+    command.captureBuffer = &capture;
+    command.captureFrames = capture.getNumSamples();
+    sendEngineCommand(command);
+
+    appState.appendLog("Measuring latency (" + juce::String(capture.getNumSamples() / appState.settings.sampleRate, 2) + " s)...");
+}
+
+void BatchEngine::startImpulseResponseCapture()
+{
+    if (!appState.canMeasureLatency())
+    {
+        appState.appendLog("Error: Please select input and output devices first");
+        return;
+    }
+
+    if (appState.settings.measuredLatencyFrames < 0)
+    {
+        appState.appendLog("Error: Latency not measured - please measure latency first");
+        return;
+    }
+
+    if (appState.isProcessing || appState.isPreviewing || appState.isMeasuringLatency || appState.isTestingHardware
+        || appState.isCapturingImpulseResponse || appState.isCalibratingRoutes)
+    {
+        appState.appendLog("Error: Stop the current operation first");
+        return;
+    }
+
+    const auto& settings = appState.settings;
+    const int latencyFrames = settings.getLatencyFrames();
+
+    sweepMeasurement = std::make_unique<SweepMeasurement>(settings.sampleRate, settings.impulseSweepSeconds,
+                                                          settings.impulseResponseSeconds, latencyFrames);
+    impulseStimulusBuffer.makeCopyOf(sweepMeasurement->getStimulus());
+    impulseCaptureBuffer.setSize(2, sweepMeasurement->getCaptureFrames());
+    impulseCaptureBuffer.clear();
+
+    appState.isCapturingImpulseResponse = true;
+    appState.markChanged(StateSection::progress);
+
+    EngineCommand command;
+    command.type = EngineCommand::Type::startImpulseResponseCapture;
+    command.playbackBuffer = &impulseStimulusBuffer;
+    command.captureBuffer = &impulseCaptureBuffer;
+    command.captureFrames = impulseCaptureBuffer.getNumSamples();
+    sendEngineCommand(command);
+
+    appState.appendLog("Capturing impulse response (" +
+                       juce::String(impulseCaptureBuffer.getNumSamples() / settings.sampleRate, 1) + " s)...");
+}
+
+void BatchEngine::startRouteCalibration()
+{
+    const AudioDevice* selectedDevice = appState.getSelectedDevice();
+
+    if (selectedDevice == nullptr || deviceManager.getCurrentAudioDevice() == nullptr)
+    {
+        appState.appendLog("Error: Please select an audio device first");
+        return;
+    }
+
+    if (appState.isProcessing || appState.isPreviewing || appState.isMeasuringLatency || appState.isTestingHardware
+        || appState.isCapturingImpulseResponse || appState.isCalibratingRoutes)
+    {
+        appState.appendLog("Error: Stop the current operation first");
+        return;
+    }
+
+    const int numOutputPairs = selectedDevice->outputChannelCount / 2;
+    const int numInputs = selectedDevice->inputChannelCount;
+
+    if (numOutputPairs == 0 || numInputs == 0)
+    {
+        appState.appendLog("Error: The device needs an output pair and an input to calibrate");
+        return;
+    }
+
+    // The monitors stay silent: stereo out while it's blocked, and the pairs holding a monitoring channel
+    juce::uint64 silentOutputPairs = 0;
+    juce::StringArray silentOutputs;
+
+    for (int pair = 0; pair < juce::jmin(numOutputPairs, 64); ++pair)
+    {
+        const int left = pair * 2 + 1;
+        const int right = left + 1;
+
+        if ((pair == 0 && appState.settings.blockStereoOut)
+            || appState.settings.monitoringChannels.contains(left) || appState.settings.monitoringChannels.contains(right))
+        {
+            silentOutputPairs |= (juce::uint64)1 << pair;
+            silentOutputs.add(juce::String(left) + "-" + juce::String(right));
+        }
+    }
+
+    if (silentOutputs.size() == numOutputPairs)
+    {
+        appState.appendLog("Error: Every output pair is a monitor output - nothing to calibrate");
+        return;
+    }
+
+    if (!routeCalibration.prepare(appState.settings.sampleRate, numOutputPairs, numInputs))
+    {
+        appState.appendLog("Error: Too many output pairs to calibrate in one pass at " + juce::String(appState.settings.sampleRate) + " Hz");
+        return;
+    }
+
+    // Every channel for the length of the calibration - reopening the device restarts the engine from idle
+    juce::BigInteger inputChannels, outputChannels;
+    inputChannels.setRange(0, numInputs, true);
+    outputChannels.setRange(0, numOutputPairs * 2, true);
+
+    if (!setDeviceChannels(inputChannels, outputChannels))
+    {
+        restoreSelectedChannels();
+        return;
+    }
+
+    auto& capture = routeCalibration.getCapture();
+
+    appState.isCalibratingRoutes = true;
+    appState.markChanged(StateSection::progress);
+
+    EngineCommand command;
+    command.type = EngineCommand::Type::startRouteCalibration;
+    command.playbackBuffer = &routeCalibration.getSequence();
+    command.captureBuffer = &capture;
+    command.captureFrames = capture.getNumSamples();
+    command.codeSpacingFrames = routeCalibration.getSlotFrames();
+    command.prefixFrames = routeCalibration.getPrefixFrames();
+    command.silentOutputPairs = silentOutputPairs;
+
+    if (!silentOutputs.isEmpty())
+        appState.appendLog("Route calibration: leaving monitor outputs " + silentOutputs.joinIntoString(", ") + " silent");
+
+    sendEngineCommand(command);
+
+    appState.appendLog("Calibrating " + juce::String(numOutputPairs - silentOutputs.size()) + " output pairs x " + juce::String(numInputs) + " inputs ("
+                       + juce::String((command.prefixFrames + command.captureFrames) / appState.settings.sampleRate, 1) + " s)...");
+}
+
+void BatchEngine::startPreview()
+{
+    // A new session would orphan a running batch's events and queue the preview behind its current file
+    if (appState.isProcessing || appState.isMeasuringLatency || appState.isTestingHardware
+        || appState.isCapturingImpulseResponse || appState.isCalibratingRoutes)
+    {
+        appState.appendLog("Error: Stop the current operation first");
+        return;
+    }
+
+    // Build playlist from selected files
+    appState.previewPlaylist.clear();
+    for (const auto& file : appState.files)
+    {
+        if (file.isSelected && file.isValid())
+        {
+            appState.previewPlaylist.add(file.id);
+        }
+    }
+
+    if (appState.previewPlaylist.isEmpty())
+    {
+        appState.appendLog("Error: No files selected for preview");
+        return;
+    }
+
+    beginEngineSession();
+    appState.currentPreviewFileIndex = 0;
+    appState.isPreviewing = true;
+    appState.markChanged(StateSection::progress);
+    appState.appendLog("Preview started with " + juce::String(appState.previewPlaylist.size()) + " files");
+
+    prefetchNextPreviewFile();
+    prefetchNextPreviewFile();
+}
+
+void BatchEngine::stopPreview()
+{
+    EngineCommand command;
+    command.type = EngineCommand::Type::stop;
+    sendEngineCommand(command);
+    playbackLoader.cancelPendingLoads();
+
+    appState.isPreviewing = false;
+    appState.previewPlaylist.clear();
+    appState.currentPreviewFileIndex = -1;
+    appState.markChanged(StateSection::progress);
+    appState.appendLog("Preview stopped");
+}
+
+void BatchEngine::startHardwareTest()
+{
+    if (appState.isProcessing || appState.isPreviewing || appState.isMeasuringLatency || appState.isTestingHardware
+        || appState.isCapturingImpulseResponse || appState.isCalibratingRoutes)
+    {
+        appState.appendLog("Error: Stop the current operation first");
+        return;
+    }
+
+    if (!appState.canMeasureLatency())
+    {
+        appState.appendLog("Error: Please select input and output devices first");
+        return;
+    }
+
+    EngineCommand command;
+    command.type = EngineCommand::Type::startHardwareTest;
+    sendEngineCommand(command);
+
+    appState.isTestingHardware = true;
+    appState.markChanged(StateSection::progress);
+    appState.appendLog("Hardware loop test started (1 kHz sine wave)");
+}
+
+void BatchEngine::stopHardwareTest()
+{
+    EngineCommand command;
+    command.type = EngineCommand::Type::stop;
+    sendEngineCommand(command);
+
+    appState.isTestingHardware = false;
+    appState.markChanged(StateSection::progress);
+    appState.appendLog("Hardware loop test stopped");
+}
+
+//==============================================================================
+// File Processing Helpers
+
+void BatchEngine::beginEngineSession()
+{
+    // Anything still in flight from an earlier batch/preview is ignored from here on
+    ++engineSessionId;
+    playbackLoader.cancelPendingLoads();
+    playbackLoader.setConversion(appState.settings.sampleRate, appState.settings.resampleQuality);
+    nextFileToLoad = 0;
+    loadsInFlight = 0;
+    filesInEngine = 0;
+    filesSentThisSession = 0;
+}
+
+void BatchEngine::prefetchNextProcessingFile()
+{
+    while (juce::isPositiveAndBelow(nextFileToLoad, appState.files.size()))
+    {
+        const int fileIndex = nextFileToLoad++;
+        const AudioFile& file = appState.files.getReference(fileIndex);
+
+        if (!file.isValid())
+        {
+            appState.appendLog("Skipping invalid file: " + file.getFileName());
+            continue;
+        }
+
+        ++loadsInFlight;
+        playbackLoader.requestLoad(PlaybackLoader::Purpose::processing, fileIndex, file.url);
+        return;
+    }
+
+    closeOneTakeIfAllSent();
+    finishBatchIfComplete();
+}
+
+void BatchEngine::prefetchNextPreviewFile()
+{
+    while (juce::isPositiveAndBelow(nextFileToLoad, appState.previewPlaylist.size()))
+    {
+        const int playlistIndex = nextFileToLoad++;
+
+        // Find file by ID
+        for (const auto& file : appState.files)
+        {
+            if (file.id == appState.previewPlaylist[playlistIndex])
+            {
+                ++loadsInFlight;
+                playbackLoader.requestLoad(PlaybackLoader::Purpose::preview, playlistIndex, file.url);
+                return;
+            }
+        }
+    }
+
+    finishPreviewIfComplete();
+}
+
+void BatchEngine::handleFileLoaded(const PlaybackLoader::Result& result)
+{
+    const bool isProcessingLoad = result.request.purpose == PlaybackLoader::Purpose::processing;
+
+    // Loads from a cancelled session are dropped by the loader, but guard anyway
+    if ((isProcessingLoad && !appState.isProcessing) || (!isProcessingLoad && !appState.isPreviewing))
+    {
+        playbackLoader.releaseBuffer(result.buffer);
+        return;
+    }
+
+    loadsInFlight = juce::jmax(0, loadsInFlight - 1);
+
+    if (!result.succeeded)
+    {
+        appState.appendLog("Error: " + result.errorMessage);
+
+        if (isProcessingLoad)
+        {
+            if (juce::isPositiveAndBelow(result.request.index, appState.files.size()))
+            {
+                appState.files.getReference(result.request.index).status = ProcessingStatus::failed;
+                notifyFileStatusChanged(result.request.index);
+            }
+
+            prefetchNextProcessingFile();
+        }
+        else
+        {
+            prefetchNextPreviewFile();
+        }
+        return;
+    }
+
+    if (!result.converted)
+        metadataIndex.storeAnalysis(result.request.file, result.peak, result.rms, result.contentHash);
+
+    const int sourceFrames = result.buffer->getNumSamples();
+    const auto& settings = appState.settings;
+
+    EngineCommand command;
+    command.fileIndex = result.request.index;
+    command.playbackBuffer = result.buffer;
+    command.playbackFrames = sourceFrames;
+    command.gapFrames = (juce::int64)(settings.silenceBetweenFilesMs * settings.sampleRate / 1000.0);
+    command.preRollFrames = filesSentThisSession == 0 ? command.gapFrames : 0;
+    command.queueAfterCurrent = true;
+
+    if (isProcessingLoad)
+    {
+        AudioFile& file = appState.files.getReference(result.request.index);
+        file.status = ProcessingStatus::processing;
+        notifyFileStatusChanged(result.request.index);
+        appState.currentProcessingFile = file.getFileName();
+        appState.markChanged(StateSection::progress);
+        appState.appendLog("Processing: " + file.getFileName());
+
+        const int latencyFrames = settings.getLatencyFrames();
+        const auto reverbLimitFrames = (juce::int64)sourceFrames + latencyFrames +
+                                       (juce::int64)(settings.maxReverbTailSeconds * settings.sampleRate);
+
+        command.type = EngineCommand::Type::startProcessingFile;
+        command.stopOnNoiseFloor = settings.useReverbMode;
+
+        if (oneTakeSession)
+        {
+            // Sent back to back - the guard after each file is the only silence in the stream
+            command.takeId = queueOneTakeSegment(result.request.index, sourceFrames);
+            command.continuousTake = true;
+            command.gapFrames = 0;
+            command.captureFrames = settings.useReverbMode ? reverbLimitFrames
+                                                           : (juce::int64)sourceFrames + settings.getOneTakeGuardFrames(latencyFrames);
+        }
+        else
+        {
+            command.takeId = queueCaptureForFile(result.request.index, sourceFrames);
+            command.captureFrames = settings.useReverbMode ? reverbLimitFrames
+                                                           : (juce::int64)settings.getRecordingLength(sourceFrames, latencyFrames);
+        }
+        command.noiseFloorThresholdDb = settings.getNoiseFloorThresholdDb();
+    }
+    else
+    {
+        command.type = EngineCommand::Type::startPreviewFile;
+    }
+
+    ++filesInEngine;
+    ++filesSentThisSession;
+    sendEngineCommand(command);
+
+    if (isProcessingLoad)
+        closeOneTakeIfAllSent();
+}
+
+void BatchEngine::finishBatchIfComplete()
+{
+    if (!appState.isProcessing || nextFileToLoad < appState.files.size()
+        || loadsInFlight > 0 || filesInEngine > 0 || outstandingTakes > 0)
+        return;
+
+    // All files captured and written
+    appState.isProcessing = false;
+    appState.appendLog("Batch processing complete");
+    appState.currentFileIndex = 0;
+    appState.processingProgress = 0.0;
+    appState.markChanged(StateSection::progress);
+
+    // Keep the peak/RMS/hash measured while loading
+    metadataIndex.save();
+
+    if (onBatchFinished)
+        onBatchFinished();
+}
+
+void BatchEngine::finishPreviewIfComplete()
+{
+    if (!appState.isPreviewing || nextFileToLoad < appState.previewPlaylist.size()
+        || loadsInFlight > 0 || filesInEngine > 0)
+        return;
+
+    // Preview finished
+    appState.isPreviewing = false;
+    appState.currentPreviewFileIndex = -1;
+    appState.markChanged(StateSection::progress);
+    appState.appendLog("Preview complete");
+}
+
+void BatchEngine::completeLatencyMeasurement(const LatencyMeasurement::Result& result)
+{
+    // Stopped while the correlation was running
+    if (!appState.isMeasuringLatency)
+        return;
+
+    appState.isMeasuringLatency = false;
+    appState.markChanged(StateSection::progress);
+
+    const juce::String peakToSidelobe = juce::String(result.peakToSidelobeDb, 1) + " dB";
+
+    if (result.succeeded)
+    {
+        // Whole frames common to both returns, the rest per return
+        appState.settings.measuredLatencyFrames = result.latencyFrames;
+        appState.settings.measuredChannelLatencyFrames = result.channelLatencyFrames;
+        appState.settings.lastBufferSizeWhenMeasured = appState.settings.bufferSize;
+        appState.settings.measuredNoiseFloorDb = result.noiseFloorDb;
+        appState.settings.hasNoiseFloorMeasurement = true;
+
+        appState.appendLog("Latency measured: " + juce::String(result.latencyFrames) + " samples (" +
+                         juce::String(appState.settings.getLatencyInMs(), 2) + " ms) on return " +
+                         juce::String(result.returnChannel + 1) + ", correlation peak " + peakToSidelobe + " above sidelobes");
+        juce::StringArray channelLatencies;
+        for (auto latency : result.channelLatencyFrames)
+            channelLatencies.add(juce::String(latency, 2));
+
+        appState.appendLog("Return latencies: " + channelLatencies.joinIntoString(" / ") + " frames - aligned to a fraction of a frame");
+        appState.appendLog("Noise floor measured: " + juce::String(result.noiseFloorDb, 1) + " dB, chain gain " +
+                           juce::String(result.returnGainDb, 1) + " dB");
+
+        if (result.returnPeak >= 0.99f)
+            appState.appendLog("Warning: Return clipped during the measurement - check the chain's gain");
+
+        LatencyProfileStore::Key key;
+
+        if (getLatencyProfileKey(key))
+        {
+            const auto profile = latencyProfiles.store(key, appState.settings.measuredLatencyFrames, result.channelLatencyFrames,
+                                                       result.noiseFloorDb, result.confidence);
+            appState.appendLog("Latency profile saved - confidence " + juce::String(juce::roundToInt(profile.confidence * 100.0f)) + "%"
+                               + (profile.numMeasurements > 1 ? " (" + juce::String(profile.numMeasurements) + " agreeing measurements)" : juce::String()));
+        }
+    }
+    else
+    {
+        appState.appendLog("Error: Measurement sequence not found in the return (correlation peak only " + peakToSidelobe +
+                           " above sidelobes) - check the routing");
+    }
+
+    appState.markChanged(StateSection::settings);
+
+    if (onLatencyMeasured)
+        onLatencyMeasured(result.succeeded);
+}
+
+bool BatchEngine::getLatencyProfileKey(LatencyProfileStore::Key& key) const
+{
+    if (!appState.hasInputPair || !appState.hasOutputPair)
+        return false;
+
+    return getLatencyProfileKey(key, appState.selectedInputPair, appState.selectedOutputPair);
+}
+
+bool BatchEngine::getLatencyProfileKey(LatencyProfileStore::Key& key, const StereoPair& inputPair, const StereoPair& outputPair) const
+{
+    auto* device = deviceManager.getCurrentAudioDevice();
+
+    if (device == nullptr)
+        return false;
+
+    // The loopback round trip is whatever it was configured to be - nothing worth remembering
+    if (device->getTypeName() == VirtualLoopbackDeviceType::loopbackTypeName)
+        return false;
+
+    key.deviceTypeName = device->getTypeName();
+    key.deviceID = appState.selectedDeviceID;
+    key.sampleRate = device->getCurrentSampleRate();
+    key.bufferSize = device->getCurrentBufferSizeSamples();
+    key.inputLeft = inputPair.leftChannel;
+    key.inputRight = inputPair.rightChannel;
+    key.outputLeft = outputPair.leftChannel;
+    key.outputRight = outputPair.rightChannel;
+    return true;
+}
+
+void BatchEngine::restoreLatencyProfile()
+{
+    LatencyProfileStore::Key key;
+    LatencyProfileStore::Profile profile;
+
+    if (!getLatencyProfileKey(key) || !latencyProfiles.lookup(key, profile))
+        return;
+
+    const juce::String confidence = juce::String(juce::roundToInt(profile.confidence * 100.0f)) + "%";
+
+    if (profile.confidence < LatencyProfileStore::minimumRestoreConfidence)
+    {
+        appState.appendLog("Stored latency for this setup has low confidence (" + confidence + ") - please measure again");
+        return;
+    }
+
+    appState.settings.measuredLatencyFrames = profile.latencyFrames;
+    appState.settings.measuredChannelLatencyFrames = profile.channelLatencyFrames;
+    appState.settings.lastBufferSizeWhenMeasured = appState.settings.bufferSize;
+    appState.settings.measuredNoiseFloorDb = profile.noiseFloorDb;
+    appState.settings.hasNoiseFloorMeasurement = true;
+
+    appState.appendLog("Latency restored: " + juce::String(profile.latencyFrames) + " samples ("
+                       + juce::String(appState.settings.getLatencyInMs(), 2) + " ms), measured "
+                       + profile.measuredAt.formatted("%Y-%m-%d %H:%M") + " - confidence " + confidence);
+}
+
+void BatchEngine::completeRouteCalibration(const RouteCalibration::Result& result)
+{
+    if (!appState.isCalibratingRoutes)
+        return; // Stopped meanwhile
+
+    appState.isCalibratingRoutes = false;
+    appState.markChanged(StateSection::progress);
+
+    if (!result.succeeded)
+    {
+        appState.appendLog("Error: Route calibration capture could not be analysed");
+        return;
+    }
+
+    appState.appendLog("Route calibration: " + juce::String(result.routes.size()) + " connected routes between "
+                       + juce::String(result.numOutputPairs) + " output pairs and " + juce::String(result.numInputs) + " inputs");
+
+    if (result.returnPeak >= 0.99f)
+        appState.appendLog("Warning: An input clipped during the calibration - check the chains' gains");
+
+    auto findRoute = [&result](int outputPair, int input) -> const RouteCalibration::Route*
+    {
+        for (const auto& route : result.routes)
+            if (route.outputPair == outputPair && route.input == input)
+                return &route;
+
+        return nullptr;
+    };
+
+    const auto inputPairs = appState.getAvailableInputPairs();
+    const auto outputPairs = appState.getAvailableOutputPairs();
+    int numProfiles = 0;
+
+    for (int outputIndex = 0; outputIndex < juce::jmin(outputPairs.size(), result.numOutputPairs); ++outputIndex)
+    {
+        for (const auto& inputPair : inputPairs)
+        {
+            const auto* left = findRoute(outputIndex, inputPair.leftChannel - 1);
+            const auto* right = findRoute(outputIndex, inputPair.rightChannel - 1);
+
+            if (left == nullptr && right == nullptr)
+                continue;
+
+            // A return the pair doesn't reach on its own (one side of a mono chain) takes the other's latency, as in LatencyMeasurement
+            const auto& clearest = right == nullptr || (left != nullptr && left->peakToSidelobeDb >= right->peakToSidelobeDb) ? *left : *right;
+            juce::Array<double> channelLatencyFrames { (left != nullptr ? *left : clearest).latencyFrames,
+                                                       (right != nullptr ? *right : clearest).latencyFrames };
+            const int latencyFrames = juce::jmax(0, (int)std::floor(juce::jmin(channelLatencyFrames[0], channelLatencyFrames[1])));
+
+            // Both inputs' noise, in power
+            const float noiseFloorDb = 10.0f * std::log10(0.5f * (std::pow(10.0f, result.noiseFloorsDb[inputPair.leftChannel - 1] / 10.0f)
+                                                                  + std::pow(10.0f, result.noiseFloorsDb[inputPair.rightChannel - 1] / 10.0f)));
+
+            appState.appendLog("  Outputs " + juce::String(outputPairs[outputIndex].leftChannel) + "-" + juce::String(outputPairs[outputIndex].rightChannel)
+                               + " -> Inputs " + juce::String(inputPair.leftChannel) + "-" + juce::String(inputPair.rightChannel) + ": "
+                               + juce::String(channelLatencyFrames[0], 2) + " / " + juce::String(channelLatencyFrames[1], 2) + " frames, gain "
+                               + juce::String(clearest.gainDb, 1) + " dB, confidence " + juce::String(juce::roundToInt(clearest.confidence * 100.0f)) + "%");
+
+            LatencyProfileStore::Key key;
+
+            if (getLatencyProfileKey(key, inputPair, outputPairs[outputIndex]))
+            {
+                latencyProfiles.store(key, latencyFrames, channelLatencyFrames, noiseFloorDb, clearest.confidence);
+                ++numProfiles;
+            }
+        }
+    }
+
+    if (numProfiles > 0)
+        appState.appendLog("Latency profiles saved for " + juce::String(numProfiles) + " routes");
+
+    // The selected pairs pick up their new profile, if they were among them
+    restoreLatencyProfile();
+    appState.markChanged(StateSection::settings);
+}
+
+bool BatchEngine::setDeviceChannels(const juce::BigInteger& inputChannels, const juce::BigInteger& outputChannels)
+{
+    juce::AudioDeviceManager::AudioDeviceSetup setup;
+    deviceManager.getAudioDeviceSetup(setup);
+
+    setup.useDefaultInputChannels = false;
+    setup.useDefaultOutputChannels = false;
+    setup.inputChannels = inputChannels;
+    setup.outputChannels = outputChannels;
+
+    const juce::String error = deviceManager.setAudioDeviceSetup(setup, true);
+
+    if (error.isNotEmpty())
+    {
+        appState.appendLog("Error opening device channels: " + error);
+        return false;
+    }
+
+    return true;
+}
+
+void BatchEngine::restoreSelectedChannels()
+{
+    juce::BigInteger inputChannels, outputChannels;
+
+    // Channels are 1-indexed in UI, but 0-indexed in JUCE
+    if (appState.hasInputPair)
+    {
+        inputChannels.setBit(juce::jmax(0, appState.selectedInputPair.leftChannel - 1));
+        inputChannels.setBit(juce::jmax(0, appState.selectedInputPair.rightChannel - 1));
+    }
+
+    if (appState.hasOutputPair)
+    {
+        outputChannels.setBit(juce::jmax(0, appState.selectedOutputPair.leftChannel - 1));
+        outputChannels.setBit(juce::jmax(0, appState.selectedOutputPair.rightChannel - 1));
+    }
+
+    setDeviceChannels(inputChannels, outputChannels);
+}
+
+void BatchEngine::completeImpulseResponseCapture()
+{
+    appState.isCapturingImpulseResponse = false;
+    appState.markChanged(StateSection::progress);
+
+    const float returnPeak = impulseCaptureBuffer.getMagnitude(0, impulseCaptureBuffer.getNumSamples());
+    const bool succeeded = sweepMeasurement != nullptr && returnPeak > 0.001f;
+
+    if (succeeded)
+    {
+        appState.chainImpulseResponse = sweepMeasurement->extractImpulseResponses(impulseCaptureBuffer);
+        appState.chainImpulseResponseSampleRate = appState.settings.sampleRate;
+        appState.markChanged(StateSection::settings);
+
+        appState.appendLog("Impulse response captured: " +
+                           juce::String(appState.chainImpulseResponse.getNumSamples() / appState.chainImpulseResponseSampleRate, 1) +
+                           " s, return peak " + juce::String(juce::Decibels::gainToDecibels(returnPeak), 1) + " dBFS");
+
+        if (returnPeak >= 0.99f)
+            appState.appendLog("Warning: Return clipped during the sweep - the response will include distortion");
+    }
+    else
+    {
+        appState.appendLog("Error: No return signal during the sweep - check the routing");
+    }
+
+    sweepMeasurement.reset();
+    impulseStimulusBuffer.setSize(0, 0);
+    impulseCaptureBuffer.setSize(0, 0);
+
+    if (onImpulseResponseCaptured)
+        onImpulseResponseCaptured(succeeded);
+}
+
+void BatchEngine::notifyFileStatusChanged(int fileIndex)
+{
+    appState.markChanged(StateSection::files);
+
+    if (onFileStatusChanged)
+        onFileStatusChanged(fileIndex);
+}
+
+int BatchEngine::queueCaptureForFile(int fileIndex, int sourceFrames)
+{
+    const AudioFile& sourceFile = appState.files.getReference(fileIndex);
+    const auto& settings = appState.settings;
+
+    CaptureWriter::Take take;
+    take.sessionId = engineSessionId;
+    take.fileIndex = fileIndex;
+    take.outputFile = generateOutputFile(sourceFile);
+    take.sampleRate = settings.sampleRate;
+    take.outputSampleRate = getOutputSampleRate(sourceFile);
+    take.numChannels = 2;
+
+    // Whole frames common to both returns are skipped, each return's fraction beyond them is advanced away
+    take.skipFrames = settings.getLatencyFrames();
+    take.channelAdvanceFrames = settings.getChannelLatencyResiduals();
+
+    // Fixed-length mode keeps exactly the source length; reverb mode keeps the whole tail
+    take.outputFrames = settings.useReverbMode ? -1 : (juce::int64)sourceFrames;
+    take.processing = getOutputProcessing();
+
+    ++outstandingTakes;
+    return captureWriter.queueTake(take);
+}
+
+void BatchEngine::handleTakeFinished(const CaptureWriter::Result& result)
+{
+    // A take from a stopped batch may share its path with one this batch is writing - leave it be
+    if (result.sessionId != engineSessionId)
+        return;
+
+    if (!result.succeeded && result.outputFile != juce::File())
+        result.outputFile.deleteFile();
+
+    if (oneTakeId >= 0 && result.takeId == oneTakeId)
+    {
+        handleOneTakeWritten(result);
+        return;
+    }
+
+    outstandingTakes = juce::jmax(0, outstandingTakes - 1);
+
+    if (juce::isPositiveAndBelow(result.fileIndex, appState.files.size()))
+    {
+        appState.files.getReference(result.fileIndex).status = result.succeeded ? ProcessingStatus::completed
+                                                                                : ProcessingStatus::failed;
+        notifyFileStatusChanged(result.fileIndex);
+    }
+
+    if (result.succeeded)
+        appState.appendLog("Saved: " + result.outputFile.getFileName() + (result.dcOffsetSkipped ? dcOffsetSkippedNote : ""));
+    else
+        appState.appendLog("Error: " + result.errorMessage);
+
+    finishBatchIfComplete();
+}
+
+void BatchEngine::beginOneTakeRender()
+{
+    const auto& settings = appState.settings;
+    const juce::File outputFolder(settings.outputFolderPath);
+    const juce::String takeName = "OneTake_" + juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S");
+
+    oneTakeId = -1;
+    oneTakeCloseSent = false;
+
+    oneTakeJob = TakeSplitter::Job();
+    oneTakeJob.sessionId = engineSessionId;
+    oneTakeJob.takeFile = outputFolder.getChildFile(takeName + ".wav");
+    oneTakeJob.manifestFile = outputFolder.getChildFile(takeName + ".json");
+    oneTakeJob.sampleRate = settings.sampleRate;
+    oneTakeJob.latencyFrames = settings.getLatencyFrames();
+    oneTakeJob.channelAdvanceFrames = settings.getChannelLatencyResiduals();
+    oneTakeJob.keepTail = settings.useReverbMode;
+    oneTakeJob.processing = getOutputProcessing();
+}
+
+int BatchEngine::queueOneTakeSegment(int fileIndex, int sourceFrames)
+{
+    const AudioFile& sourceFile = appState.files.getReference(fileIndex);
+
+    // The take is registered with the first file, so a batch with nothing to send leaves no file behind
+    if (oneTakeId < 0)
+    {
+        CaptureWriter::Take take;
+        take.sessionId = engineSessionId;
+        take.outputFile = oneTakeJob.takeFile;
+        take.sampleRate = oneTakeJob.sampleRate;
+        take.numChannels = 2;
+        take.skipFrames = 0;          // Raw stream - latency and post-processing are applied per segment by the splitter
+        take.processing.removeDCOffset = false;
+        take.processing.dither = false;
+
+        ++outstandingTakes;
+        oneTakeId = captureWriter.queueTake(take);
+    }
+
+    TakeSplitter::Segment segment;
+    segment.fileIndex = fileIndex;
+    segment.sourceFile = sourceFile.url;
+    segment.outputFile = generateOutputFile(sourceFile);
+    segment.sourceFrames = sourceFrames;
+    segment.outputSampleRate = getOutputSampleRate(sourceFile);
+    oneTakeJob.segments.add(segment);
+
+    ++outstandingTakes;
+    return oneTakeId;
+}
+
+void BatchEngine::closeOneTakeIfAllSent()
+{
+    if (!oneTakeSession || oneTakeCloseSent || oneTakeId < 0
+        || nextFileToLoad < appState.files.size() || loadsInFlight > 0)
+        return;
+
+    // Armed behind the last file, so the take ends right after its guard
+    EngineCommand command;
+    command.type = EngineCommand::Type::closeTake;
+    command.queueAfterCurrent = true;
+    sendEngineCommand(command);
+
+    oneTakeCloseSent = true;
+}
+
+void BatchEngine::handleOneTakeWritten(const CaptureWriter::Result& result)
+{
+    oneTakeId = -1;
+    outstandingTakes = juce::jmax(0, outstandingTakes - 1);
+
+    if (!result.succeeded)
+    {
+        appState.appendLog("Error: " + result.errorMessage);
+
+        for (const auto& segment : oneTakeJob.segments)
+        {
+            if (juce::isPositiveAndBelow(segment.fileIndex, appState.files.size()))
+            {
+                appState.files.getReference(segment.fileIndex).status = ProcessingStatus::failed;
+                notifyFileStatusChanged(segment.fileIndex);
+            }
+        }
+
+        outstandingTakes = juce::jmax(0, outstandingTakes - oneTakeJob.segments.size());
+        finishBatchIfComplete();
+        return;
+    }
+
+    appState.appendLog("One-take capture saved: " + result.outputFile.getFileName() + " - splitting " +
+                       juce::String(oneTakeJob.segments.size()) + " files");
+    takeSplitter.splitTake(oneTakeJob);
+}
+
+void BatchEngine::handleSegmentSplit(const TakeSplitter::Result& result)
+{
+    if (result.sessionId != engineSessionId)
+        return; // Split job of a stopped batch, still running after cancelPendingJobs
+
+    if (result.jobWarning.isNotEmpty())
+        appState.appendLog("Warning: " + result.jobWarning);
+
+    outstandingTakes = juce::jmax(0, outstandingTakes - 1);
+
+    if (juce::isPositiveAndBelow(result.fileIndex, appState.files.size()))
+    {
+        appState.files.getReference(result.fileIndex).status = result.succeeded ? ProcessingStatus::completed
+                                                                                : ProcessingStatus::failed;
+        notifyFileStatusChanged(result.fileIndex);
+    }
+
+    if (result.succeeded)
+        appState.appendLog("Saved: " + result.outputFile.getFileName() + (result.dcOffsetSkipped ? dcOffsetSkippedNote : ""));
+    else
+        appState.appendLog("Error: " + result.errorMessage);
+
+    finishBatchIfComplete();
+}
+
+TakeSplitter::Segment* BatchEngine::findOneTakeSegment(int fileIndex)
+{
+    for (auto& segment : oneTakeJob.segments)
+    {
+        if (segment.fileIndex == fileIndex)
+            return &segment;
+    }
+
+    return nullptr;
+}
+
+void BatchEngine::beginOfflineRender()
+{
+    const auto& settings = appState.settings;
+
+    const bool throughImpulseResponse = settings.useImpulseResponseRender;
+
+    OfflineRenderer::Job job;
+    job.sampleRate = settings.sampleRate;
+    job.blockSize = throughImpulseResponse ? 1024 : 512;
+    job.numWorkers = settings.offlineRenderThreads;
+    job.preRollFrames = (juce::int64)(settings.silenceBetweenFilesMs * settings.sampleRate / 1000.0);
+    job.processing = getOutputProcessing();
+    job.keepTail = settings.useReverbMode;
+    job.maxTailFrames = throughImpulseResponse ? (juce::int64)appState.chainImpulseResponse.getNumSamples()
+                                               : (juce::int64)(settings.maxReverbTailSeconds * settings.sampleRate);
+    job.tailThresholdDb = settings.getNoiseFloorThresholdDb();
+
+    for (int i = 0; i < appState.files.size(); ++i)
+    {
+        const AudioFile& file = appState.files.getReference(i);
+
+        if (!file.isValid())
+        {
+            appState.appendLog("Skipping invalid file: " + file.getFileName());
+            continue;
+        }
+
+        job.items.add({ i, file.url, generateOutputFile(file), getOutputSampleRate(file) });
+    }
+
+    if (job.items.isEmpty())
+    {
+        appState.appendLog("Error: No valid files to render");
+        return;
+    }
+
+    // Nothing goes through the loader or the audio thread - only the renderer's results are awaited
+    beginEngineSession();
+    job.sessionId = engineSessionId;
+
+    const juce::String error = throughImpulseResponse
+                                 ? offlineRenderer.startConvolutionRender(appState.chainImpulseResponse, job)
+                                 : offlineRenderer.startPluginRender(settings.offlinePluginPath, job);
+
+    if (error.isNotEmpty())
+    {
+        appState.appendLog("Error: " + error);
+        return;
+    }
+
+    nextFileToLoad = appState.files.size();
+    outstandingTakes = job.items.size();
+    oneTakeSession = false;
+    offlineSession = true;
+    appState.currentFileIndex = 0;
+    appState.isProcessing = true;
+    appState.markChanged(StateSection::progress);
+
+    for (const auto& item : job.items)
+    {
+        appState.files.getReference(item.fileIndex).status = ProcessingStatus::processing;
+        notifyFileStatusChanged(item.fileIndex);
+    }
+
+    appState.appendLog("Starting offline render of " + juce::String(job.items.size()) + " files through " +
+                       offlineRenderer.getProcessorName() + " on " + juce::String(offlineRenderer.getNumWorkers()) + " threads");
+}
+
+void BatchEngine::handleOfflineFileRendered(const OfflineRenderer::Result& result)
+{
+    if (result.sessionId != engineSessionId)
+        return; // Rendered for a stopped batch
+
+    outstandingTakes = juce::jmax(0, outstandingTakes - 1);
+    appState.currentFileIndex = juce::jmin(appState.currentFileIndex + 1, appState.files.size());
+    appState.markChanged(StateSection::progress);
+
+    if (juce::isPositiveAndBelow(result.fileIndex, appState.files.size()))
+    {
+        appState.files.getReference(result.fileIndex).status = result.succeeded ? ProcessingStatus::completed
+                                                                                : ProcessingStatus::failed;
+        notifyFileStatusChanged(result.fileIndex);
+    }
+
+    if (result.succeeded)
+        appState.appendLog("Rendered: " + result.outputFile.getFileName() +
+                           " (" + juce::String(result.renderSeconds, 2) + " s)" + (result.dcOffsetSkipped ? dcOffsetSkippedNote : ""));
+    else
+        appState.appendLog("Error: " + result.errorMessage);
+
+    // All files are in - let the plugin instances (or convolution state) go
+    if (outstandingTakes == 0)
+        offlineRenderer.cancel();
+
+    finishBatchIfComplete();
+}
+
+CaptureOutput::Processing BatchEngine::getOutputProcessing() const
+{
+    const auto& settings = appState.settings;
+
+    CaptureOutput::Processing processing;
+    processing.removeDCOffset = settings.dcRemovalEnabled;
+    processing.trimSilence = settings.trimEnabled;
+    processing.trimThreshold = settings.getThresholdLinear();
+    processing.gain = juce::Decibels::decibelsToGain(settings.outputGainDb);
+    processing.dither = settings.ditherEnabled;
+    processing.resampleQuality = settings.resampleQuality;
+    return processing;
+}
+
+double BatchEngine::getOutputSampleRate(const AudioFile& sourceFile) const
+{
+    const auto& settings = appState.settings;
+
+    if (settings.convertCapturesToSourceRate && sourceFile.needsConversion(settings.sampleRate))
+        return sourceFile.sampleRate;
+
+    return 0.0;
+}
+
+juce::File BatchEngine::generateOutputFile(const AudioFile& sourceFile)
+{
+    juce::File outputFolder(appState.settings.outputFolderPath);
+    juce::String baseName = sourceFile.url.getFileNameWithoutExtension();
+
+    if (appState.settings.outputPostfix.isNotEmpty())
+    {
+        baseName += appState.settings.outputPostfix;
+    }
+
+    // CaptureOutput always writes WAV, whatever format the source was in
+    return outputFolder.getChildFile(baseName + ".wav");
+}
+
+//==============================================================================
+// Critical Audio Algorithms
+
+bool BatchEngine::isReverbTailBelowNoiseFloor(const juce::AudioBuffer<float>& audioWindow, float thresholdDb)
+{
+    // Calculate RMS of window
+    float rms = AudioAnalysis::calculateRMS(audioWindow);
+
+    // Convert to dB
+    float windowDb = 20.0f * std::log10(juce::jmax(rms, 1e-10f));
+
+    // Called from the audio thread - no logging here
+    return windowDb < thresholdDb;
+}
@@ -0,0 +1,470 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AppState.h"
+#include "EngineMessages.h"
+#include "AudioAnalysis.h"
+#include "CaptureWriter.h"
+#include "DeviceProber.h"
+#include "FileIngester.h"
+#include "LatencyMeasurement.h"
+#include "LatencyProfileStore.h"
+#include "MetadataIndex.h"
+#include "PlaybackLoader.h"
+#include "RouteCalibration.h"
+#include "TakeSplitter.h"
+#include "OfflineRenderer.h"
+#include "SweepMeasurement.h"
+#include "VirtualLoopbackDevice.h"
+
+//==============================================================================
+/**
+ * Batch Engine - the audio engine shared by the GUI and the headless runner
+ *
+ * It:
+ * - Is an AudioSource, so any host can drive it from an audio device callback
+ *   (MainComponent through AudioAppComponent, HeadlessRunner through an AudioSourcePlayer)
+ * - Polls the engine's event queue from a message thread Timer, so the audio thread only ever pushes
+ * - Contains the state machine that routes audio based on EngineCommands
+ * - Owns device management, file management and batch orchestration
+ * - Replaces all Swift service classes (AudioProcessingService, LatencyMeasurementService, etc.)
+ *
+ * Everything except the audio callback must be called on the message thread.
+ */
+class BatchEngine : public juce::AudioSource,
+                    private juce::Timer
+{
+public:
+    //==============================================================================
+    explicit BatchEngine(juce::AudioDeviceManager& deviceManagerToUse);
+    ~BatchEngine() override;
+
+    //==============================================================================
+    // AudioSource overrides (Real-time audio thread)
+
+    /** Called before audio processing starts */
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+
+    /** Called when audio processing stops */
+    void releaseResources() override;
+
+    /**
+     * Real-time audio callback - THE CORE STATE MACHINE
+     * Routes audio processing based on the current EngineMode, which is only
+     * changed by EngineCommands popped from commandQueue
+     * CRITICAL: Must be fast and lock-free!
+     *
+     * NOTE: Device inputs arrive in the same buffer and are copied to inputBuffer
+     * before the outputs are written
+     */
+    void getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+    //==============================================================================
+    // Public API - Device Management
+
+    /** Lists the devices known from the last scan at once and rescans them in the background */
+    void refreshDevices();
+
+    /** Waits for the background scan to finish - for callers that need the current list before going on */
+    bool waitForDeviceScan(int timeoutMs);
+
+    /** Select device by unique ID */
+    void selectDevice(const juce::String& deviceID);
+
+    /** Select input stereo pair */
+    void selectInputPair(const StereoPair& pair);
+
+    /** Select output stereo pair */
+    void selectOutputPair(const StereoPair& pair);
+
+    /** Configure audio device settings (device, channel pairs, sample rate, buffer size) */
+    void configureAudioDevice();
+
+    /** Virtual loopback device type (owned by deviceManager) - configure it before selecting the device */
+    VirtualLoopbackDeviceType& getLoopbackDeviceType() { return *loopbackDeviceType; }
+
+    //==============================================================================
+    // Public API - File Management
+
+    /** Add files to processing queue (reads every header before returning) */
+    void addFiles(const juce::Array<juce::File>& files);
+
+    /** Add files and folders (recursively) in the background - they appear in the queue as they are probed */
+    void ingestFiles(const juce::Array<juce::File>& filesOrFolders);
+
+    /** Clear all files from queue */
+    void clearFiles();
+
+    /** Toggle file selection */
+    void toggleFileSelection(int fileIndex);
+
+    /** Select exactly the files at these indices */
+    void setFileSelection(const juce::SparseSet<int>& selectedIndices);
+
+    /** Reorder the queue (not while a batch or preview is running - they refer to files by index) */
+    void sortFiles(FileSortKey key, bool ascending);
+
+    //==============================================================================
+    // Public API - Operations
+
+    /** Start processing all files */
+    void startProcessing();
+
+    /** Stop any active operation */
+    void stopAllAudio();
+
+    /** Measure latency and noise floor */
+    void startLatencyMeasurement();
+
+    /** Capture the impulse response of the selected pairs with a swept sine (needs a latency measurement) */
+    void startImpulseResponseCapture();
+
+    /**
+     * Measure the latency of every output pair to every input at once and store a profile per connected route
+     * The device is opened on all its channels for the capture, then goes back to the selected pairs.
+     * Monitor outputs (stereo out while blockStereoOut is set, and the monitoring channels) are left silent.
+     */
+    void startRouteCalibration();
+
+    /** Start preview of selected files */
+    void startPreview();
+
+    /** Stop preview */
+    void stopPreview();
+
+    /** Start hardware loop test (1kHz sine wave) */
+    void startHardwareTest();
+
+    /** Stop hardware loop test */
+    void stopHardwareTest();
+
+    //==============================================================================
+    // Public API - State Access
+
+    /** Get reference to application state (for UI binding) */
+    AppState& getAppState() { return appState; }
+    const AppState& getAppState() const { return appState; }
+
+    //==============================================================================
+    // Notifications (message thread)
+
+    /** Called when a latency measurement ends - measuredLatencyFrames is only updated on success */
+    std::function<void(bool succeeded)> onLatencyMeasured;
+
+    /** Called when an impulse response capture ends - chainImpulseResponse is only updated on success */
+    std::function<void(bool succeeded)> onImpulseResponseCaptured;
+
+    /** Called whenever a file's ProcessingStatus changes */
+    std::function<void(int fileIndex)> onFileStatusChanged;
+
+    /** Called once every file of a batch has been captured and written */
+    std::function<void()> onBatchFinished;
+
+private:
+    //==============================================================================
+    // Core State
+
+    AppState appState;
+
+    // Owned by the host (MainComponent's AudioAppComponent, or the headless runner)
+    juce::AudioDeviceManager& deviceManager;
+
+    // Registered with deviceManager in the constructor, which owns it
+    VirtualLoopbackDeviceType* loopbackDeviceType = nullptr;
+
+    // Scans and probes the platform devices on its own thread, cached between sessions
+    DeviceProber deviceProber;
+
+    // What is known about every source file ever added, kept between sessions
+    MetadataIndex metadataIndex;
+
+    // Latency and noise floor of every device setup measured so far, kept between sessions
+    LatencyProfileStore latencyProfiles;
+
+    // Walks dropped folders and reads file headers on a thread pool
+    FileIngester fileIngester;
+
+    // Decodes upcoming files into two alternating playback buffers on its own thread
+    PlaybackLoader playbackLoader;
+
+    // Streams captured returns to disk on its own thread
+    CaptureWriter captureWriter;
+
+    // Cuts one-take renders into per-file outputs on its own thread
+    TakeSplitter takeSplitter;
+
+    // Renders batches through a hosted plugin or the captured impulse response instead of the device
+    OfflineRenderer offlineRenderer;
+
+    // Sequence, capture and correlation for startLatencyMeasurement (capture written by the audio thread while measuring)
+    LatencyMeasurement latencyMeasurement;
+
+    // Shifted sequences, capture and correlation for startRouteCalibration (capture written by the audio thread while calibrating)
+    RouteCalibration routeCalibration;
+
+    // Sweep stimulus and capture for startImpulseResponseCapture (message thread, read by the audio thread while capturing)
+    std::unique_ptr<SweepMeasurement> sweepMeasurement;
+    juce::AudioBuffer<float> impulseStimulusBuffer, impulseCaptureBuffer;
+
+    // Batch/preview bookkeeping (message thread)
+    int engineSessionId = 0;   // Bumped per batch/preview so stale events are ignored
+    int nextFileToLoad = 0;    // Next file (or playlist entry) to hand to the loader
+    int loadsInFlight = 0;     // Requested from the loader, not yet delivered
+    int filesInEngine = 0;     // Sent to the audio thread, not yet finished
+    int filesSentThisSession = 0;
+    int outstandingTakes = 0;  // Takes captured or queued but not yet written
+    bool offlineSession = false;  // The running batch renders through OfflineRenderer, not the device
+
+    // One-take render bookkeeping (message thread)
+    bool oneTakeSession = false;    // ProcessingSettings::useOneTakeMode, latched when the batch starts
+    int oneTakeId = -1;             // Capture writer take holding the whole stream (-1 until the first file is sent)
+    bool oneTakeCloseSent = false;
+    TakeSplitter::Job oneTakeJob;   // Filled in with segment offsets as the engine reports them
+
+    //==============================================================================
+    // Engine Messaging (message thread <-> audio thread)
+
+    /** What the audio callback is currently doing (audio thread only) */
+    enum class EngineMode
+    {
+        idle,
+        processing,
+        previewing,
+        measuringLatency,
+        capturingImpulseResponse,
+        calibratingRoutes,
+        testingHardware
+    };
+
+    EngineCommandQueue commandQueue;  // Message thread -> audio thread
+    EngineEventQueue eventQueue;      // Audio thread -> message thread
+    static constexpr int eventPollIntervalMs = 10;
+
+    // Running count of frames rendered since the device started (written by audio thread)
+    std::atomic<juce::int64> engineSampleClock { 0 };
+
+    /** Sends a command to the audio thread, stamped with the current sample clock */
+    void sendEngineCommand(EngineCommand command);
+
+    /** Posts an event from the audio thread - lock-free, picked up by the next timerCallback() */
+    void postEngineEvent(EngineEvent::Type type, int fileIndex, juce::int64 samplePosition, juce::int64 value = 0);
+
+    /** Timer override - drains eventQueue on the message thread */
+    void timerCallback() override;
+
+    /** Reacts to a single engine event (message thread) */
+    void handleEngineEvent(const EngineEvent& event);
+
+    /** Ends whatever the device restart cut short - the engine is already back to idle */
+    void handleEngineReset(bool operationInterrupted);
+
+    //==============================================================================
+    // Processing State (audio thread only - set up from EngineCommands)
+
+    EngineMode engineMode = EngineMode::idle;
+    EngineCommand activeCommand;
+
+    // Files (and closeTake) queued behind the active one, started in order as each gap ends
+    static constexpr int maxArmedCommands = 4;
+    std::array<EngineCommand, (size_t)maxArmedCommands> armedCommands;
+    int numArmedCommands = 0;
+
+    // Take the capture writer is currently receiving (-1 = none)
+    int capturingTakeId = -1;
+    juce::int64 takeSamplePosition = 0;  // Frames pushed to the open take
+
+    /**
+     * Per-file transport phases (processing and preview)
+     * preRoll -> play -> tail -> gap, all counted in frames inside the callback.
+     * Preview skips the tail since nothing is captured.
+     */
+    enum class TransportPhase
+    {
+        preRoll,  // Silence before the first file of a run
+        play,     // Source sent, return captured
+        tail,     // Return captured only (latency + safety, or reverb tail)
+        gap       // Silence before the next file
+    };
+
+    TransportPhase transportPhase = TransportPhase::preRoll;
+    juce::int64 phaseFramesRemaining = 0;
+
+    // Playback state
+    juce::int64 playbackSamplePosition = 0;
+    juce::int64 recordingSamplePosition = 0;
+
+    // Reverb mode state
+    int consecutiveSilentBuffers = 0;
+    int requiredConsecutiveSilentBuffers = 3;
+
+    // Hardware test state
+    float sinePhase = 0.0f;
+    float sineFrequency = 1000.0f; // 1kHz test tone
+
+    // Last xrun count seen by the audio thread
+    int lastXRunCount = 0;
+
+    // Input buffer for capturing hardware inputs
+    juce::AudioBuffer<float> inputBuffer;
+
+    //==============================================================================
+    // Helper Methods - Audio Thread
+
+    /** Applies every pending command from commandQueue */
+    void processPendingCommands();
+
+    /** Makes a command the active one and switches engineMode accordingly */
+    void activateCommand(const EngineCommand& command);
+
+    /** Drops the active and armed operations, discarding any capture in progress */
+    void abandonCurrentOperation();
+
+    /** Moves the active file to a transport phase and loads that phase's frame count */
+    void enterTransportPhase(TransportPhase phase);
+
+    /** Called when a gap ends: starts the armed file, or returns to idle */
+    void startArmedFileOrIdle();
+
+    /** Opens / closes the capture writer take the engine is recording into */
+    void beginCapture(int takeId);
+    void endCapture(bool aborted);
+
+    /** Pushes the captured return for part of the current block to the capture writer */
+    void captureReturnFrames(int blockOffset, int numFrames);
+
+    /** Hands a playback buffer back to the message thread for reuse by the loader */
+    void releasePlaybackBuffer(juce::AudioBuffer<float>* buffer);
+
+    /** Per-mode render functions, called from getNextAudioBlock */
+    void renderHardwareTest(const juce::AudioSourceChannelInfo& bufferToFill);
+    void renderStimulusCapture(const juce::AudioSourceChannelInfo& bufferToFill);  // Latency and impulse response measurements
+    void renderRouteCalibration(const juce::AudioSourceChannelInfo& bufferToFill);
+
+    /**
+     * Renders the current transport phase from blockOffset onwards
+     * @return Frames consumed - less than the rest of the block if the phase ended
+     */
+    int renderPlayback(const juce::AudioSourceChannelInfo& bufferToFill, int blockOffset);
+
+    //==============================================================================
+    // Helper Methods - Device Management
+
+    /** Rebuilds appState.devices from the prober's list plus the loopback device */
+    void populateDeviceList();
+    void handleDevicesChanged(bool scanFinished);
+
+
+    //==============================================================================
+    // Helper Methods - File Processing
+
+    /** Starts a new batch/preview session, discarding anything still in flight */
+    void beginEngineSession();
+
+    /** Asks the loader for the next valid batch file (skipping invalid ones) */
+    void prefetchNextProcessingFile();
+
+    /** Asks the loader for the next preview playlist entry */
+    void prefetchNextPreviewFile();
+
+    /** Sends a decoded file to the audio thread, armed behind the file currently playing */
+    void handleFileLoaded(const PlaybackLoader::Result& result);
+
+    /** Ends the preview once every playlist entry has played */
+    void finishPreviewIfComplete();
+
+    /** Takes the latency and noise floor from an analysed capture */
+    void completeLatencyMeasurement(const LatencyMeasurement::Result& result);
+
+    /** The profile key for the open device and pairs - false if there is nothing to key (or it is the loopback device) */
+    bool getLatencyProfileKey(LatencyProfileStore::Key& key) const;
+    bool getLatencyProfileKey(LatencyProfileStore::Key& key, const StereoPair& inputPair, const StereoPair& outputPair) const;
+
+    /** Takes latency and noise floor from the stored profile for the current setup, if it is trustworthy */
+    void restoreLatencyProfile();
+
+    /** Stores a latency profile for every input pair an output pair reaches */
+    void completeRouteCalibration(const RouteCalibration::Result& result);
+
+    /** Reopens the current device on these channels (0-indexed) - false, with the error logged, if it fails */
+    bool setDeviceChannels(const juce::BigInteger& inputChannels, const juce::BigInteger& outputChannels);
+
+    /** Back to the selected input and output pairs after the calibration opened every channel */
+    void restoreSelectedChannels();
+
+    /** Deconvolves impulseCaptureBuffer into AppState::chainImpulseResponse */
+    void completeImpulseResponseCapture();
+
+    /**
+     * Registers the output file, latency skip and length for a file with the capture writer
+     * @return The take ID the audio thread must pass to CaptureWriter::beginTake()
+     */
+    int queueCaptureForFile(int fileIndex, int sourceFrames);
+
+    /** Updates file status once the capture writer has finished a take */
+    void handleTakeFinished(const CaptureWriter::Result& result);
+
+    /** Sets up the take and manifest files for a one-take batch */
+    void beginOneTakeRender();
+
+    /**
+     * Adds a file to the one-take render, registering the take itself with the first file
+     * @return The take ID shared by every file of the render
+     */
+    int queueOneTakeSegment(int fileIndex, int sourceFrames);
+
+    /** Ends the one-take stream once every file has been sent to the engine */
+    void closeOneTakeIfAllSent();
+
+    /** Hands the finished one-take capture to the splitter */
+    void handleOneTakeWritten(const CaptureWriter::Result& result);
+
+    /** Updates file status once the splitter has written a segment */
+    void handleSegmentSplit(const TakeSplitter::Result& result);
+
+    /** Adds a probed file to the queue - only an invalid one is logged on its own */
+    void addFile(const AudioFile& audioFile);
+    void handleFilesProbed(const juce::Array<FileIngester::Result>& results);
+
+    /** Logs one summary line for the files added from firstIndex on */
+    void logFilesAdded(int firstIndex);
+
+    /** Returns the one-take segment for a file, or nullptr */
+    TakeSplitter::Segment* findOneTakeSegment(int fileIndex);
+
+    /** Starts a batch through the offline renderer (plugin or impulse response) - the device is not used */
+    void beginOfflineRender();
+
+    /** Updates file status once the offline renderer has written a file */
+    void handleOfflineFileRendered(const OfflineRenderer::Result& result);
+
+    /** Ends the batch once every file has been captured and written */
+    void finishBatchIfComplete();
+
+    /** Calls onFileStatusChanged if it is set */
+    void notifyFileStatusChanged(int fileIndex);
+
+    /** Post-processing for every output file, from the current settings */
+    CaptureOutput::Processing getOutputProcessing() const;
+
+    /** Rate an output file is written at: its source's if captures go back to the source rate, 0 = the device rate */
+    double getOutputSampleRate(const AudioFile& sourceFile) const;
+
+    /** Generate output filename with postfix - always .wav, as CaptureOutput writes */
+    juce::File generateOutputFile(const AudioFile& sourceFile);
+
+    //==============================================================================
+    // Helper Methods - Critical Audio Algorithms
+
+    /**
+     * Check if reverb tail has fallen below noise floor
+     * See: REVERB_MODE_IMPLEMENTATION.md
+     *
+     * @param audioWindow The audio window to analyze (e.g., last 2048 samples)
+     * @param thresholdDb Noise floor threshold (see ProcessingSettings::getNoiseFloorThresholdDb)
+     * @return true if window is below noise floor threshold
+     */
+    bool isReverbTailBelowNoiseFloor(const juce::AudioBuffer<float>& audioWindow, float thresholdDb);
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BatchEngine)
+};
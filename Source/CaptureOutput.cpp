@@ -0,0 +1,436 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "CaptureOutput.h"
+#include "AudioAnalysis.h"
+
+namespace
+{
+// Frames transformed per pass - small enough that the scratch stays in L1
+constexpr int blockFrames = 1024;
+
+// Full scale of a 24-bit sample, as used by JUCE's own 24-bit conversion
+constexpr float int24Scale = 8388607.0f;
+
+// WAV stores data sizes in 32 bits
+constexpr juce::int64 maxDataBytes = 0xffffff00;
+
+// KSDATAFORMAT_SUBTYPE_PCM, for WAVE_FORMAT_EXTENSIBLE headers
+constexpr juce::uint8 pcmSubFormat[16] = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+                                           0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 };
+}
+
+//==============================================================================
+CaptureOutput::CaptureOutput()
+{
+}
+
+CaptureOutput::~CaptureOutput()
+{
+    abandon();
+}
+
+bool CaptureOutput::open(const juce::File& file, const Format& formatToUse, const Processing& processingToUse)
+{
+    abandon();
+
+    outputFile = file;
+    format = formatToUse;
+    format.numChannels = juce::jmax(1, format.numChannels);
+    processing = processingToUse;
+    bytesPerFrame = format.numChannels * 3;
+
+    outputSampleRate = format.outputSampleRate > 0.0 ? format.outputSampleRate : format.sampleRate;
+    advance.reset();
+    converter.reset();
+    maxWrittenFrames = format.maxOutputFrames;
+
+    if (FractionalDelay::isNeeded(format.channelAdvanceFrames))
+        advance = std::make_unique<FractionalDelay>(format.numChannels, format.channelAdvanceFrames);
+
+    if (SampleRateConverter::isNeeded(format.sampleRate, outputSampleRate))
+    {
+        converter = std::make_unique<SampleRateConverter>(format.sampleRate, outputSampleRate,
+                                                          format.numChannels, processing.resampleQuality);
+
+        if (format.maxOutputFrames >= 0)
+            maxWrittenFrames = converter->getOutputLength(format.maxOutputFrames);
+    }
+
+    if (advance != nullptr || converter != nullptr)
+        keptChannels.malloc((size_t)format.numChannels);
+
+    framesConsumed = 0;
+    framesKept = 0;
+    framesAligned = 0;
+    framesWritten = 0;
+    lastLoudFrameEnd = 0;
+    leadingSilenceDone = !processing.trimSilence;
+    errorMessage.clear();
+
+    dcSums.calloc((size_t)format.numChannels);
+    dcOffsets.calloc((size_t)format.numChannels);
+    block.setSize(format.numChannels, blockFrames, false, false, true);
+    packed.malloc((size_t)(blockFrames * bytesPerFrame));
+
+    // FileOutputStream appends to an existing file, so start from scratch
+    outputFile.deleteFile();
+    stream = std::make_unique<juce::FileOutputStream>(outputFile);
+
+    if (stream->failedToOpen())
+    {
+        stream.reset();
+        errorMessage = "Could not create output stream for file - " + outputFile.getFileName();
+        return false;
+    }
+
+    writeHeader();
+    dataStart = stream->getPosition();
+
+    if (stream->getStatus().failed())
+    {
+        fail("Could not write header for file - " + outputFile.getFileName());
+        return false;
+    }
+
+    return true;
+}
+
+bool CaptureOutput::isFull() const noexcept
+{
+    return format.maxOutputFrames >= 0 && framesKept >= format.maxOutputFrames + getLookahead();
+}
+
+//==============================================================================
+// Processing
+
+bool CaptureOutput::process(const float* const* channels, int numFrames)
+{
+    if (stream == nullptr)
+        return false;
+
+    int position = 0;
+
+    // 1. Latency region: nothing is written, but the return is idle here so its
+    //    mean is the chain's DC bias
+    if (framesConsumed < format.skipFrames)
+    {
+        position = (int)juce::jmin((juce::int64)numFrames, format.skipFrames - framesConsumed);
+
+        for (int ch = 0; ch < format.numChannels; ++ch)
+            dcSums[ch] += AudioAnalysis::analyseChannel(channels[ch], position).sum;
+
+        framesConsumed += position;
+
+        if (processing.removeDCOffset && framesConsumed >= format.skipFrames)
+        {
+            for (int ch = 0; ch < format.numChannels; ++ch)
+                dcOffsets[ch] = (float)(dcSums[ch] / (double)format.skipFrames);
+        }
+    }
+
+    int remaining = numFrames - position;
+    framesConsumed += remaining;
+
+    if (format.maxOutputFrames >= 0)
+        remaining = (int)juce::jlimit((juce::int64)0, (juce::int64)remaining,
+                                      format.maxOutputFrames + getLookahead() - framesKept);
+
+    framesKept += remaining;
+
+    if (remaining <= 0)
+        return true;
+
+    if (advance == nullptr && converter == nullptr)
+        return writeKept(channels, position, remaining);
+
+    // 2. Everything after it, each return lined up with the send
+    for (int ch = 0; ch < format.numChannels; ++ch)
+        keptChannels[ch] = channels[ch] + position;
+
+    if (advance != nullptr)
+    {
+        const int numAligned = advance->process(keptChannels.get(), remaining, aligned);
+        return writeAligned(aligned.getArrayOfReadPointers(), numAligned);
+    }
+
+    return writeAligned(keptChannels.get(), remaining);
+}
+
+bool CaptureOutput::writeAligned(const float* const* channels, int numFrames)
+{
+    // The lookahead only feeds the interpolation - it is never kept itself
+    if (format.maxOutputFrames >= 0)
+        numFrames = (int)juce::jlimit((juce::int64)0, (juce::int64)numFrames, format.maxOutputFrames - framesAligned);
+
+    framesAligned += numFrames;
+
+    if (numFrames <= 0)
+        return true;
+
+    // 3. Back at the source rate if asked for
+    if (converter != nullptr)
+    {
+        const int numConverted = converter->process(channels, numFrames, converted);
+        return writeKept(converted.getArrayOfReadPointers(), 0, numConverted);
+    }
+
+    return writeKept(channels, 0, numFrames);
+}
+
+bool CaptureOutput::writeKept(const float* const* channels, int startFrame, int numFrames)
+{
+    // One scratch block at a time
+    while (numFrames > 0)
+    {
+        const int chunk = juce::jmin(numFrames, blockFrames);
+
+        if (!writeFrames(channels, startFrame, chunk))
+            return false;
+
+        startFrame += chunk;
+        numFrames -= chunk;
+    }
+
+    return true;
+}
+
+bool CaptureOutput::writeFrames(const float* const* channels, int startFrame, int numFrames)
+{
+    const int numChannels = format.numChannels;
+    const float gain = processing.gain;
+
+    // DC removal and gain in one vector op pair: (x - dc) * gain
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        float* destination = block.getWritePointer(ch);
+        juce::FloatVectorOperations::copyWithMultiply(destination, channels[ch] + startFrame, gain, numFrames);
+
+        if (dcOffsets[ch] != 0.0f)
+            juce::FloatVectorOperations::add(destination, -dcOffsets[ch] * gain, numFrames);
+    }
+
+    // Silence trim: first and last frame with any channel above the threshold.
+    // A vectorised min/max settles most blocks; only loud ones are scanned
+    int firstFrame = 0;
+
+    if (processing.trimSilence)
+    {
+        const float threshold = processing.trimThreshold * std::abs(gain);
+        int firstLoud = numFrames;
+        int lastLoud = -1;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* data = block.getReadPointer(ch);
+            const auto range = juce::FloatVectorOperations::findMinAndMax(data, numFrames);
+
+            if (juce::jmax(-range.getStart(), range.getEnd()) <= threshold)
+                continue;
+
+            int first = 0;
+            while (first < firstLoud && std::abs(data[first]) <= threshold)
+                ++first;
+
+            int last = numFrames - 1;
+            while (last > lastLoud && std::abs(data[last]) <= threshold)
+                --last;
+
+            firstLoud = juce::jmin(firstLoud, first);
+            lastLoud = juce::jmax(lastLoud, last);
+        }
+
+        if (!leadingSilenceDone)
+        {
+            // Still nothing but leading silence - drop the whole block
+            if (lastLoud < 0)
+                return true;
+
+            firstFrame = firstLoud;
+            leadingSilenceDone = true;
+        }
+
+        if (lastLoud >= firstFrame)
+            lastLoudFrameEnd = framesWritten + (lastLoud - firstFrame) + 1;
+    }
+
+    const int framesToWrite = numFrames - firstFrame;
+
+    if ((framesWritten + framesToWrite) * bytesPerFrame > maxDataBytes - dataStart)
+    {
+        fail("Output too long for a WAV file - " + outputFile.getFileName());
+        return false;
+    }
+
+    // Dither, quantise and interleave into little-endian 24-bit frames
+    const float* const* source = block.getArrayOfReadPointers();
+    juce::uint8* destination = packed.get();
+
+    for (int i = firstFrame; i < numFrames; ++i)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float value = source[ch][i] * int24Scale;
+
+            if (processing.dither)
+                value += nextDither();
+
+            const int sample = juce::jlimit(-8388608, 8388607, juce::roundToInt(value));
+            destination[0] = (juce::uint8)sample;
+            destination[1] = (juce::uint8)(sample >> 8);
+            destination[2] = (juce::uint8)(sample >> 16);
+            destination += 3;
+        }
+    }
+
+    if (!stream->write(packed.get(), (size_t)(framesToWrite * bytesPerFrame)))
+    {
+        fail("Disk write failed for file - " + outputFile.getFileName());
+        return false;
+    }
+
+    framesWritten += framesToWrite;
+    return true;
+}
+
+float CaptureOutput::nextDither() noexcept
+{
+    // xorshift32 - plenty for dither and far cheaper than juce::Random per sample
+    auto nextUniform = [this]() noexcept
+    {
+        ditherState ^= ditherState << 13;
+        ditherState ^= ditherState >> 17;
+        ditherState ^= ditherState << 5;
+        return (float)ditherState * (1.0f / 4294967296.0f);
+    };
+
+    // Difference of two uniforms: triangular between -1 and +1 LSB
+    return nextUniform() - nextUniform();
+}
+
+//==============================================================================
+// Finishing
+
+bool CaptureOutput::finish()
+{
+    if (stream == nullptr)
+        return false;
+
+    // The alignment and the converter hold back the frames their filters haven't reached yet
+    if (advance != nullptr)
+    {
+        const int numFlushed = advance->flush(aligned);
+
+        if (!writeAligned(aligned.getArrayOfReadPointers(), numFlushed))
+            return false;
+    }
+
+    if (converter != nullptr)
+    {
+        const int numFlushed = converter->flush(converted);
+
+        if (!writeKept(converted.getArrayOfReadPointers(), 0, numFlushed))
+            return false;
+    }
+
+    if (processing.trimSilence)
+    {
+        // Cut the trailing silence written since the last frame above the threshold
+        if (framesWritten > lastLoudFrameEnd)
+        {
+            stream->setPosition(dataStart + lastLoudFrameEnd * bytesPerFrame);
+
+            if (stream->truncate().failed())
+            {
+                fail("Could not trim trailing silence in file - " + outputFile.getFileName());
+                return false;
+            }
+
+            framesWritten = lastLoudFrameEnd;
+        }
+    }
+    else if (format.padToMaxOutput && maxWrittenFrames > framesWritten)
+    {
+        // Pad short captures so the output always matches the requested length
+        juce::zeromem(packed.get(), (size_t)(blockFrames * bytesPerFrame));
+
+        while (framesWritten < maxWrittenFrames)
+        {
+            const int framesToWrite = (int)juce::jmin((juce::int64)blockFrames, maxWrittenFrames - framesWritten);
+
+            if (!stream->write(packed.get(), (size_t)(framesToWrite * bytesPerFrame)))
+            {
+                fail("Disk write failed for file - " + outputFile.getFileName());
+                return false;
+            }
+
+            framesWritten += framesToWrite;
+        }
+    }
+
+    // RIFF chunks are word aligned: odd-sized data (mono) gets a pad byte
+    if ((framesWritten * bytesPerFrame) % 2 != 0)
+        stream->writeByte(0);
+
+    writeHeader();
+    stream->flush();
+
+    const bool succeeded = stream->getStatus().wasOk();
+    stream.reset();
+
+    if (!succeeded)
+    {
+        errorMessage = "Could not finalise file - " + outputFile.getFileName();
+        outputFile.deleteFile();
+    }
+
+    return succeeded;
+}
+
+void CaptureOutput::abandon()
+{
+    if (stream == nullptr)
+        return;
+
+    stream.reset();
+    outputFile.deleteFile();
+}
+
+void CaptureOutput::fail(const juce::String& message)
+{
+    errorMessage = message;
+    abandon();
+}
+
+void CaptureOutput::writeHeader()
+{
+    // More than two channels needs WAVE_FORMAT_EXTENSIBLE to be read correctly everywhere
+    const bool extensible = format.numChannels > 2;
+    const int formatBytes = extensible ? 40 : 16;
+    const juce::int64 dataBytes = framesWritten * bytesPerFrame;
+    const juce::int64 riffBytes = 4 + (8 + formatBytes) + (8 + dataBytes + (dataBytes % 2));
+
+    stream->setPosition(0);
+
+    stream->write("RIFF", 4);
+    stream->writeInt((int)riffBytes);
+    stream->write("WAVE", 4);
+
+    stream->write("fmt ", 4);
+    stream->writeInt(formatBytes);
+    stream->writeShort((short)(extensible ? 0xfffe : 1));
+    stream->writeShort((short)format.numChannels);
+    stream->writeInt(juce::roundToInt(outputSampleRate));
+    stream->writeInt(juce::roundToInt(outputSampleRate) * bytesPerFrame);
+    stream->writeShort((short)bytesPerFrame);
+    stream->writeShort(24);
+
+    if (extensible)
+    {
+        stream->writeShort(22);
+        stream->writeShort(24);   // Valid bits per sample
+        stream->writeInt(0);      // No speaker positions
+        stream->write(pcmSubFormat, sizeof(pcmSubFormat));
+    }
+
+    stream->write("data", 4);
+    stream->writeInt((int)dataBytes);
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleRateConverter.h"
+#include "FractionalDelay.h"
+
+//==============================================================================
+/**
+ * Streaming post-capture stage and 24-bit WAV writer
+ *
+ * Everything that happens to a capture between the return and the disk, done
+ * block by block in one place: latency skip (its mean is the chain's DC
+ * bias, see LATENCY_TRIMMING_FIX.md), the fraction of a frame each return
+ * lags beyond it (see FractionalDelay), optional conversion back to the
+ * source's rate, DC removal, gain, leading and trailing silence trim, TPDF
+ * dither and packing to 24-bit little-endian frames that go straight into
+ * the file. Shared by CaptureWriter, TakeSplitter and
+ * OfflineRenderer, so the three output paths can't drift apart.
+ *
+ * Each block is transformed in a small L1-sized scratch buffer: the float
+ * stages run through FloatVectorOperations, then one loop dithers, quantises
+ * and interleaves into the packed byte buffer. The input is never modified,
+ * so callers may pass the same channel pointer for several output channels.
+ *
+ * Leading silence is dropped before anything is written. Trailing silence is
+ * written as it comes and cut off again by finish(), which truncates the file
+ * after the last frame above the threshold and patches the header.
+ *
+ * Not thread safe - one instance per writer thread.
+ */
+class CaptureOutput
+{
+public:
+    //==============================================================================
+    /** What happens to the kept audio on its way to disk */
+    struct Processing
+    {
+        bool removeDCOffset = true;    // Subtract the bias measured during the skipped latency (see isDCOffsetSkipped)
+        bool trimSilence = false;      // Drop leading and trailing frames below trimThreshold
+        float trimThreshold = 0.01f;   // Linear, compared after DC removal and before gain
+        float gain = 1.0f;
+        bool dither = true;            // TPDF dither of +-1 LSB before the 24-bit quantisation
+        SampleRateConverter::Quality resampleQuality = SampleRateConverter::Quality::standard;
+    };
+
+    /** Layout of one capture */
+    struct Format
+    {
+        double sampleRate = 44100.0;       // Of the frames pushed
+        double outputSampleRate = 0.0;     // Of the file: 0 = sampleRate, anything else is converted to
+        int numChannels = 2;
+        juce::int64 skipFrames = 0;        // Latency at the start: measured for DC, never written
+        juce::Array<double> channelAdvanceFrames;  // Per channel latency beyond the skip, interpolated away; empty = none
+        juce::int64 maxOutputFrames = -1;  // Frames kept after the skip (at sampleRate), -1 = everything pushed
+        bool padToMaxOutput = false;       // Pad a short capture with silence up to maxOutputFrames (never when trimming)
+    };
+
+    //==============================================================================
+    CaptureOutput();
+    ~CaptureOutput();
+
+    /** Creates the file (replacing any existing one) and writes a provisional header */
+    bool open(const juce::File& file, const Format& format, const Processing& processing);
+
+    /**
+     * Runs numFrames frames of the capture through the stage
+     * @param channels One pointer per output channel, read-only
+     * @return false once a write has failed (see getErrorMessage)
+     */
+    bool process(const float* const* channels, int numFrames);
+
+    /** Pads or trims the end, patches the header and closes the file */
+    bool finish();
+
+    /** Closes and deletes a partial file */
+    void abandon();
+
+    bool isOpen() const noexcept                      { return stream != nullptr; }
+
+    /** True if DC removal was asked for but there is no skipped latency to measure the bias in - the file keeps it */
+    bool isDCOffsetSkipped() const noexcept           { return processing.removeDCOffset && format.skipFrames <= 0; }
+
+    /** True once maxOutputFrames (and the lookahead) have been taken in - further frames are ignored */
+    bool isFull() const noexcept;
+
+    /** Frames past maxOutputFrames worth pushing when the capture has them: the alignment interpolates from them */
+    int getLookahead() const noexcept                 { return advance != nullptr ? advance->getLookahead() : 0; }
+
+    /** Frames pushed so far, including the skip */
+    juce::int64 getFramesConsumed() const noexcept    { return framesConsumed; }
+
+    /** Frames in the file so far (after finish(): its final length) */
+    juce::int64 getFramesWritten() const noexcept     { return framesWritten; }
+
+    const juce::String& getErrorMessage() const noexcept { return errorMessage; }
+
+private:
+    //==============================================================================
+    void writeHeader();
+    bool writeAligned(const float* const* channels, int numFrames);
+    bool writeKept(const float* const* channels, int startFrame, int numFrames);
+    bool writeFrames(const float* const* channels, int startFrame, int numFrames);
+    void fail(const juce::String& message);
+    float nextDither() noexcept;
+
+    juce::File outputFile;
+    std::unique_ptr<juce::FileOutputStream> stream;
+    Format format;
+    Processing processing;
+    double outputSampleRate = 0.0;
+    juce::int64 maxWrittenFrames = -1;   // maxOutputFrames at the output rate
+    juce::int64 dataStart = 0;           // Byte offset of the first frame in the file
+    int bytesPerFrame = 0;
+
+    // Progress
+    juce::int64 framesConsumed = 0;      // Everything pushed, skip included
+    juce::int64 framesKept = 0;          // After the skip, before the leading trim
+    juce::int64 framesAligned = 0;       // Out of the alignment, before the conversion
+    juce::int64 framesWritten = 0;       // In the file
+    juce::int64 lastLoudFrameEnd = 0;    // framesWritten just after the last frame above the threshold
+    bool leadingSilenceDone = false;
+    juce::String errorMessage;
+
+    // DC measured over the skip
+    juce::HeapBlock<double> dcSums;
+    juce::HeapBlock<float> dcOffsets;
+
+    // Per-block scratch
+    juce::AudioBuffer<float> block;
+    juce::HeapBlock<juce::uint8> packed;
+    juce::uint32 ditherState = 0x9e3779b9;
+
+    // Per-return alignment and conversion back to the source rate, when there are any
+    std::unique_ptr<FractionalDelay> advance;
+    std::unique_ptr<SampleRateConverter> converter;
+    juce::HeapBlock<const float*> keptChannels;
+    juce::AudioBuffer<float> aligned, converted;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CaptureOutput)
+};
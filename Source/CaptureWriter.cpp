@@ -0,0 +1,415 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "CaptureWriter.h"
+
+namespace
+{
+// Frames processed per write call on the writer thread
+constexpr int writerBlockFrames = 4096;
+
+// Takes that can be closing at the same time. Closing is mostly waiting on the
+// disk, so a couple of threads are plenty even with short files back to back
+constexpr int finaliserThreads = 2;
+
+// How long release() (at shutdown) waits for captured takes to be closed before giving up on them
+constexpr int finaliserTimeoutMs = 10000;
+}
+
+//==============================================================================
+/** Closes one captured take on the finaliser pool */
+class CaptureWriter::FinaliseJob : public juce::ThreadPoolJob
+{
+public:
+    FinaliseJob(CaptureWriter& ownerToUse, std::unique_ptr<ActiveTake> takeToFinalise)
+        : juce::ThreadPoolJob("Finalise " + takeToFinalise->take.outputFile.getFileName()),
+          owner(ownerToUse),
+          take(std::move(takeToFinalise))
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        owner.finaliseTake(*take);
+        take.reset();
+        return jobHasFinished;
+    }
+
+private:
+    CaptureWriter& owner;
+    std::unique_ptr<ActiveTake> take;  // Never run = never reported; its output is abandoned
+};
+
+//==============================================================================
+CaptureWriter::CaptureWriter()
+    : juce::Thread("Capture Writer"),
+      finaliserPool(juce::ThreadPoolOptions{}.withThreadName("Capture Finaliser")
+                                            .withNumberOfThreads(finaliserThreads))
+{
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    release();
+    cancelPendingUpdate();
+}
+
+void CaptureWriter::prepare(int numChannels, int fifoFrames)
+{
+    // Finalisers only touch their own take, never the FIFO, so the device thread doesn't wait on their disk I/O
+    stopWriterThread();
+
+    ringBuffer.setSize(juce::jmax(1, numChannels), fifoFrames);
+    ringBuffer.clear();
+
+    ringChannels.clearQuick();
+    for (int ch = 0; ch < ringBuffer.getNumChannels(); ++ch)
+        ringChannels.add(ringBuffer.getReadPointer(ch));
+
+    fifo.setTotalSize(fifoFrames);
+    markerQueue.clear();
+
+    // The engine restarts from idle, so takes registered before now will never be captured
+    {
+        const juce::ScopedLock sl(takeLock);
+
+        for (const auto& take : pendingTakes)
+            postFailure(take, "Capture interrupted by an audio device restart - " + take.outputFile.getFileName());
+
+        pendingTakes.clearQuick();
+    }
+
+    takeOpen = false;
+    framesPushedInTake = 0;
+    framesDroppedInTake = 0;
+
+    startThread();
+}
+
+void CaptureWriter::release()
+{
+    stopWriterThread();
+
+    // Takes that were fully captured are worth waiting for
+    const auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32)finaliserTimeoutMs;
+
+    while (finaliserPool.getNumJobs() > 0 && juce::Time::getMillisecondCounter() < deadline)
+        juce::Thread::sleep(5);
+
+    finaliserPool.removeAllJobs(true, 1000);
+}
+
+void CaptureWriter::stopWriterThread()
+{
+    stopThread(2000);
+
+    // Abandon a half-written take rather than leave a truncated file behind
+    if (active != nullptr)
+    {
+        active->output.abandon();
+        postFailure(active->take, "Capture interrupted by an audio device restart - " + active->take.outputFile.getFileName());
+        active.reset();
+    }
+}
+
+int CaptureWriter::queueTake(Take take)
+{
+    const juce::ScopedLock sl(takeLock);
+    take.takeId = nextTakeId++;
+    pendingTakes.add(take);
+    return take.takeId;
+}
+
+//==============================================================================
+// Audio Thread
+
+void CaptureWriter::beginTake(int takeId) noexcept
+{
+    if (takeOpen)
+        endTake(true);
+
+    CaptureMarker marker;
+    marker.type = CaptureMarker::Type::begin;
+    marker.takeId = takeId;
+    markerQueue.push(marker);
+
+    takeOpen = true;
+    framesPushedInTake = 0;
+    framesDroppedInTake = 0;
+}
+
+bool CaptureWriter::pushFrames(const juce::AudioBuffer<float>& source, int startSample, int numFrames) noexcept
+{
+    if (!takeOpen || numFrames <= 0)
+        return true;
+
+    // Never block the audio thread - if the disk can't keep up the frames are lost and the take fails
+    if (fifo.getFreeSpace() < numFrames)
+    {
+        framesDroppedInTake += numFrames;
+        return false;
+    }
+
+    const auto scope = fifo.write(numFrames);
+
+    for (int ch = 0; ch < ringBuffer.getNumChannels(); ++ch)
+    {
+        const int sourceChannel = juce::jmin(ch, source.getNumChannels() - 1);
+
+        if (sourceChannel < 0)
+        {
+            if (scope.blockSize1 > 0) ringBuffer.clear(ch, scope.startIndex1, scope.blockSize1);
+            if (scope.blockSize2 > 0) ringBuffer.clear(ch, scope.startIndex2, scope.blockSize2);
+            continue;
+        }
+
+        if (scope.blockSize1 > 0)
+            ringBuffer.copyFrom(ch, scope.startIndex1, source, sourceChannel, startSample, scope.blockSize1);
+        if (scope.blockSize2 > 0)
+            ringBuffer.copyFrom(ch, scope.startIndex2, source, sourceChannel, startSample + scope.blockSize1, scope.blockSize2);
+    }
+
+    framesPushedInTake += numFrames;
+    return true;
+}
+
+void CaptureWriter::endTake(bool aborted) noexcept
+{
+    if (!takeOpen)
+        return;
+
+    CaptureMarker marker;
+    marker.type = CaptureMarker::Type::end;
+    marker.totalFrames = framesPushedInTake;
+    marker.droppedFrames = framesDroppedInTake;
+    marker.aborted = aborted;
+    markerQueue.push(marker);
+
+    takeOpen = false;
+}
+
+//==============================================================================
+// Writer Thread
+
+void CaptureWriter::run()
+{
+    while (!threadShouldExit())
+    {
+        // Read the FIFO level BEFORE looking for the end marker: frames of the next take
+        // are only pushed after this take's end marker, so everything counted here
+        // belongs to the active take
+        const int numReady = fifo.getNumReady();
+
+        if (active == nullptr)
+        {
+            CaptureMarker marker;
+            if (markerQueue.pop(marker))
+            {
+                jassert(marker.type == CaptureMarker::Type::begin);
+                if (marker.type == CaptureMarker::Type::begin)
+                    openTake(marker.takeId);
+                continue;
+            }
+
+            wait(5);
+            continue;
+        }
+
+        if (active->endFrame < 0)
+        {
+            CaptureMarker marker;
+            if (markerQueue.pop(marker))
+            {
+                jassert(marker.type == CaptureMarker::Type::end);
+                active->endFrame = marker.totalFrames;
+                active->droppedFrames = marker.droppedFrames;
+                active->aborted = marker.aborted;
+            }
+        }
+
+        int framesToConsume = numReady;
+        if (active->endFrame >= 0)
+            framesToConsume = (int)juce::jmin((juce::int64)numReady, active->endFrame - active->framesConsumed);
+
+        if (framesToConsume > 0)
+            consumeFrames(framesToConsume);
+
+        if (active->endFrame >= 0 && active->framesConsumed >= active->endFrame)
+        {
+            finishTake();
+            continue;
+        }
+
+        if (framesToConsume <= 0)
+            wait(5);
+    }
+}
+
+bool CaptureWriter::openTake(int takeId)
+{
+    active = std::make_unique<ActiveTake>();
+
+    {
+        const juce::ScopedLock sl(takeLock);
+
+        // Drop takes that were registered but never captured (e.g. the batch was stopped)
+        while (!pendingTakes.isEmpty() && pendingTakes.getReference(0).takeId != takeId)
+        {
+            const auto dropped = pendingTakes.removeAndReturn(0);
+            postFailure(dropped, "Capture never started - " + dropped.outputFile.getFileName());
+        }
+
+        if (pendingTakes.isEmpty())
+        {
+            active->take.takeId = takeId;
+            active->errorMessage = "No output registered for capture";
+            return false;
+        }
+
+        active->take = pendingTakes.removeAndReturn(0);
+    }
+
+    const auto& take = active->take;
+
+    // Output channels beyond the ring repeat its last channel
+    viewChannels.clearQuick();
+    for (int ch = 0; ch < take.numChannels; ++ch)
+        viewChannels.add(ringChannels[juce::jmin(ch, ringChannels.size() - 1)]);
+
+    blockChannels = viewChannels;
+
+    CaptureOutput::Format format;
+    format.sampleRate = take.sampleRate;
+    format.outputSampleRate = take.outputSampleRate;
+    format.numChannels = take.numChannels;
+    format.skipFrames = take.skipFrames;
+    format.channelAdvanceFrames = take.channelAdvanceFrames;
+    format.maxOutputFrames = take.outputFrames;
+    format.padToMaxOutput = true;
+
+    if (!active->output.open(take.outputFile, format, take.processing))
+    {
+        active->errorMessage = active->output.getErrorMessage();
+        return false;
+    }
+
+    return true;
+}
+
+void CaptureWriter::consumeFrames(int numFrames)
+{
+    while (numFrames > 0)
+    {
+        const int chunk = juce::jmin(numFrames, writerBlockFrames);
+
+        // The scope keeps the region reserved until the block has been processed
+        const auto scope = fifo.read(chunk);
+
+        if (scope.blockSize1 > 0)
+            processBlock(scope.startIndex1, scope.blockSize1);
+        if (scope.blockSize2 > 0)
+            processBlock(scope.startIndex2, scope.blockSize2);
+
+        numFrames -= chunk;
+    }
+}
+
+void CaptureWriter::processBlock(int startIndex, int numFrames)
+{
+    // The read scope keeps this region away from the audio thread while the
+    // output stage reads it straight out of the ring
+    if (active->output.isOpen())
+    {
+        for (int ch = 0; ch < viewChannels.size(); ++ch)
+            blockChannels.set(ch, viewChannels[ch] + startIndex);
+
+        if (!active->output.process(blockChannels.getRawDataPointer(), numFrames))
+            active->errorMessage = active->output.getErrorMessage();
+    }
+
+    active->framesConsumed += numFrames;
+}
+
+void CaptureWriter::finishTake()
+{
+    // A stopped take is deleted before the next one opens - a batch started again at once reuses its path
+    if (active->aborted)
+        active->output.abandon();
+
+    // Hand the take over and get back to the FIFO - closing it can take a while
+    finaliserPool.addJob(new FinaliseJob(*this, std::move(active)), true);
+}
+
+//==============================================================================
+// Finaliser Pool
+
+void CaptureWriter::finaliseTake(ActiveTake& finished)
+{
+    const auto& take = finished.take;
+
+    Result result;
+    result.takeId = take.takeId;
+    result.sessionId = take.sessionId;
+    result.fileIndex = take.fileIndex;
+    result.outputFile = take.outputFile;
+
+    bool written = false;
+
+    // A stopped take was abandoned on the writer thread already (see finishTake)
+    if (finished.output.isOpen() && !finished.aborted)
+    {
+        if (finished.output.finish())
+            written = true;
+        else
+            finished.errorMessage = finished.output.getErrorMessage();
+    }
+
+    if (finished.aborted)
+        result.errorMessage = "Capture stopped - " + take.outputFile.getFileName();
+    else if (!written)
+        result.errorMessage = finished.errorMessage;
+    else if (finished.droppedFrames > 0)
+        result.errorMessage = "Capture overrun, " + juce::String(finished.droppedFrames) +
+                              " frames lost - " + take.outputFile.getFileName();
+    else
+        result.succeeded = true;
+
+    result.dcOffsetSkipped = finished.output.isDCOffsetSkipped();
+    result.framesWritten = finished.output.getFramesWritten();
+    postResult(result);
+}
+
+void CaptureWriter::postFailure(const Take& take, const juce::String& errorMessage)
+{
+    Result result;
+    result.takeId = take.takeId;
+    result.sessionId = take.sessionId;
+    result.fileIndex = take.fileIndex;
+    result.outputFile = take.outputFile;
+    result.errorMessage = errorMessage;
+    postResult(result);
+}
+
+void CaptureWriter::postResult(const Result& result)
+{
+    {
+        const juce::ScopedLock sl(resultLock);
+        finishedResults.add(result);
+    }
+
+    triggerAsyncUpdate();
+}
+
+void CaptureWriter::handleAsyncUpdate()
+{
+    juce::Array<Result> results;
+
+    {
+        const juce::ScopedLock sl(resultLock);
+        results.swapWith(finishedResults);
+    }
+
+    for (const auto& result : results)
+    {
+        if (onTakeFinished)
+            onTakeFinished(result);
+    }
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "EngineMessages.h"
+#include "CaptureOutput.h"
+
+//==============================================================================
+/**
+ * Streaming capture writer
+ *
+ * The audio callback pushes captured return audio into a lock-free FIFO and a
+ * dedicated writer thread drains it straight into the output WAV. The latency
+ * skip (see LATENCY_TRIMMING_FIX.md) and the post-processing (see CaptureOutput)
+ * are applied on the fly, so a capture of any length uses constant memory.
+ *
+ * Once a take's last frame has been drained, the writer thread hands the take
+ * over to a small finaliser pool (trailing trim or padding, header patch, flush
+ * and close) and goes straight back to draining the next take, so a slow disk
+ * flush never holds up the FIFO. Several takes can be finalising at once, and
+ * their results may arrive out of capture order.
+ *
+ * Threading:
+ * - queueTake() / prepare() / results: message thread
+ * - beginTake() / pushFrames() / endTake(): audio thread (lock-free, no allocation)
+ * - Draining and processing: writer thread
+ * - Closing finished takes: finaliser pool
+ */
+class CaptureWriter : private juce::Thread,
+                      private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    /** Describes where and how one captured take should be written */
+    struct Take
+    {
+        int takeId = -1;                 // Assigned by queueTake()
+        int sessionId = -1;              // The owner's batch, echoed in the Result so stale takes can be told apart
+        int fileIndex = -1;              // Index into AppState::files
+        juce::File outputFile;
+        double sampleRate = 44100.0;
+        double outputSampleRate = 0.0;   // Rate written to the file, 0 = sampleRate
+        int numChannels = 2;
+        juce::int64 skipFrames = 0;      // Latency to drop from the start of the capture
+        juce::Array<double> channelAdvanceFrames;  // Each return's latency beyond the skip, in (fractional) frames
+        juce::int64 outputFrames = -1;   // Frames to keep after the skip, -1 = keep everything
+        CaptureOutput::Processing processing;
+    };
+
+    /**
+     * Outcome of a take, reported on the message thread
+     * A failed take's output is left for the owner to delete - a later take may already be writing the same path.
+     */
+    struct Result
+    {
+        int takeId = -1;
+        int sessionId = -1;
+        int fileIndex = -1;
+        juce::File outputFile;
+        bool succeeded = false;
+        juce::int64 framesWritten = 0;
+        bool dcOffsetSkipped = false;  // DC removal had no latency region to measure in (see CaptureOutput)
+        juce::String errorMessage;
+    };
+
+    //==============================================================================
+    CaptureWriter();
+    ~CaptureWriter() override;
+
+    /**
+     * Allocates the FIFO and starts the writer thread
+     * Must be called while the audio callback is not capturing (e.g. from prepareToPlay). A take in progress
+     * and takes queued but not yet captured fail (each reports a Result); takes already captured keep
+     * finalising in the background.
+     */
+    void prepare(int numChannels, int fifoFrames);
+
+    /**
+     * Stops the writer thread, abandoning any take in progress; takes already captured are finalised first
+     * Blocks on their disk I/O, so only call this when shutting down.
+     */
+    void release();
+
+    /**
+     * Registers the output settings for a take before the audio thread captures it
+     * @return The take ID to pass to beginTake() from the audio thread
+     */
+    int queueTake(Take take);
+
+    /** Called on the message thread each time a take has been written (or failed) */
+    std::function<void(const Result&)> onTakeFinished;
+
+    //==============================================================================
+    // Audio thread API
+
+    /** Marks the start of a take - every frame pushed until endTake() belongs to it */
+    void beginTake(int takeId) noexcept;
+
+    /** Pushes captured frames, returns false if the FIFO overflowed (frames are dropped) */
+    bool pushFrames(const juce::AudioBuffer<float>& source, int startSample, int numFrames) noexcept;
+
+    /** Marks the end of the current take; aborted takes are deleted rather than kept */
+    void endTake(bool aborted) noexcept;
+
+private:
+    //==============================================================================
+    struct CaptureMarker
+    {
+        enum class Type { begin, end };
+
+        Type type = Type::begin;
+        int takeId = -1;
+        juce::int64 totalFrames = 0;    // Frames actually pushed for the take
+        juce::int64 droppedFrames = 0;  // Frames lost to FIFO overflow
+        bool aborted = false;
+    };
+
+    /** State of the take currently being drained (writer thread only) */
+    struct ActiveTake
+    {
+        Take take;
+        CaptureOutput output;
+        juce::int64 framesConsumed = 0;
+        juce::int64 endFrame = -1;      // Known once the end marker arrives
+        juce::int64 droppedFrames = 0;
+        bool aborted = false;
+        juce::String errorMessage;
+    };
+
+    class FinaliseJob;
+
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    /** Stops the writer thread and abandons the take it was writing */
+    void stopWriterThread();
+
+    bool openTake(int takeId);
+    void consumeFrames(int numFrames);
+    void processBlock(int startIndex, int numFrames);
+    void finishTake();
+    void finaliseTake(ActiveTake& take);
+    void postResult(const Result& result);
+
+    /** Reports a take that was never (completely) written */
+    void postFailure(const Take& take, const juce::String& errorMessage);
+
+    // Audio -> writer
+    juce::AbstractFifo fifo { 1 };
+    juce::AudioBuffer<float> ringBuffer;
+    juce::Array<const float*> ringChannels;  // Fetched once in prepare(), so the writer never touches the buffer object
+    RealtimeMessageQueue<CaptureMarker, 64> markerQueue;
+
+    // Audio thread state
+    bool takeOpen = false;
+    juce::int64 framesPushedInTake = 0;
+    juce::int64 framesDroppedInTake = 0;
+
+    // Message thread -> writer
+    juce::CriticalSection takeLock;
+    juce::Array<Take> pendingTakes;
+    int nextTakeId = 0;
+
+    // Writer -> finaliser pool
+    juce::ThreadPool finaliserPool;
+
+    // Finaliser pool -> message thread
+    juce::CriticalSection resultLock;
+    juce::Array<Result> finishedResults;
+
+    // Writer thread state
+    std::unique_ptr<ActiveTake> active;
+    juce::Array<const float*> viewChannels;   // Ring channel per output channel
+    juce::Array<const float*> blockChannels;  // The same, offset to the block being written
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CaptureWriter)
+};
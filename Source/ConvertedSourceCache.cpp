@@ -0,0 +1,216 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "ConvertedSourceCache.h"
+
+//==============================================================================
+ConvertedSourceCache::ConvertedSourceCache(const juce::File& cacheDirectory)
+    : directory(cacheDirectory)
+{
+}
+
+juce::File ConvertedSourceCache::getDefaultDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("F9 Batch Resampler")
+               .getChildFile("ConvertedSources");
+}
+
+std::unique_ptr<juce::AudioFormatReader> ConvertedSourceCache::createReaderFor(const juce::File& source,
+                                                                               double targetRate,
+                                                                               SampleRateConverter::Quality quality,
+                                                                               juce::AudioFormatManager& formatManager,
+                                                                               juce::String& errorMessage,
+                                                                               bool* wasConverted) const
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(source));
+
+    if (reader == nullptr)
+    {
+        errorMessage = "Could not read file - " + source.getFileName();
+        return nullptr;
+    }
+
+    const bool needsConversion = SampleRateConverter::isNeeded(reader->sampleRate, targetRate);
+
+    if (wasConverted != nullptr)
+        *wasConverted = needsConversion;
+
+    if (!needsConversion)
+        return reader;
+
+    const juce::File cacheFile = getCacheFile(source, targetRate, quality);
+
+    if (cacheFile.existsAsFile())
+    {
+        std::unique_ptr<juce::AudioFormatReader> cachedReader(formatManager.createReaderFor(cacheFile));
+
+        if (cachedReader != nullptr)
+        {
+            cacheFile.setLastAccessTime(juce::Time::getCurrentTime());
+            return cachedReader;
+        }
+
+        // Unreadable (e.g. cut short by a crash) - convert it again
+        cacheFile.deleteFile();
+    }
+
+    if (!convert(*reader, source, cacheFile, targetRate, quality, errorMessage))
+        return nullptr;
+
+    trim();
+
+    std::unique_ptr<juce::AudioFormatReader> convertedReader(formatManager.createReaderFor(cacheFile));
+
+    if (convertedReader == nullptr)
+        errorMessage = "Could not read converted file - " + source.getFileName();
+
+    return convertedReader;
+}
+
+//==============================================================================
+// Conversion
+
+juce::File ConvertedSourceCache::getCacheFile(const juce::File& source, double targetRate,
+                                              SampleRateConverter::Quality quality) const
+{
+    // FNV-1a over everything that makes a conversion different - stable across runs, unlike String::hash()
+    juce::uint64 hash = 0xcbf29ce484222325ull;
+
+    auto add = [&hash](const void* data, size_t numBytes)
+    {
+        for (size_t i = 0; i < numBytes; ++i)
+            hash = (hash ^ static_cast<const juce::uint8*>(data)[i]) * 0x100000001b3ull;
+    };
+
+    const juce::String path = source.getFullPathName();
+    const juce::int64 size = source.getSize();
+    const juce::int64 modificationTime = source.getLastModificationTime().toMilliseconds();
+    const int rate = juce::roundToInt(targetRate);
+    const int qualityIndex = (int)quality;
+
+    add(path.toRawUTF8(), path.getNumBytesAsUTF8());
+    add(&size, sizeof(size));
+    add(&modificationTime, sizeof(modificationTime));
+    add(&rate, sizeof(rate));
+    add(&qualityIndex, sizeof(qualityIndex));
+
+    return directory.getChildFile(juce::String::toHexString((juce::int64)hash).paddedLeft('0', 16) + ".wav");
+}
+
+bool ConvertedSourceCache::convert(juce::AudioFormatReader& reader, const juce::File& source, const juce::File& cacheFile,
+                                   double targetRate, SampleRateConverter::Quality quality, juce::String& errorMessage) const
+{
+    const int numChannels = (int)juce::jlimit(1u, 2u, reader.numChannels);
+
+    if (!directory.createDirectory())
+    {
+        errorMessage = "Could not create the conversion cache - " + directory.getFullPathName();
+        return false;
+    }
+
+    // Written next to its final name and moved into place, so readers never see half a file
+    juce::TemporaryFile tempFile(cacheFile);
+
+    {
+        auto fileStream = std::make_unique<juce::FileOutputStream>(tempFile.getFile());
+
+        if (fileStream->failedToOpen())
+        {
+            errorMessage = "Could not write to the conversion cache - " + cacheFile.getFileName();
+            return false;
+        }
+
+        std::unique_ptr<juce::OutputStream> stream = std::move(fileStream);
+
+        juce::WavAudioFormat wavFormat;
+        auto writer = wavFormat.createWriterFor(
+            stream,
+            juce::AudioFormatWriter::Options{}
+                .withSampleRate(targetRate)
+                .withNumChannels(numChannels)
+                .withBitsPerSample(32)
+                .withSampleFormat(juce::AudioFormatWriter::Options::SampleFormat::floatingPoint)
+        );
+
+        if (writer == nullptr)
+        {
+            errorMessage = "Could not write to the conversion cache - " + cacheFile.getFileName();
+            return false;
+        }
+
+        SampleRateConverter converter(reader.sampleRate, targetRate, numChannels, quality);
+        juce::AudioBuffer<float> input(numChannels, framesPerChunk);
+        juce::AudioBuffer<float> output;
+
+        for (juce::int64 position = 0; position < reader.lengthInSamples; position += framesPerChunk)
+        {
+            const int numFrames = (int)juce::jmin((juce::int64)framesPerChunk, reader.lengthInSamples - position);
+
+            if (!reader.read(&input, 0, numFrames, position, true, true))
+            {
+                errorMessage = "Could not read file for conversion - " + source.getFileName();
+                return false;
+            }
+
+            const int numConverted = converter.process(input.getArrayOfReadPointers(), numFrames, output);
+
+            if (!writer->writeFromAudioSampleBuffer(output, 0, numConverted))
+            {
+                errorMessage = "Disk write failed in the conversion cache - " + cacheFile.getFileName();
+                return false;
+            }
+        }
+
+        const int numFlushed = converter.flush(output);
+
+        if (!writer->writeFromAudioSampleBuffer(output, 0, numFlushed))
+        {
+            errorMessage = "Disk write failed in the conversion cache - " + cacheFile.getFileName();
+            return false;
+        }
+    }
+
+    // Another thread may have finished the same conversion first - its copy is just as good
+    if (!tempFile.overwriteTargetFileWithTemporary() && !cacheFile.existsAsFile())
+    {
+        errorMessage = "Could not store the converted file - " + cacheFile.getFileName();
+        return false;
+    }
+
+    return true;
+}
+
+void ConvertedSourceCache::trim() const
+{
+    juce::Array<juce::File> files = directory.findChildFiles(juce::File::findFiles, false, "*.wav");
+
+    juce::int64 totalBytes = 0;
+    for (const auto& file : files)
+        totalBytes += file.getSize();
+
+    if (totalBytes <= maxCacheBytes)
+        return;
+
+    struct LeastRecentlyUsedFirst
+    {
+        static int compareElements(const juce::File& a, const juce::File& b)
+        {
+            const auto timeA = a.getLastAccessTime();
+            const auto timeB = b.getLastAccessTime();
+            return timeA < timeB ? -1 : (timeB < timeA ? 1 : 0);
+        }
+    };
+
+    LeastRecentlyUsedFirst comparator;
+    files.sort(comparator);
+
+    for (const auto& file : files)
+    {
+        if (totalBytes <= maxCacheBytes)
+            break;
+
+        const juce::int64 size = file.getSize();
+
+        if (file.deleteFile())
+            totalBytes -= size;
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleRateConverter.h"
+
+//==============================================================================
+/**
+ * Disk cache of source files converted to the device rate
+ *
+ * Sources that aren't at the rate the batch runs at are converted once, by
+ * SampleRateConverter, into a 32-bit float WAV in the cache folder and read
+ * from there by every later run. Conversions are keyed by the source's path,
+ * size and modification time plus the target rate and quality, so an edited
+ * source or a different setting converts afresh. The least recently used
+ * conversions are deleted once the folder outgrows its limit.
+ *
+ * Holds no state besides the folder: loader and render threads may each use
+ * their own instance, or share one. Two threads converting the same file at
+ * once both succeed - the second finished copy simply replaces the first.
+ */
+class ConvertedSourceCache
+{
+public:
+    //==============================================================================
+    explicit ConvertedSourceCache(const juce::File& cacheDirectory = getDefaultDirectory());
+
+    /**
+     * Opens a reader that delivers the source at targetRate
+     * That is the source itself if it is already at that rate, otherwise its
+     * cached conversion - converted first (on the calling thread) if there is none yet.
+     * @param wasConverted If given, set to whether the reader delivers a conversion rather than the source
+     * @return nullptr with errorMessage set if the source can't be read or converted
+     */
+    std::unique_ptr<juce::AudioFormatReader> createReaderFor(const juce::File& source,
+                                                             double targetRate,
+                                                             SampleRateConverter::Quality quality,
+                                                             juce::AudioFormatManager& formatManager,
+                                                             juce::String& errorMessage,
+                                                             bool* wasConverted = nullptr) const;
+
+    /** Where the app keeps its conversions */
+    static juce::File getDefaultDirectory();
+
+private:
+    //==============================================================================
+    static constexpr juce::int64 maxCacheBytes = (juce::int64)4 * 1024 * 1024 * 1024;
+    static constexpr int framesPerChunk = 8192;
+
+    juce::File getCacheFile(const juce::File& source, double targetRate, SampleRateConverter::Quality quality) const;
+    bool convert(juce::AudioFormatReader& reader, const juce::File& source, const juce::File& cacheFile,
+                 double targetRate, SampleRateConverter::Quality quality, juce::String& errorMessage) const;
+    void trim() const;
+
+    const juce::File directory;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConvertedSourceCache)
+};
@@ -0,0 +1,283 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "DeviceProber.h"
+
+namespace
+{
+// Bump when the entry layout changes - older caches are then ignored and rebuilt
+constexpr int cacheVersion = 1;
+}
+
+//==============================================================================
+DeviceProber::DeviceProber(juce::AudioDeviceManager& deviceManagerToUse, const juce::File& cacheFileToUse)
+    : juce::Thread("Device Prober"),
+      deviceManager(deviceManagerToUse),
+      cacheFile(cacheFileToUse)
+{
+    // Fresh instances of the platform types - the manager's own stay with the open device
+    deviceManager.createAudioDeviceTypes(deviceTypes);
+
+    loadCache();
+
+    // No scan yet, so waitForScan() before the first rescan() has nothing to wait for
+    scanFinished.signal();
+    startThread();
+}
+
+DeviceProber::~DeviceProber()
+{
+    stopThread(4000);
+    cancelPendingUpdate();
+}
+
+juce::File DeviceProber::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("F9 Batch Resampler")
+               .getChildFile("DeviceCache.json");
+}
+
+void DeviceProber::rescan()
+{
+    {
+        const juce::ScopedLock sl(lock);
+        openTypeName = {};
+        openDevice = {};
+
+        if (auto* open = deviceManager.getCurrentAudioDevice())
+        {
+            openTypeName = deviceManager.getCurrentAudioDeviceType();
+            openDevice = describeDevice(*open, openTypeName, deviceManager.getAudioDeviceSetup().outputDeviceName);
+        }
+    }
+
+    scanFinished.reset();
+    scanPending = true;
+    notify();
+}
+
+bool DeviceProber::waitForScan(int timeoutMs)
+{
+    if (!scanFinished.wait(timeoutMs))
+        return false;
+
+    // Delivers the final results before returning, not at the next message loop pass
+    handleUpdateNowIfNeeded();
+    return true;
+}
+
+juce::Array<AudioDevice> DeviceProber::getDevices() const
+{
+    const juce::ScopedLock sl(lock);
+    return devices;
+}
+
+//==============================================================================
+// Scanning
+
+void DeviceProber::run()
+{
+    while (!threadShouldExit())
+    {
+        if (!scanPending.exchange(false))
+        {
+            wait(-1);
+            continue;
+        }
+
+        scanning = true;
+        scanAllTypes();
+        scanning = false;
+
+        if (threadShouldExit())
+            break;
+
+        // A rescan asked for meanwhile starts straight away and signals when it is done
+        if (!scanPending.load())
+        {
+            scanCompleted = true;
+            triggerAsyncUpdate();
+            scanFinished.signal();
+        }
+    }
+}
+
+void DeviceProber::scanAllTypes()
+{
+    juce::Array<AudioDevice> seen;
+    juce::String skippedTypeName;
+    AudioDevice described;
+
+    {
+        const juce::ScopedLock sl(lock);
+        skippedTypeName = openTypeName;
+        described = openDevice;
+    }
+
+    for (auto* type : deviceTypes)
+    {
+        type->scanForDevices();
+        const bool isOpenType = type->getTypeName() == skippedTypeName;
+
+        for (const auto& name : type->getDeviceNames(false))  // false = output devices
+        {
+            if (threadShouldExit())
+                return;
+
+            AudioDevice device;
+
+            if (!isOpenType)
+            {
+                device = probeDevice(*type, name);
+            }
+            else if (name == described.name)
+            {
+                device = described;
+            }
+            else
+            {
+                // Listed, but not opened next to the running device - the cached entry (if any) stands
+                device.name = name;
+                device.deviceTypeName = type->getTypeName();
+                device.uniqueID = name;
+
+                const juce::ScopedLock sl(lock);
+                const int index = devices.indexOf(device);
+
+                if (index >= 0)
+                    device = devices.getReference(index);
+            }
+
+            seen.add(device);
+
+            // Each device shows up (or is corrected) as soon as it has been probed
+            {
+                const juce::ScopedLock sl(lock);
+                const int index = devices.indexOf(device);
+
+                if (index >= 0)
+                    devices.set(index, device);
+                else
+                    devices.add(device);
+            }
+
+            triggerAsyncUpdate();
+        }
+    }
+
+    // Only a complete pass can tell which devices are gone
+    {
+        const juce::ScopedLock sl(lock);
+        devices.removeIf([&seen](const AudioDevice& device) { return !seen.contains(device); });
+    }
+
+    saveCache();
+}
+
+AudioDevice DeviceProber::probeDevice(juce::AudioIODeviceType& type, const juce::String& name)
+{
+    if (std::unique_ptr<juce::AudioIODevice> probed { type.createDevice(name, name) })
+        return describeDevice(*probed, type.getTypeName(), name);
+
+    AudioDevice device;
+    device.name = name;
+    device.deviceTypeName = type.getTypeName();
+    device.uniqueID = name;
+    return device;
+}
+
+AudioDevice DeviceProber::describeDevice(juce::AudioIODevice& device, const juce::String& typeName, const juce::String& name)
+{
+    AudioDevice described;
+    described.name = name;
+    described.deviceTypeName = typeName;
+
+    // Device type + name together form the unique identifier
+    described.uniqueID = name;
+    described.outputChannelCount = device.getOutputChannelNames().size();
+    described.inputChannelCount = device.getInputChannelNames().size();
+    described.sampleRates = device.getAvailableSampleRates();
+    described.bufferSizes = device.getAvailableBufferSizes();
+    return described;
+}
+
+void DeviceProber::handleAsyncUpdate()
+{
+    const bool finished = scanCompleted.exchange(false);
+
+    if (onDevicesChanged)
+        onDevicesChanged(finished);
+}
+
+//==============================================================================
+// Cache
+
+void DeviceProber::loadCache()
+{
+    const juce::var cache = juce::JSON::parse(cacheFile);
+
+    if ((int)cache.getProperty("version", 0) != cacheVersion)
+        return;
+
+    if (auto* entries = cache.getProperty("devices", {}).getArray())
+    {
+        for (const auto& entry : *entries)
+        {
+            AudioDevice device;
+            device.name = entry.getProperty("name", {}).toString();
+            device.uniqueID = entry.getProperty("id", {}).toString();
+            device.deviceTypeName = entry.getProperty("type", {}).toString();
+            device.inputChannelCount = entry.getProperty("inputs", 0);
+            device.outputChannelCount = entry.getProperty("outputs", 0);
+
+            if (auto* rates = entry.getProperty("sampleRates", {}).getArray())
+                for (const auto& rate : *rates)
+                    device.sampleRates.add((double)rate);
+
+            if (auto* sizes = entry.getProperty("bufferSizes", {}).getArray())
+                for (const auto& size : *sizes)
+                    device.bufferSizes.add((int)size);
+
+            if (device.uniqueID.isNotEmpty() && !devices.contains(device))
+                devices.add(device);
+        }
+    }
+}
+
+void DeviceProber::saveCache() const
+{
+    juce::Array<juce::var> entries;
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        for (const auto& device : devices)
+        {
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty("type", device.deviceTypeName);
+            entry->setProperty("name", device.name);
+            entry->setProperty("id", device.uniqueID);
+            entry->setProperty("inputs", device.inputChannelCount);
+            entry->setProperty("outputs", device.outputChannelCount);
+
+            juce::Array<juce::var> rates, sizes;
+
+            for (auto rate : device.sampleRates)
+                rates.add(rate);
+
+            for (auto size : device.bufferSizes)
+                sizes.add(size);
+
+            entry->setProperty("sampleRates", rates);
+            entry->setProperty("bufferSizes", sizes);
+            entries.add(juce::var(entry));
+        }
+    }
+
+    auto* cache = new juce::DynamicObject();
+    cache->setProperty("version", cacheVersion);
+    cache->setProperty("devices", entries);
+
+    // A cache that can't be written only costs the next startup its head start
+    cacheFile.getParentDirectory().createDirectory();
+    cacheFile.replaceWithText(juce::JSON::toString(juce::var(cache)));
+}
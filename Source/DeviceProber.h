@@ -0,0 +1,85 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AppState.h"
+
+//==============================================================================
+/**
+ * Background audio device discovery with a persistent capability cache
+ *
+ * Scanning every device type and opening each device just to count its
+ * channels takes seconds with several interfaces (or ALSA/JACK) attached, so
+ * it happens on a thread of its own. What was learned - channel counts,
+ * sample rates and buffer sizes - is cached per device in a small JSON file,
+ * and getDevices() starts out from that cache, so the device list is there
+ * at once on startup. Each rescan then updates the list one device at a
+ * time, and drops devices that are gone once the pass is complete.
+ *
+ * The prober creates its own AudioIODeviceType objects rather than using the
+ * device manager's. Devices of the type that is open are still never opened
+ * from the prober's thread - ASIO loads one driver per process, and drivers
+ * don't expect a second instance next to the running one. The open device is
+ * described from the device manager on the message thread when the scan
+ * starts; the type's other devices keep their cached entry.
+ *
+ * Threading: rescan() / getDevices() / results on the message thread,
+ * scanning and probing on the prober's thread.
+ */
+class DeviceProber : private juce::Thread,
+                     private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    /** Creates the platform device types and loads the cache (message thread) */
+    explicit DeviceProber(juce::AudioDeviceManager& deviceManager, const juce::File& cacheFile = getDefaultFile());
+    ~DeviceProber() override;
+
+    /** Starts a scan in the background; a scan already running starts over when it is done */
+    void rescan();
+
+    /** Blocks until the current scan has finished and its results are delivered - for the headless runner */
+    bool waitForScan(int timeoutMs);
+
+    /** Every device known so far, cached or probed, in type order */
+    juce::Array<AudioDevice> getDevices() const;
+
+    bool isScanning() const noexcept { return scanPending.load() || scanning.load(); }
+
+    /** Called on the message thread whenever the list has changed - scanFinished is set once a complete pass is in */
+    std::function<void(bool scanFinished)> onDevicesChanged;
+
+    /** Opens a device just long enough to read its channels, sample rates and buffer sizes */
+    static AudioDevice probeDevice(juce::AudioIODeviceType& type, const juce::String& name);
+
+    /** Reads the channels, sample rates and buffer sizes of a device that is already open, listed as name */
+    static AudioDevice describeDevice(juce::AudioIODevice& device, const juce::String& typeName, const juce::String& name);
+
+    /** Where the app keeps its device cache */
+    static juce::File getDefaultFile();
+
+private:
+    //==============================================================================
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    void scanAllTypes();
+
+    void loadCache();
+    void saveCache() const;
+
+    juce::AudioDeviceManager& deviceManager;
+    const juce::File cacheFile;
+    juce::OwnedArray<juce::AudioIODeviceType> deviceTypes;  // Prober thread only, once running
+
+    mutable juce::CriticalSection lock;
+    juce::Array<AudioDevice> devices;
+    juce::String openTypeName;  // Type of the device manager's open device at rescan() - not probed
+    AudioDevice openDevice;     // That device, as described on the message thread
+
+    std::atomic<bool> scanPending { false };
+    std::atomic<bool> scanning { false };
+    std::atomic<bool> scanCompleted { false };  // Reported with the next update
+    juce::WaitableEvent scanFinished { true };  // Manual reset: signalled while idle (from construction on)
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeviceProber)
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+//==============================================================================
+/**
+ * Single-producer / single-consumer lock-free message queue
+ *
+ * Used to pass small POD-style messages between the message thread and the
+ * audio callback without locks or allocation. One thread may push, one other
+ * thread may pop. push() fails (returns false) when the queue is full rather
+ * than blocking, so it is safe to call from the audio thread.
+ */
+template <typename MessageType, int Capacity>
+class RealtimeMessageQueue
+{
+public:
+    RealtimeMessageQueue() = default;
+
+    /** Pushes a message, returns false if the queue is full */
+    bool push(const MessageType& message) noexcept
+    {
+        const auto scope = fifo.write(1);
+
+        if (scope.blockSize1 > 0)
+        {
+            messages[(size_t)scope.startIndex1] = message;
+            return true;
+        }
+
+        if (scope.blockSize2 > 0)
+        {
+            messages[(size_t)scope.startIndex2] = message;
+            return true;
+        }
+
+        return false;
+    }
+
+    /** Pops the oldest message, returns false if the queue is empty */
+    bool pop(MessageType& message) noexcept
+    {
+        const auto scope = fifo.read(1);
+
+        if (scope.blockSize1 > 0)
+        {
+            message = messages[(size_t)scope.startIndex1];
+            return true;
+        }
+
+        if (scope.blockSize2 > 0)
+        {
+            message = messages[(size_t)scope.startIndex2];
+            return true;
+        }
+
+        return false;
+    }
+
+    /** Discards all pending messages (consumer side only) */
+    void clear() noexcept
+    {
+        MessageType discarded;
+        while (pop(discarded)) {}
+    }
+
+    int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+private:
+    juce::AbstractFifo fifo { Capacity };
+    std::array<MessageType, (size_t)Capacity> messages {};
+
+    JUCE_DECLARE_NON_COPYABLE(RealtimeMessageQueue)
+};
+
+//==============================================================================
+/**
+ * Command sent from the message thread to the audio callback
+ *
+ * All parameters the audio thread needs are carried in the command itself, so
+ * the callback never reads AppState flags or settings directly.
+ */
+struct EngineCommand
+{
+    enum class Type
+    {
+        stop,                    // Return to idle immediately
+        startProcessingFile,     // Play + capture the armed playback buffer
+        startPreviewFile,        // Play the armed playback buffer only
+        startLatencyMeasurement, // Send the measurement sequence and capture the return
+        startHardwareTest,       // Continuous 1 kHz sine
+        startImpulseResponseCapture, // Send the sweep stimulus and capture the return
+        startRouteCalibration,   // Send the shifted sequence on every output pair and capture every input
+        closeTake                // One-take mode: end the continuous take once the armed files have played
+    };
+
+    Type type = Type::stop;
+    int sessionId = 0;                  // Batch/preview session, echoed back in events
+    int fileIndex = -1;                 // Index into AppState::files (or preview playlist)
+    int takeId = -1;                    // CaptureWriter take for startProcessingFile
+    bool queueAfterCurrent = false;     // Start when the playing file finishes instead of interrupting it
+    bool continuousTake = false;        // One-take mode: takeId stays open across files until closeTake
+    juce::AudioBuffer<float>* playbackBuffer = nullptr;  // Prefetched source, owned by PlaybackLoader
+    juce::AudioBuffer<float>* captureBuffer = nullptr;   // Latency/impulse response capture destination, owned by the engine
+    juce::int64 preRollFrames = 0;      // Silence before the file when the engine starts from idle
+    juce::int64 playbackFrames = 0;     // Frames of source audio to send
+    juce::int64 captureFrames = 0;      // Frames to capture from the start of playback (upper bound in reverb mode)
+    juce::int64 gapFrames = 0;          // Silence after the capture before the next file
+    bool stopOnNoiseFloor = false;      // Reverb mode: end capture once the tail decays
+    float noiseFloorThresholdDb = -80.0f;
+    juce::int64 codeSpacingFrames = 0;  // Route calibration: cyclic shift of each output pair's sequence from the previous pair's
+    juce::int64 prefixFrames = 0;       // Route calibration: frames sent before the capture starts
+    juce::uint64 silentOutputPairs = 0; // Route calibration: one bit per output pair kept silent (the monitors)
+    juce::int64 issuedAtSample = 0;     // Engine sample clock when the command was sent
+};
+
+//==============================================================================
+/**
+ * Event sent from the audio callback back to the message thread
+ *
+ * samplePosition is the engine sample clock at the exact frame the event
+ * happened (not the start of the block), so the orchestrator can react with
+ * sample accuracy.
+ */
+struct EngineEvent
+{
+    enum class Type
+    {
+        fileFinished,            // Capture for fileIndex complete, value = frames captured
+        previewFileFinished,     // Preview playback for fileIndex complete
+        latencyCaptureComplete,  // Sequence capture buffer full, value = frames captured
+        xrun,                    // Device reported a dropout, value = total xrun count
+        playbackReleased,        // Audio thread no longer reads playbackBuffer
+        segmentStarted,          // One-take mode: send of fileIndex started, value = frames into the take
+        impulseResponseCaptureComplete, // Sweep capture buffer full, value = frames captured
+        routeCalibrationCaptureComplete, // Every input's period captured, value = frames captured
+        engineReset              // Device restarted, engine back to idle, value = 1 if an operation was cut short
+    };
+
+    Type type = Type::fileFinished;
+    int sessionId = 0;
+    int fileIndex = -1;
+    juce::int64 samplePosition = 0;
+    juce::int64 value = 0;
+    juce::AudioBuffer<float>* playbackBuffer = nullptr;
+};
+
+using EngineCommandQueue = RealtimeMessageQueue<EngineCommand, 64>;
+using EngineEventQueue = RealtimeMessageQueue<EngineEvent, 256>;
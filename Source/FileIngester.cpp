@@ -0,0 +1,149 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "FileIngester.h"
+
+namespace
+{
+// Probing is mostly waiting on the disk, so a few more threads than cores still pay off
+// on network volumes, but not so many that a local SSD thrashes
+int getNumIngestThreads()
+{
+    return juce::jlimit(2, 8, juce::SystemStats::getNumCpus());
+}
+}
+
+//==============================================================================
+FileIngester::FileIngester(MetadataIndex& metadataIndexToUse)
+    : metadataIndex(metadataIndexToUse),
+      pool(juce::ThreadPoolOptions{}.withThreadName("File Ingester")
+                                    .withNumberOfThreads(getNumIngestThreads()))
+{
+}
+
+FileIngester::~FileIngester()
+{
+    cancel();
+    cancelPendingUpdate();
+}
+
+bool FileIngester::isAudioFile(const juce::File& file)
+{
+    return file.hasFileExtension(".wav;.aif;.aiff");
+}
+
+void FileIngester::addPaths(const juce::Array<juce::File>& filesOrFolders)
+{
+    const int generation = currentGeneration.load();
+
+    for (const auto& path : filesOrFolders)
+    {
+        if (path.isDirectory())
+        {
+            ++pendingJobs;
+            pool.addJob([this, path, generation] { walkFolder(path, generation); });
+        }
+        else if (isAudioFile(path))
+        {
+            queueProbe(path, generation);
+        }
+    }
+}
+
+void FileIngester::cancel()
+{
+    ++currentGeneration;
+
+    // Running jobs see the new generation and return early
+    pool.removeAllJobs(true, 4000);
+
+    pendingJobs = 0;
+    pendingFiles = 0;
+
+    const juce::ScopedLock sl(resultLock);
+    finishedResults.clear();
+}
+
+//==============================================================================
+// Pool
+
+void FileIngester::queueProbe(const juce::File& file, int generation)
+{
+    const juce::int64 order = nextOrder++;
+
+    ++pendingJobs;
+    ++pendingFiles;
+    pool.addJob([this, file, order, generation] { probeFile(file, order, generation); });
+}
+
+void FileIngester::walkFolder(const juce::File& folder, int generation)
+{
+    for (const auto& entry : juce::RangedDirectoryIterator(folder, true, audioFileWildcard, juce::File::findFiles))
+    {
+        if (currentGeneration.load() != generation)
+            return;
+
+        // Skips dot files such as macOS "._" resource forks, which match the wildcard but aren't audio
+        if (!entry.isHidden())
+            queueProbe(entry.getFile(), generation);
+    }
+
+    jobFinished(generation);
+    triggerAsyncUpdate();
+}
+
+void FileIngester::probeFile(const juce::File& file, juce::int64 order, int generation)
+{
+    if (currentGeneration.load() != generation)
+        return;
+
+    Result result;
+    result.file = file;
+    result.metadata = metadataIndex.getMetadata(file);
+    result.order = order;
+
+    {
+        const juce::ScopedLock sl(resultLock);
+
+        if (currentGeneration.load() != generation)
+            return;
+
+        finishedResults.add(result);
+    }
+
+    jobFinished(generation);
+    triggerAsyncUpdate();
+}
+
+void FileIngester::jobFinished(int generation)
+{
+    if (currentGeneration.load() == generation)
+        --pendingJobs;
+}
+
+//==============================================================================
+// Message Thread
+
+void FileIngester::handleAsyncUpdate()
+{
+    juce::Array<Result> results;
+
+    {
+        const juce::ScopedLock sl(resultLock);
+        results.swapWith(finishedResults);
+    }
+
+    pendingFiles -= results.size();
+
+    struct DiscoveryOrder
+    {
+        static int compareElements(const Result& a, const Result& b)
+        {
+            return a.order < b.order ? -1 : (a.order > b.order ? 1 : 0);
+        }
+    };
+
+    DiscoveryOrder comparator;
+    results.sort(comparator);
+
+    if (onFilesProbed)
+        onFilesProbed(results);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AppState.h"
+#include "MetadataIndex.h"
+
+//==============================================================================
+/**
+ * Background file ingestion for drag and drop
+ *
+ * Dropped folders are walked recursively and every supported audio file is
+ * looked up in the metadata index - or, if it is new or has changed, has its
+ * header probed - on a small thread pool, so adding tens of thousands of files
+ * never blocks the message thread. Results are collected and delivered in batches as they arrive, each
+ * batch in the order the files were found; files from different batches may
+ * interleave.
+ *
+ * Threading: addPaths() / cancel() / results on the message thread, walking
+ * and probing on the pool.
+ */
+class FileIngester : private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    /** One probed file */
+    struct Result
+    {
+        juce::File file;
+        AudioFile::Metadata metadata;
+        juce::int64 order = 0;  // Position in discovery order
+    };
+
+    //==============================================================================
+    explicit FileIngester(MetadataIndex& metadataIndex);
+    ~FileIngester() override;
+
+    /** Queues files and folders (walked recursively) for probing */
+    void addPaths(const juce::Array<juce::File>& filesOrFolders);
+
+    /** Drops everything not yet delivered; results of earlier calls are never reported */
+    void cancel();
+
+    /** Files found but not yet delivered (folders still being walked are not counted yet) */
+    int getNumPending() const noexcept  { return juce::jmax(0, pendingFiles.load()); }
+
+    bool isBusy() const noexcept        { return pendingJobs.load() > 0; }
+
+    /** Called on the message thread with each batch of probed files (may be empty - getNumPending() changed) */
+    std::function<void(const juce::Array<Result>&)> onFilesProbed;
+
+    /** Extensions accepted from drops and folder walks */
+    static constexpr const char* audioFileWildcard = "*.wav;*.aif;*.aiff";
+
+    static bool isAudioFile(const juce::File& file);
+
+private:
+    //==============================================================================
+    void handleAsyncUpdate() override;
+
+    void queueProbe(const juce::File& file, int generation);
+    void walkFolder(const juce::File& folder, int generation);
+    void probeFile(const juce::File& file, juce::int64 order, int generation);
+    void jobFinished(int generation);
+
+    MetadataIndex& metadataIndex;
+    juce::ThreadPool pool;
+
+    // Bumped by cancel() - jobs of an older generation stop and report nothing
+    std::atomic<int> currentGeneration { 0 };
+    std::atomic<int> pendingJobs { 0 };
+    std::atomic<int> pendingFiles { 0 };
+    std::atomic<juce::int64> nextOrder { 0 };
+
+    // Pool -> message thread
+    juce::CriticalSection resultLock;
+    juce::Array<Result> finishedResults;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FileIngester)
+};
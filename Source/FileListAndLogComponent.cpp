@@ -1,5 +1,6 @@
 #include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
 #include "FileListAndLogComponent.h"
+#include "FileIngester.h"
 
 namespace
 {
@@ -17,6 +18,20 @@ juce::String makeUTF8(const char* text)
 {
     return juce::String{ juce::CharPointer_UTF8(text) };
 }
+
+enum ColumnId
+{
+    statusColumn = 1,
+    nameColumn,
+    sampleRateColumn,
+    durationColumn
+};
+
+constexpr int fileRowHeight = 40;
+
+// The log view is rebuilt from the (shorter) retained history once it holds this many lines
+constexpr int maxLogDisplayLines = 5000;
+constexpr int fileCountHeight = 24;
 }
 
 //==============================================================================
@@ -51,6 +66,20 @@ FileListAndLogComponent::FileListAndLogComponent(AppState& state)
     fileCountLabel.setJustificationType(juce::Justification::centred);
     fileCountLabel.setColour(juce::Label::textColourId, juce::Colour(0xff86868b));
     addAndMakeVisible(fileCountLabel);
+
+    // File list - hidden until there is something to show
+    auto& header = fileTable.getHeader();
+    header.addColumn({}, statusColumn, 30, 30, 30, juce::TableHeaderComponent::notResizable);
+    header.addColumn("Name", nameColumn, 300, 100, -1, juce::TableHeaderComponent::defaultFlags);
+    header.addColumn("Rate", sampleRateColumn, 70, 60, 120, juce::TableHeaderComponent::defaultFlags);
+    header.addColumn("Length", durationColumn, 70, 60, 120, juce::TableHeaderComponent::defaultFlags);
+    header.setStretchToFitActive(true);
+
+    fileTable.setModel(this);
+    fileTable.setRowHeight(fileRowHeight);
+    fileTable.setMultipleSelectionEnabled(true);
+    fileTable.setColour(juce::ListBox::backgroundColourId, juce::Colours::white);
+    addChildComponent(fileTable);
 }
 
 FileListAndLogComponent::~FileListAndLogComponent()
@@ -74,15 +103,11 @@ void FileListAndLogComponent::paint(juce::Graphics& g)
     bounds.removeFromBottom(buttonAreaHeight);  // Reserve space for buttons (layout handled in resized())
     auto logBounds = bounds.removeFromBottom(logAreaHeight);
 
-    // Draw file area
+    // Draw file area (the list is a child component)
     if (appState.files.isEmpty())
     {
         drawDropZone(g, fileAreaBounds.reduced(20));
     }
-    else
-    {
-        drawFileList(g, fileAreaBounds);
-    }
 
     // Draw log section header
     g.setColour(juce::Colour(0xfff5f5f7));
@@ -121,11 +146,17 @@ void FileListAndLogComponent::resized()
     copyLogButton.setBounds(logHeaderBounds.removeFromRight(80).reduced(0, 5));
     logDisplay.setBounds(logBounds);
 
-    // File count label (centered in drop zone when no files)
+    // File count label (centered in drop zone when no files, above the list otherwise)
     if (appState.files.isEmpty())
     {
         fileCountLabel.setBounds(dropZoneBounds.withSizeKeepingCentre(300, 40));
     }
+    else
+    {
+        auto listBounds = fileAreaBounds.reduced(10);
+        fileCountLabel.setBounds(listBounds.removeFromTop(fileCountHeight));
+        fileTable.setBounds(listBounds);
+    }
 }
 
 void FileListAndLogComponent::buttonClicked(juce::Button* button)
@@ -149,10 +180,11 @@ void FileListAndLogComponent::buttonClicked(juce::Button* button)
 
 bool FileListAndLogComponent::isInterestedInFileDrag(const juce::StringArray& files)
 {
-    // Accept audio files
+    // Accept audio files and folders (searched recursively)
     for (const auto& file : files)
     {
-        if (file.endsWith(".wav") || file.endsWith(".aif") || file.endsWith(".aiff"))
+        const juce::File f(file);
+        if (f.isDirectory() || FileIngester::isAudioFile(f))
             return true;
     }
     return false;
@@ -166,7 +198,7 @@ void FileListAndLogComponent::filesDropped(const juce::StringArray& files, int x
     for (const auto& file : files)
     {
         juce::File f(file);
-        if (f.hasFileExtension(".wav;.aif;.aiff"))
+        if (f.isDirectory() || FileIngester::isAudioFile(f))
         {
             audioFiles.add(f);
         }
@@ -194,31 +226,83 @@ void FileListAndLogComponent::fileDragExit(const juce::StringArray&)
 
 void FileListAndLogComponent::updateFromState()
 {
-    // Update file count
-    if (appState.files.isEmpty())
-    {
-        fileCountLabel.setText("No files added", juce::dontSendNotification);
-    }
-    else
+    const bool filesChanged = stateWatcher.hasChanged(appState, StateSection::files);
+    const bool progressChanged = stateWatcher.hasChanged(appState, StateSection::progress);
+    const bool settingsChanged = stateWatcher.hasChanged(appState, StateSection::settings);
+
+    // The rate column is coloured against the device rate
+    if (settingsChanged && !filesChanged)
+        fileTable.repaint();
+
+    if (filesChanged)
     {
-        fileCountLabel.setText(juce::String(appState.files.size()) + " file(s) added",
-                              juce::dontSendNotification);
+        // Only the row count is pushed to the list - rows read the state as they paint
+        if (appState.files.size() != lastFileCount)
+        {
+            const bool wasEmpty = lastFileCount <= 0;
+            lastFileCount = appState.files.size();
+
+            fileTable.updateContent();
+            fileTable.setVisible(lastFileCount > 0);
+
+            if (wasEmpty != (lastFileCount == 0))
+            {
+                resized();
+                repaint();  // Drop zone appears or goes
+            }
+        }
+
+        fileTable.repaint();
+
+        // Update file count
+        if (appState.files.isEmpty() && appState.filesBeingAdded == 0)
+        {
+            fileCountLabel.setText("No files added", juce::dontSendNotification);
+        }
+        else
+        {
+            juce::String countText = juce::String(appState.files.size()) + " file(s) added";
+
+            if (appState.filesBeingAdded > 0)
+                countText += ", reading " + juce::String(appState.filesBeingAdded) + " more";
+
+            fileCountLabel.setText(countText, juce::dontSendNotification);
+        }
     }
 
-    // Update log
-    juce::String logText;
-    for (const auto& line : appState.logLines)
+    // Update log - only new lines are appended, and the buffer is only asked when there are some
+    const juce::uint64 linesAppended = appState.logBuffer.getNumLinesAppended();
+
+    if (linesAppended != lastLogLinesAppended)
     {
-        logText += line + "\n";
+        lastLogLinesAppended = linesAppended;
+        const auto newLogLines = appState.logBuffer.getLinesSince(nextLogLine);
+
+        if (!newLogLines.isEmpty())
+        {
+            if (logDisplayLines + newLogLines.size() > maxLogDisplayLines)
+            {
+                const auto retainedLines = appState.logBuffer.getRetainedLines();
+                logDisplay.setText(retainedLines.joinIntoString("\n") + "\n", false);
+                logDisplayLines = retainedLines.size();
+            }
+            else
+            {
+                logDisplay.moveCaretToEnd();
+                logDisplay.insertTextAtCaret(newLogLines.joinIntoString("\n") + "\n");
+                logDisplayLines += newLogLines.size();
+            }
+
+            logDisplay.moveCaretToEnd();
+        }
     }
-    logDisplay.setText(logText, false);
-    logDisplay.moveCaretToEnd();
 
     // Update button states
-    previewButton.setEnabled(!appState.files.isEmpty() && !appState.isProcessing);
-    processAllButton.setEnabled(!appState.files.isEmpty() && !appState.isProcessing);
-
-    repaint();
+    if (filesChanged || progressChanged)
+    {
+        previewButton.setEnabled(!appState.files.isEmpty() && !appState.isProcessing);
+        processAllButton.setEnabled(!appState.files.isEmpty() && !appState.isProcessing);
+    }
 }
 
 void FileListAndLogComponent::drawDropZone(juce::Graphics& g, juce::Rectangle<int> bounds)
@@ -270,74 +354,141 @@ void FileListAndLogComponent::drawDropZone(juce::Graphics& g, juce::Rectangle<in
     g.drawText("Drag audio files here", centerBounds.removeFromTop(25), juce::Justification::centred);
 }
 
-void FileListAndLogComponent::drawFileList(juce::Graphics& g, juce::Rectangle<int> bounds)
+//==============================================================================
+// File List
+
+int FileListAndLogComponent::getNumRows()
 {
-    bounds = bounds.reduced(10);
-    int yPos = bounds.getY();
-    int itemHeight = 40;
+    return appState.files.size();
+}
 
-    for (int i = 0; i < appState.files.size(); ++i)
+void FileListAndLogComponent::paintRowBackground(juce::Graphics& g, int rowNumber, int width, int height, bool rowIsSelected)
+{
+    juce::ignoreUnused(rowNumber);
+
+    if (rowIsSelected)
     {
-        const auto& file = appState.files.getReference(i);
+        g.setColour(juce::Colour(0xff007aff).withAlpha(0.1f));
+        g.fillRoundedRectangle(0.0f, 0.0f, (float)width, (float)height, 4.0f);
+    }
+}
 
-        if (yPos + itemHeight > bounds.getBottom())
-            break;
+void FileListAndLogComponent::paintCell(juce::Graphics& g, int rowNumber, int columnId, int width, int height, bool rowIsSelected)
+{
+    juce::ignoreUnused(rowIsSelected);
 
-        juce::Rectangle<int> itemBounds(bounds.getX(), yPos, bounds.getWidth(), itemHeight);
+    if (!juce::isPositiveAndBelow(rowNumber, appState.files.size()))
+        return;
 
-        // Background
-        if (file.isSelected)
-        {
-            g.setColour(juce::Colour(0xff007aff).withAlpha(0.1f));
-            g.fillRoundedRectangle(itemBounds.toFloat(), 4.0f);
-        }
+    const auto& file = appState.files.getReference(rowNumber);
+    const juce::Rectangle<int> cellBounds(0, 0, width, height);
 
-        // Status indicator
-        juce::Colour statusColour;
-        juce::String statusText;
-        switch (file.status)
+    switch (columnId)
+    {
+        case statusColumn:
         {
-            case ProcessingStatus::pending:
-                statusColour = juce::Colour(0xff86868b);
-                statusText = makeUTF8("\xE2\x8F\xB8"); // ⏸
-                break;
-            case ProcessingStatus::processing:
-                statusColour = juce::Colour(0xff007aff);
-                statusText = makeUTF8("\xE2\x9A\x99"); // ⚙
-                break;
-            case ProcessingStatus::completed:
-                statusColour = juce::Colour(0xff34c759);
-                statusText = makeUTF8("\xE2\x9C\x93"); // ✓
-                break;
-            case ProcessingStatus::failed:
-                statusColour = juce::Colour(0xffff3b30);
-                statusText = makeUTF8("\xE2\x9C\x97"); // ✗
-                break;
-            case ProcessingStatus::invalidSampleRate:
-                statusColour = juce::Colour(0xffff9500);
-                statusText = makeUTF8("\xE2\x9A\xA0"); // ⚠
-                break;
+            juce::Colour statusColour;
+            juce::String statusText;
+            switch (file.status)
+            {
+                case ProcessingStatus::pending:
+                    statusColour = juce::Colour(0xff86868b);
+                    statusText = makeUTF8("\xE2\x8F\xB8"); // ⏸
+                    break;
+                case ProcessingStatus::processing:
+                    statusColour = juce::Colour(0xff007aff);
+                    statusText = makeUTF8("\xE2\x9A\x99"); // ⚙
+                    break;
+                case ProcessingStatus::finalising:
+                    statusColour = juce::Colour(0xff5ac8fa);
+                    statusText = makeUTF8("\xE2\x86\x93"); // ↓
+                    break;
+                case ProcessingStatus::completed:
+                    statusColour = juce::Colour(0xff34c759);
+                    statusText = makeUTF8("\xE2\x9C\x93"); // ✓
+                    break;
+                case ProcessingStatus::failed:
+                    statusColour = juce::Colour(0xffff3b30);
+                    statusText = makeUTF8("\xE2\x9C\x97"); // ✗
+                    break;
+                case ProcessingStatus::invalidSampleRate:
+                    statusColour = juce::Colour(0xffff9500);
+                    statusText = makeUTF8("\xE2\x9A\xA0"); // ⚠
+                    break;
+            }
+
+            g.setColour(statusColour);
+            g.setFont(makeFont(18.0f));
+            g.drawText(statusText, cellBounds, juce::Justification::centred);
+            break;
         }
 
-        g.setColour(statusColour);
-        g.setFont(makeFont(18.0f));
-        g.drawText(statusText, itemBounds.removeFromLeft(30), juce::Justification::centred);
+        case nameColumn:
+            g.setColour(juce::Colour(0xff1d1d1f));
+            g.setFont(makeFont(13.0f));
+            g.drawText(file.getFileName(), cellBounds, juce::Justification::centredLeft, true);
+            break;
 
-        // Filename
-        g.setColour(juce::Colour(0xff1d1d1f));
-        g.setFont(makeFont(13.0f));
-        auto nameBounds = itemBounds.removeFromLeft(itemBounds.getWidth() - 120);
-        g.drawText(file.getFileName(), nameBounds, juce::Justification::centredLeft, true);
+        case sampleRateColumn:
+            if (file.sampleRate > 0)
+            {
+                // Green plays as is, orange is converted to the device rate on load
+                g.setColour(!file.isValid() ? juce::Colour(0xffff3b30)
+                                            : file.needsConversion(appState.settings.sampleRate) ? juce::Colour(0xffff9500)
+                                                                                                 : juce::Colour(0xff34c759));
+                g.setFont(makeFont(11.0f));
+                g.drawText(juce::String(file.sampleRate / 1000.0, 1) + " kHz",
+                          cellBounds.reduced(4, 0), juce::Justification::centredRight);
+            }
+            break;
 
-        // Sample rate
-        if (file.sampleRate > 0)
-        {
-            g.setColour(file.isValid() ? juce::Colour(0xff34c759) : juce::Colour(0xffff3b30));
-            g.setFont(makeFont(11.0f));
-            g.drawText(juce::String(file.sampleRate / 1000.0, 1) + " kHz",
-                      itemBounds, juce::Justification::centredRight);
-        }
+        case durationColumn:
+            if (file.sampleRate > 0)
+            {
+                const double seconds = (double)file.durationSamples / file.sampleRate;
+                g.setColour(juce::Colour(0xff86868b));
+                g.setFont(makeFont(11.0f));
+                g.drawText(juce::String((int)seconds / 60) + ":" + juce::String((int)seconds % 60).paddedLeft('0', 2),
+                          cellBounds.reduced(4, 0), juce::Justification::centredRight);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void FileListAndLogComponent::selectedRowsChanged(int)
+{
+    if (onSelectionChanged)
+        onSelectionChanged(fileTable.getSelectedRows());
+}
+
+void FileListAndLogComponent::sortOrderChanged(int newSortColumnId, bool isForwards)
+{
+    if (onSortRequested == nullptr)
+        return;
 
-        yPos += itemHeight;
+    switch (newSortColumnId)
+    {
+        case nameColumn:       onSortRequested(FileSortKey::name, isForwards); break;
+        case sampleRateColumn: onSortRequested(FileSortKey::sampleRate, isForwards); break;
+        case durationColumn:   onSortRequested(FileSortKey::duration, isForwards); break;
+        default:               onSortRequested(FileSortKey::status, isForwards); break;
     }
+
+    // Rows now show different files - move the selection with them
+    syncSelectionFromState();
+    fileTable.repaint();
+}
+
+void FileListAndLogComponent::syncSelectionFromState()
+{
+    juce::SparseSet<int> selectedRows;
+
+    for (int i = 0; i < appState.files.size(); ++i)
+        if (appState.files.getReference(i).isSelected)
+            selectedRows.addRange({ i, i + 1 });
+
+    fileTable.setSelectedRows(selectedRows, juce::dontSendNotification);
 }
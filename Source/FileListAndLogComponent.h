@@ -8,10 +8,14 @@
  * File List and Log Component - Main content area
  * Combines file drop zone, file list, and log display
  * Port of Swift's FileListView and log display
+ *
+ * The file list is a virtualised TableListBox: only visible rows are painted,
+ * so the cost of a repaint does not depend on how many files are queued.
  */
 class FileListAndLogComponent : public juce::Component,
                                  public juce::FileDragAndDropTarget,
-                                 public juce::Button::Listener
+                                 public juce::Button::Listener,
+                                 private juce::TableListBoxModel
 {
 public:
     FileListAndLogComponent(AppState& state);
@@ -37,6 +41,8 @@ public:
     std::function<void()> onPreviewClicked;
     std::function<void()> onProcessAllClicked;
     std::function<void()> onCopyLog;
+    std::function<void(const juce::SparseSet<int>& selectedRows)> onSelectionChanged;
+    std::function<void(FileSortKey key, bool ascending)> onSortRequested;
 
 private:
     AppState& appState;
@@ -52,12 +58,31 @@ private:
 
     // Log display
     juce::TextEditor logDisplay;
+    juce::int64 nextLogLine = 0;
+    int logDisplayLines = 0;
+    juce::uint64 lastLogLinesAppended = 0;  // LogBuffer counter at the last fetch
+
+    // Change tracking - updateFromState() only touches what moved
+    StateWatcher stateWatcher;
 
     // File count label
     juce::Label fileCountLabel;
 
+    // File list
+    juce::TableListBox fileTable;
+    int lastFileCount = -1;
+
+    // TableListBoxModel
+    int getNumRows() override;
+    void paintRowBackground(juce::Graphics& g, int rowNumber, int width, int height, bool rowIsSelected) override;
+    void paintCell(juce::Graphics& g, int rowNumber, int columnId, int width, int height, bool rowIsSelected) override;
+    void selectedRowsChanged(int lastRowSelected) override;
+    void sortOrderChanged(int newSortColumnId, bool isForwards) override;
+
+    /** Selects the rows whose files are marked selected (after the order changed) */
+    void syncSelectionFromState();
+
     void drawDropZone(juce::Graphics& g, juce::Rectangle<int> bounds);
-    void drawFileList(juce::Graphics& g, juce::Rectangle<int> bounds);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FileListAndLogComponent)
 };
@@ -0,0 +1,206 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "FractionalDelay.h"
+
+namespace
+{
+// ~80 dB sidelobes; with 32 taps the response is flat to within 0.1 dB up to ~85% of Nyquist
+constexpr double kaiserBeta = 8.0;
+
+// Advances closer than this to a whole frame are treated as whole
+constexpr double wholeFrameTolerance = 1.0e-4;
+
+// Zeroth-order modified Bessel function of the first kind, for the Kaiser window
+double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+
+    for (int k = 1; k < 50 && term > sum * 1.0e-12; ++k)
+    {
+        const double half = x / (2.0 * k);
+        term *= half * half;
+        sum += term;
+    }
+
+    return sum;
+}
+}
+
+//==============================================================================
+FractionalDelay::FractionalDelay(int numChannelsToUse, const juce::Array<double>& advanceFrames)
+    : numChannels(juce::jmax(1, numChannelsToUse))
+{
+    kernels.setSize(numChannels, numTaps);
+    kernels.clear();
+
+    const double windowScale = 1.0 / besselI0(kaiserBeta);
+    const double halfSpan = numTaps / 2;
+    int maxWholeFrames = 0;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const double advance = juce::jmax(0.0, advanceFrames[ch]);
+        jassert(advanceFrames[ch] >= 0.0);
+
+        int whole = (int)std::floor(advance);
+        double fraction = advance - whole;
+
+        if (fraction > 1.0 - wholeFrameTolerance)
+        {
+            ++whole;
+            fraction = 0.0;
+        }
+
+        wholeFrames.add(whole);
+        interpolated.add(fraction > wholeFrameTolerance);
+        maxWholeFrames = juce::jmax(maxWholeFrames, whole);
+
+        // Tap k reads input frame n + whole + k - tapsBefore: a sinc centred fraction frames after tapsBefore
+        float* kernel = kernels.getWritePointer(ch);
+        double sum = 0.0;
+
+        for (int k = 0; k < numTaps; ++k)
+        {
+            const double x = (double)(k - tapsBefore) - fraction;
+            const double sinc = x == 0.0 ? 1.0 : std::sin(juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+            const double r = x / halfSpan;
+            const double window = besselI0(kaiserBeta * std::sqrt(juce::jmax(0.0, 1.0 - r * r))) * windowScale;
+
+            kernel[k] = (float)(sinc * window);
+            sum += kernel[k];
+        }
+
+        // Unity gain at DC
+        if (sum != 0.0)
+            juce::FloatVectorOperations::multiply(kernel, (float)(1.0 / sum), numTaps);
+    }
+
+    lookahead = maxWholeFrames + numTaps - tapsBefore;
+    reset();
+}
+
+FractionalDelay::~FractionalDelay()
+{
+}
+
+bool FractionalDelay::isNeeded(const juce::Array<double>& advanceFrames) noexcept
+{
+    for (auto advance : advanceFrames)
+        if (std::abs(advance) > wholeFrameTolerance)
+            return true;
+
+    return false;
+}
+
+void FractionalDelay::reset()
+{
+    // Silence before the first frame, for the taps that reach back
+    history.setSize(numChannels, juce::jmax(history.getNumSamples(), tapsBefore), false, false, true);
+    history.clear();
+    historyStart = -tapsBefore;
+    historyFrames = tapsBefore;
+
+    inputFramesPushed = 0;
+    outputFramesProduced = 0;
+    flushed = false;
+}
+
+//==============================================================================
+// Processing
+
+int FractionalDelay::process(const float* const* input, int numFrames, juce::AudioBuffer<float>& output)
+{
+    jassert(!flushed);
+
+    appendInput(input, numFrames);
+    inputFramesPushed += numFrames;
+
+    // Output frame n needs input up to frame n + lookahead - 1 on the furthest-advanced channel
+    return produce(juce::jlimit((juce::int64)0, inputFramesPushed, historyStart + historyFrames - lookahead + 1), output);
+}
+
+int FractionalDelay::flush(juce::AudioBuffer<float>& output)
+{
+    if (flushed)
+    {
+        output.setSize(numChannels, 0, false, false, true);
+        return 0;
+    }
+
+    flushed = true;
+
+    // Silence after the end, up to the input the last frame reaches
+    const juce::int64 padding = inputFramesPushed + lookahead - 1 - (historyStart + historyFrames);
+
+    if (padding > 0)
+        appendInput(nullptr, (int)padding);
+
+    return produce(inputFramesPushed, output);
+}
+
+int FractionalDelay::produce(juce::int64 outputEnd, juce::AudioBuffer<float>& output)
+{
+    const int numOutput = (int)juce::jmax((juce::int64)0, outputEnd - outputFramesProduced);
+    output.setSize(numChannels, numOutput, false, false, true);
+
+    for (int ch = 0; ch < numChannels && numOutput > 0; ++ch)
+    {
+        float* destination = output.getWritePointer(ch);
+        const int first = (int)(outputFramesProduced + wholeFrames[ch] - historyStart);
+        const float* source = history.getReadPointer(ch);
+
+        if (!interpolated[ch])
+        {
+            juce::FloatVectorOperations::copy(destination, source + first, numOutput);
+            continue;
+        }
+
+        // One multiply-add over the whole block per tap
+        const float* kernel = kernels.getReadPointer(ch);
+        jassert(first - tapsBefore >= 0 && first - tapsBefore + numTaps - 1 + numOutput <= historyFrames);
+
+        juce::FloatVectorOperations::multiply(destination, source + first - tapsBefore, kernel[0], numOutput);
+
+        for (int k = 1; k < numTaps; ++k)
+            juce::FloatVectorOperations::addWithMultiply(destination, source + first - tapsBefore + k, kernel[k], numOutput);
+    }
+
+    outputFramesProduced += numOutput;
+
+    // Drop the input no later frame reaches - the least-advanced channel reaches furthest back
+    const int unused = (int)juce::jlimit((juce::int64)0, (juce::int64)historyFrames,
+                                         outputFramesProduced - tapsBefore - historyStart);
+
+    if (unused > 0)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float* data = history.getWritePointer(ch);
+            std::memmove(data, data + unused, sizeof(float) * (size_t)(historyFrames - unused));
+        }
+
+        historyStart += unused;
+        historyFrames -= unused;
+    }
+
+    return numOutput;
+}
+
+void FractionalDelay::appendInput(const float* const* input, int numFrames)
+{
+    if (numFrames <= 0)
+        return;
+
+    history.setSize(numChannels, historyFrames + numFrames, true, false, true);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        float* destination = history.getWritePointer(ch, historyFrames);
+
+        if (input != nullptr)
+            juce::FloatVectorOperations::copy(destination, input[ch], numFrames);
+        else
+            juce::FloatVectorOperations::clear(destination, numFrames);
+    }
+
+    historyFrames += numFrames;
+}
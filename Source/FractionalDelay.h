@@ -0,0 +1,79 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * Streaming per-channel fractional advance
+ *
+ * Pulls each channel of a stream forward by its own, not necessarily whole,
+ * number of frames: output frame n of channel c is input frame n + advance[c],
+ * interpolated between frames by a Kaiser-windowed sinc. This is what lines
+ * the returns of a chain up with the source when their latencies differ by
+ * fractions of a frame (see LatencyMeasurement).
+ *
+ * Each channel's kernel is fixed for the stream, so it is applied as one
+ * vectorised multiply-add of the whole block per tap rather than a dot
+ * product per frame. A channel with no fractional part is copied.
+ *
+ * Exactly as many frames come out as went in once flush() has been called;
+ * the frames beyond the end of the input are silence.
+ *
+ * Not thread safe - one instance per thread. Building the kernels allocates,
+ * processing only grows the scratch buffers.
+ */
+class FractionalDelay
+{
+public:
+    //==============================================================================
+    /** @param advanceFrames Frames to pull each channel forward by, none negative */
+    FractionalDelay(int numChannels, const juce::Array<double>& advanceFrames);
+    ~FractionalDelay();
+
+    /** True if any of the advances moves its channel at all */
+    static bool isNeeded(const juce::Array<double>& advanceFrames) noexcept;
+
+    /**
+     * Advances the next numFrames frames
+     * @param input One pointer per channel
+     * @param output Resized as needed (without shrinking its allocation); the frames ready so far go to its start
+     * @return The number of frames written to output
+     */
+    int process(const float* const* input, int numFrames, juce::AudioBuffer<float>& output);
+
+    /** Writes the frames still held back for the interpolation and ends the stream */
+    int flush(juce::AudioBuffer<float>& output);
+
+    /** Forgets all input, ready for a new stream */
+    void reset();
+
+    int getNumChannels() const noexcept { return numChannels; }
+
+    /** Input frames past the last output frame that it is interpolated from */
+    int getLookahead() const noexcept { return lookahead - 1; }
+
+private:
+    //==============================================================================
+    static constexpr int numTaps = 32;
+    static constexpr int tapsBefore = numTaps / 2 - 1;  // Input frames before the one being interpolated from
+
+    int produce(juce::int64 outputEnd, juce::AudioBuffer<float>& output);
+    void appendInput(const float* const* input, int numFrames);
+
+    const int numChannels;
+    juce::Array<int> wholeFrames;     // Integer part of each channel's advance
+    juce::Array<bool> interpolated;   // False where the advance is whole and the channel is copied
+    juce::AudioBuffer<float> kernels; // One channel of numTaps per channel, for its fractional part
+    int lookahead = 0;                // Input frames the furthest-advanced channel needs beyond an output frame
+
+    // Input still needed, as absolute frame numbers [historyStart, historyStart + historyFrames)
+    juce::AudioBuffer<float> history;
+    juce::int64 historyStart = 0;
+    int historyFrames = 0;
+
+    juce::int64 inputFramesPushed = 0;
+    juce::int64 outputFramesProduced = 0;
+    bool flushed = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FractionalDelay)
+};
@@ -0,0 +1,660 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "HeadlessRunner.h"
+#include <iostream>
+
+namespace
+{
+// "3-4" or "3" -> 3 (1-indexed left channel), -1 when unparseable
+int parsePairLeftChannel(const juce::String& text)
+{
+    const juce::String left = text.upToFirstOccurrenceOf("-", false, false).trim();
+    return left.containsOnly("0123456789") && left.isNotEmpty() ? left.getIntValue() : -1;
+}
+
+juce::String getStatusName(ProcessingStatus status)
+{
+    switch (status)
+    {
+        case ProcessingStatus::pending:           return "pending";
+        case ProcessingStatus::processing:        return "processing";
+        case ProcessingStatus::finalising:        return "finalising";
+        case ProcessingStatus::completed:         return "completed";
+        case ProcessingStatus::failed:            return "failed";
+        case ProcessingStatus::invalidSampleRate: return "invalidSampleRate";
+    }
+
+    return "unknown";
+}
+}
+
+//==============================================================================
+HeadlessRunner::HeadlessRunner()
+    : engine(deviceManager),
+      appState(engine.getAppState())
+{
+    engine.onLatencyMeasured = [this](bool succeeded) { handleLatencyMeasured(succeeded); };
+    engine.onImpulseResponseCaptured = [this](bool succeeded) { handleImpulseResponseCaptured(succeeded); };
+    engine.onFileStatusChanged = [this](int fileIndex) { handleFileStatusChanged(fileIndex); };
+    engine.onBatchFinished = [this]() { handleBatchFinished(); };
+
+    sourcePlayer.setSource(&engine);
+    deviceManager.addAudioCallback(&sourcePlayer);
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+    stopTimer();
+    deviceManager.removeAudioCallback(&sourcePlayer);
+    sourcePlayer.setSource(nullptr);
+    deviceManager.closeAudioDevice();
+}
+
+juce::String HeadlessRunner::getUsage()
+{
+    return "Usage: F9_JUCE_Batch_Resampler --headless --device <name> --output <folder> [options] <files...>\n"
+           "\n"
+           "  --device <name>            Device to use (\"loopback\" = the virtual loopback device)\n"
+           "  --input-pair <L-R>         Return channels, 1-indexed (default: first pair)\n"
+           "  --output-pair <L-R>        Send channels, 1-indexed (default: first pair)\n"
+           "  --output <folder>          Output folder (created if missing)\n"
+           "  --manifest <file>          Text file with one path per line, or a one-take JSON manifest\n"
+           "  --one-take                 Send all files as one continuous take, then split it\n"
+           "  --reverb                   Stop each capture on the noise floor instead of a fixed length\n"
+           "  --plugin <path or URI>     Render offline through a VST3/LV2 plugin instead of --device\n"
+           "  --ir-render                Capture the chain's impulse response, then convolve the batch offline\n"
+           "  --threads <n>              Offline render threads (default: one per physical core)\n"
+           "  --trim-silence <dB>        Trim leading/trailing silence below this level\n"
+           "  --gain <dB>                Gain applied to every output file (default 0)\n"
+           "  --no-dither                Truncate to 24 bits instead of adding TPDF dither\n"
+           "  --resample-quality <q>     Conversion of sources at another rate: fast, standard (default) or best\n"
+           "  --source-rate-output       Write each output at its source's rate instead of the device rate\n"
+           "  --latency-timeout <s>      Give up on latency measurement after this long (default 10)\n"
+           "  --stored-latency           Use the latency stored for this device setup instead of measuring\n"
+           "  --loopback-latency <n>     Virtual loopback round trip in frames\n"
+           "  --loopback-noise <dB>      Virtual loopback noise floor\n"
+           "  --loopback-jitter <n>      Virtual loopback clock wander in frames\n"
+           "\n"
+           "Progress is printed to stdout as one JSON object per line; the log goes to stderr.\n"
+           "Exit codes: 0 ok, 1 bad arguments, 2 device error, 3 latency failed, 4 files failed\n";
+}
+
+//==============================================================================
+// Argument Parsing
+
+juce::String HeadlessRunner::parseArguments(const juce::StringArray& arguments, Options& options)
+{
+    const auto workingDirectory = juce::File::getCurrentWorkingDirectory();
+
+    for (int i = 0; i < arguments.size(); ++i)
+    {
+        const juce::String& argument = arguments[i];
+
+        auto nextValue = [&](juce::String& value) -> bool
+        {
+            if (i + 1 >= arguments.size())
+                return false;
+
+            value = arguments[++i];
+            return true;
+        };
+
+        juce::String value;
+
+        if (argument == "--headless")
+            continue;
+
+        if (argument == "--one-take")
+        {
+            options.oneTake = true;
+        }
+        else if (argument == "--reverb")
+        {
+            options.reverbMode = true;
+        }
+        else if (argument == "--ir-render")
+        {
+            options.impulseResponseRender = true;
+        }
+        else if (argument == "--plugin")
+        {
+            if (!nextValue(value)) return "--plugin needs a VST3 path or LV2 URI";
+            options.pluginPath = juce::File::isAbsolutePath(value) || !workingDirectory.getChildFile(value).exists()
+                                     ? value
+                                     : workingDirectory.getChildFile(value).getFullPathName();
+        }
+        else if (argument == "--threads")
+        {
+            if (!nextValue(value)) return "--threads needs a number";
+            options.renderThreads = juce::jmax(0, value.getIntValue());
+        }
+        else if (argument == "--device")
+        {
+            if (!nextValue(value)) return "--device needs a device name";
+            options.deviceName = value;
+        }
+        else if (argument == "--input-pair" || argument == "--output-pair")
+        {
+            if (!nextValue(value)) return argument + " needs a channel pair such as 3-4";
+
+            const int left = parsePairLeftChannel(value);
+            if (left < 1) return "Invalid channel pair - " + value;
+
+            (argument == "--input-pair" ? options.inputPairLeft : options.outputPairLeft) = left;
+        }
+        else if (argument == "--output")
+        {
+            if (!nextValue(value)) return "--output needs a folder";
+            options.outputFolder = workingDirectory.getChildFile(value);
+        }
+        else if (argument == "--manifest")
+        {
+            if (!nextValue(value)) return "--manifest needs a file";
+
+            const juce::String error = readManifest(workingDirectory.getChildFile(value), options.files);
+            if (error.isNotEmpty()) return error;
+        }
+        else if (argument == "--trim-silence")
+        {
+            if (!nextValue(value)) return "--trim-silence needs a threshold in dB";
+            options.trimSilence = true;
+            options.trimThresholdDb = value.getFloatValue();
+        }
+        else if (argument == "--gain")
+        {
+            if (!nextValue(value)) return "--gain needs a level in dB";
+            options.outputGainDb = value.getFloatValue();
+        }
+        else if (argument == "--no-dither")
+        {
+            options.dither = false;
+        }
+        else if (argument == "--resample-quality")
+        {
+            if (!nextValue(value)) return "--resample-quality needs fast, standard or best";
+
+            if (value == "fast")          options.resampleQuality = SampleRateConverter::Quality::fast;
+            else if (value == "standard") options.resampleQuality = SampleRateConverter::Quality::standard;
+            else if (value == "best")     options.resampleQuality = SampleRateConverter::Quality::best;
+            else return "Unknown --resample-quality: " + value;
+        }
+        else if (argument == "--source-rate-output")
+        {
+            options.sourceRateOutput = true;
+        }
+        else if (argument == "--latency-timeout")
+        {
+            if (!nextValue(value)) return "--latency-timeout needs a number of seconds";
+            options.latencyTimeoutSeconds = juce::jmax(1.0, value.getDoubleValue());
+        }
+        else if (argument == "--stored-latency")
+        {
+            options.storedLatency = true;
+        }
+        else if (argument == "--loopback-latency")
+        {
+            if (!nextValue(value)) return "--loopback-latency needs a number of frames";
+            options.loopbackSettings.roundTripLatencyFrames = juce::jmax(0, value.getIntValue());
+        }
+        else if (argument == "--loopback-noise")
+        {
+            if (!nextValue(value)) return "--loopback-noise needs a level in dB";
+            options.loopbackSettings.noiseFloorDb = value.getFloatValue();
+        }
+        else if (argument == "--loopback-jitter")
+        {
+            if (!nextValue(value)) return "--loopback-jitter needs a number of frames";
+            options.loopbackSettings.clockJitterFrames = juce::jmax(0.0f, value.getFloatValue());
+        }
+        else if (argument.startsWith("--"))
+        {
+            return "Unknown option - " + argument;
+        }
+        else
+        {
+            options.files.add(workingDirectory.getChildFile(argument));
+        }
+    }
+
+    if (options.deviceName.isEmpty() && options.pluginPath.isEmpty())
+        return "No device given (--device or --plugin)";
+
+    if (options.impulseResponseRender && options.pluginPath.isNotEmpty())
+        return "--ir-render captures through --device and can't be combined with --plugin";
+
+    if (options.outputFolder == juce::File())
+        return "No output folder given (--output)";
+
+    if (options.files.isEmpty())
+        return "No files given";
+
+    return {};
+}
+
+juce::String HeadlessRunner::readManifest(const juce::File& manifestFile, juce::Array<juce::File>& files)
+{
+    if (!manifestFile.existsAsFile())
+        return "Manifest not found - " + manifestFile.getFullPathName();
+
+    // Relative paths are relative to the manifest, not the working directory
+    const auto baseFolder = manifestFile.getParentDirectory();
+
+    if (manifestFile.hasFileExtension("json"))
+    {
+        const juce::var manifest = juce::JSON::parse(manifestFile);
+
+        if (auto* segments = manifest["segments"].getArray())
+        {
+            for (const auto& segment : *segments)
+                files.add(baseFolder.getChildFile(segment["source"].toString()));
+
+            return {};
+        }
+
+        return "Manifest has no segments - " + manifestFile.getFileName();
+    }
+
+    juce::StringArray lines;
+    manifestFile.readLines(lines);
+
+    for (auto line : lines)
+    {
+        line = line.trim();
+
+        if (line.isNotEmpty() && !line.startsWith("#"))
+            files.add(baseFolder.getChildFile(line.unquoted()));
+    }
+
+    return {};
+}
+
+//==============================================================================
+// Run
+
+void HeadlessRunner::start(const juce::StringArray& arguments)
+{
+    if (arguments.contains("--help"))
+    {
+        std::cout << getUsage() << std::flush;
+        finish(ExitCode::succeeded);
+        return;
+    }
+
+    const juce::String error = parseArguments(arguments, options);
+
+    if (error.isNotEmpty())
+    {
+        std::cerr << getUsage() << std::endl;
+        finish(ExitCode::badArguments, error);
+        return;
+    }
+
+    if (!options.outputFolder.createDirectory())
+    {
+        finish(ExitCode::badArguments, "Could not create output folder - " + options.outputFolder.getFullPathName());
+        return;
+    }
+
+    appState.settings.outputFolderPath = options.outputFolder.getFullPathName();
+    appState.settings.useOneTakeMode = options.oneTake;
+    appState.settings.useReverbMode = options.reverbMode;
+    appState.settings.useOfflinePluginRender = options.pluginPath.isNotEmpty();
+    appState.settings.offlinePluginPath = options.pluginPath;
+    appState.settings.offlineRenderThreads = options.renderThreads;
+    appState.settings.trimEnabled = options.trimSilence;
+    appState.settings.thresholdDb = options.trimThresholdDb;
+    appState.settings.outputGainDb = options.outputGainDb;
+    appState.settings.ditherEnabled = options.dither;
+    appState.settings.resampleQuality = options.resampleQuality;
+    appState.settings.convertCapturesToSourceRate = options.sourceRateOutput;
+
+    appState.appendLog("F9 Batch Resampler started (headless)");
+    engine.addFiles(options.files);
+
+    auto event = makeEvent("started");
+    event->setProperty("device", options.deviceName);
+    event->setProperty("plugin", options.pluginPath);
+    event->setProperty("files", options.files.size());
+    event->setProperty("outputFolder", options.outputFolder.getFullPathName());
+    printEvent(event);
+
+    startTimer(50);
+
+    // Offline render: straight to the batch
+    if (appState.settings.useOfflinePluginRender)
+    {
+        startBatch();
+        return;
+    }
+
+    const juce::String deviceError = setUpDevice();
+
+    if (deviceError.isNotEmpty())
+    {
+        finish(ExitCode::deviceError, deviceError);
+        return;
+    }
+
+    // configureAudioDevice() has restored the profile if this setup was measured before
+    if (options.storedLatency && appState.settings.measuredLatencyFrames >= 0)
+    {
+        auto event = makeEvent("latency");
+        event->setProperty("succeeded", true);
+        event->setProperty("stored", true);
+        event->setProperty("latencyFrames", appState.settings.getLatencyFrames());
+        event->setProperty("latencyMs", appState.settings.getLatencyInMs());
+        event->setProperty("noiseFloorDb", appState.settings.measuredNoiseFloorDb);
+        printEvent(event);
+
+        startAfterLatency();
+        return;
+    }
+
+    measuringLatency = true;
+    latencyStartTimeMs = juce::Time::getMillisecondCounterHiRes();
+    engine.startLatencyMeasurement();
+
+    if (!appState.isMeasuringLatency && !finished)
+        finish(ExitCode::latencyFailed, "Latency measurement did not start");
+}
+
+juce::String HeadlessRunner::setUpDevice()
+{
+    // Opens the default device for now - configureAudioDevice() switches to the requested one
+    deviceManager.initialise(2, 2, nullptr, false);
+
+    const bool wantsLoopback = options.deviceName.equalsIgnoreCase("loopback")
+                            || options.deviceName == VirtualLoopbackDeviceType::loopbackDeviceName;
+
+    if (wantsLoopback)
+    {
+        options.deviceName = VirtualLoopbackDeviceType::loopbackDeviceName;
+        engine.getLoopbackDeviceType().setLoopbackSettings(options.loopbackSettings);
+    }
+
+    // The cached list may be stale - a run has to see the devices as they are now
+    engine.refreshDevices();
+
+    if (!engine.waitForDeviceScan(30000))
+        return "Timed out scanning audio devices";
+
+    const AudioDevice* device = nullptr;
+    juce::StringArray deviceNames;
+
+    for (const auto& candidate : appState.devices)
+    {
+        deviceNames.add(candidate.name);
+
+        if (device == nullptr && (candidate.name.equalsIgnoreCase(options.deviceName)
+                                  || candidate.uniqueID == options.deviceName))
+            device = &candidate;
+    }
+
+    if (device == nullptr)
+        return "Device not found - " + options.deviceName + " (available: " + deviceNames.joinIntoString(", ") + ")";
+
+    engine.selectDevice(device->uniqueID);
+
+    auto selectPair = [](const juce::Array<StereoPair>& pairs, int leftChannel, const StereoPair*& found)
+    {
+        for (const auto& pair : pairs)
+            if (pair.leftChannel == leftChannel)
+                found = &pair;
+    };
+
+    if (options.inputPairLeft > 0)
+    {
+        const auto pairs = appState.getAvailableInputPairs();
+        const StereoPair* pair = nullptr;
+        selectPair(pairs, options.inputPairLeft, pair);
+
+        if (pair == nullptr)
+            return "Input pair starting at channel " + juce::String(options.inputPairLeft) + " not available";
+
+        engine.selectInputPair(*pair);
+    }
+
+    if (options.outputPairLeft > 0)
+    {
+        const auto pairs = appState.getAvailableOutputPairs();
+        const StereoPair* pair = nullptr;
+        selectPair(pairs, options.outputPairLeft, pair);
+
+        if (pair == nullptr)
+            return "Output pair starting at channel " + juce::String(options.outputPairLeft) + " not available";
+
+        engine.selectOutputPair(*pair);
+    }
+
+    auto* currentDevice = deviceManager.getCurrentAudioDevice();
+
+    if (currentDevice == nullptr || currentDevice->getName() != device->name)
+        return "Could not open device - " + device->name;
+
+    auto event = makeEvent("device");
+    event->setProperty("name", currentDevice->getName());
+    event->setProperty("type", currentDevice->getTypeName());
+    event->setProperty("sampleRate", currentDevice->getCurrentSampleRate());
+    event->setProperty("bufferSize", currentDevice->getCurrentBufferSizeSamples());
+    event->setProperty("inputPair", appState.selectedInputPair.getDisplayName());
+    event->setProperty("outputPair", appState.selectedOutputPair.getDisplayName());
+    printEvent(event);
+
+    return {};
+}
+
+void HeadlessRunner::handleLatencyMeasured(bool succeeded)
+{
+    if (!measuringLatency || finished)
+        return;
+
+    measuringLatency = false;
+
+    auto event = makeEvent("latency");
+    event->setProperty("succeeded", succeeded);
+
+    if (succeeded)
+    {
+        event->setProperty("latencyFrames", appState.settings.getLatencyFrames());
+        event->setProperty("latencyMs", appState.settings.getLatencyInMs());
+        event->setProperty("noiseFloorDb", appState.settings.measuredNoiseFloorDb);
+    }
+
+    printEvent(event);
+
+    if (!succeeded)
+    {
+        finish(ExitCode::latencyFailed, "Measurement sequence not found in the return");
+        return;
+    }
+
+    startAfterLatency();
+}
+
+void HeadlessRunner::startAfterLatency()
+{
+    if (options.impulseResponseRender)
+    {
+        capturingImpulseResponse = true;
+        impulseResponseStartTimeMs = juce::Time::getMillisecondCounterHiRes();
+        engine.startImpulseResponseCapture();
+
+        if (!appState.isCapturingImpulseResponse && !finished)
+            finish(ExitCode::latencyFailed, "Impulse response capture did not start");
+        return;
+    }
+
+    startBatch();
+}
+
+void HeadlessRunner::handleImpulseResponseCaptured(bool succeeded)
+{
+    if (!capturingImpulseResponse || finished)
+        return;
+
+    capturingImpulseResponse = false;
+
+    auto event = makeEvent("impulseResponse");
+    event->setProperty("succeeded", succeeded);
+
+    if (succeeded)
+        event->setProperty("seconds", appState.chainImpulseResponse.getNumSamples() / appState.chainImpulseResponseSampleRate);
+
+    printEvent(event);
+
+    if (!succeeded)
+    {
+        finish(ExitCode::latencyFailed, "No return signal during the sweep");
+        return;
+    }
+
+    // The device has done its part - the batch is convolved offline
+    appState.settings.useImpulseResponseRender = true;
+    startBatch();
+}
+
+void HeadlessRunner::startBatch()
+{
+    batchStartTimeMs = juce::Time::getMillisecondCounterHiRes();
+    engine.startProcessing();
+
+    // startProcessing() only logs why it refused to start
+    if (!appState.isProcessing && !finished)
+        finish(ExitCode::badArguments, "Batch did not start - see log");
+}
+
+void HeadlessRunner::handleFileStatusChanged(int fileIndex)
+{
+    if (!juce::isPositiveAndBelow(fileIndex, appState.files.size()))
+        return;
+
+    const AudioFile& file = appState.files.getReference(fileIndex);
+    const double now = juce::Time::getMillisecondCounterHiRes();
+
+    auto event = makeEvent("file");
+    event->setProperty("index", fileIndex);
+    event->setProperty("file", file.url.getFullPathName());
+    event->setProperty("status", getStatusName(file.status));
+
+    if (file.status == ProcessingStatus::processing)
+    {
+        fileStartTimesMs.set(fileIndex, now);
+    }
+    else if (fileStartTimesMs.contains(fileIndex))
+    {
+        event->setProperty("elapsedMs", now - fileStartTimesMs[fileIndex]);
+    }
+
+    printEvent(event);
+}
+
+void HeadlessRunner::handleBatchFinished()
+{
+    int completed = 0;
+    int failed = 0;
+    double audioSeconds = 0.0;
+
+    for (const auto& file : appState.files)
+    {
+        if (file.status == ProcessingStatus::completed)
+        {
+            ++completed;
+            if (file.sampleRate > 0.0)
+                audioSeconds += (double)file.durationSamples / file.sampleRate;
+        }
+        else
+        {
+            ++failed;
+        }
+    }
+
+    const double wallSeconds = (juce::Time::getMillisecondCounterHiRes() - batchStartTimeMs) / 1000.0;
+
+    auto event = makeEvent("finished");
+    event->setProperty("completed", completed);
+    event->setProperty("failed", failed);
+    event->setProperty("audioSeconds", audioSeconds);
+    event->setProperty("wallSeconds", wallSeconds);
+    event->setProperty("realtimeFactor", wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0);
+    printEvent(event);
+
+    finish(failed > 0 ? ExitCode::filesFailed : ExitCode::succeeded,
+           failed > 0 ? juce::String(failed) + " file(s) failed" : juce::String());
+}
+
+void HeadlessRunner::timerCallback()
+{
+    flushLog();
+
+    if (measuringLatency)
+    {
+        const double elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - latencyStartTimeMs) / 1000.0;
+
+        if (elapsedSeconds > options.latencyTimeoutSeconds)
+        {
+            measuringLatency = false;
+            engine.stopAllAudio();
+            finish(ExitCode::latencyFailed, "Latency measurement timed out - is audio running?");
+        }
+    }
+
+    if (capturingImpulseResponse)
+    {
+        const double elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - impulseResponseStartTimeMs) / 1000.0;
+        const double expectedSeconds = 2.0 * (appState.settings.impulseSweepSeconds + appState.settings.impulseResponseSeconds);
+
+        if (elapsedSeconds > expectedSeconds + options.latencyTimeoutSeconds)
+        {
+            capturingImpulseResponse = false;
+            engine.stopAllAudio();
+            finish(ExitCode::latencyFailed, "Impulse response capture timed out - is audio running?");
+        }
+    }
+}
+
+//==============================================================================
+// Output
+
+void HeadlessRunner::flushLog()
+{
+    for (const auto& line : appState.logBuffer.getLinesSince(nextLogLine))
+        std::cerr << line << std::endl;
+}
+
+juce::DynamicObject::Ptr HeadlessRunner::makeEvent(const juce::String& eventName)
+{
+    juce::DynamicObject::Ptr event = new juce::DynamicObject();
+    event->setProperty("event", eventName);
+    event->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+    return event;
+}
+
+void HeadlessRunner::printEvent(const juce::DynamicObject::Ptr& event)
+{
+    std::cout << juce::JSON::toString(juce::var(event.get()), true) << std::endl;
+}
+
+void HeadlessRunner::finish(ExitCode exitCode, const juce::String& message)
+{
+    if (finished)
+        return;
+
+    finished = true;
+    stopTimer();
+    flushLog();
+
+    if (message.isNotEmpty())
+    {
+        auto event = makeEvent("error");
+        event->setProperty("message", message);
+        printEvent(event);
+    }
+
+    auto event = makeEvent("exit");
+    event->setProperty("code", (int)exitCode);
+    printEvent(event);
+
+    if (auto* app = juce::JUCEApplicationBase::getInstance())
+        app->setApplicationReturnValue((int)exitCode);
+
+    juce::JUCEApplicationBase::quit();
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AppState.h"
+#include "BatchEngine.h"
+
+//==============================================================================
+/**
+ * Console batch runner - no window, no UI timer
+ *
+ * Started by Main.cpp when the command line contains --headless. Owns its own
+ * AudioDeviceManager and drives the same BatchEngine as the GUI:
+ * select device and pairs -> measure latency -> process every file -> quit.
+ *
+ * Progress is written to stdout as one JSON object per line, so runs can be
+ * scripted and timed; the engine log is mirrored to stderr. The application
+ * return value is set from the outcome (see ExitCode).
+ *
+ *   F9_JUCE_Batch_Resampler --headless --device "F9 Virtual Loopback"
+ *       --input-pair 3-4 --output-pair 3-4 --output /renders a.wav b.wav
+ *
+ * Files can also come from --manifest: a text file with one path per line,
+ * or a one-take JSON manifest (its "source" entries are used).
+ *
+ * With --plugin the batch is rendered offline through a VST3/LV2 plugin
+ * instead: no device is opened and no latency is measured. With --ir-render
+ * the chain's impulse response is captured once after the latency
+ * measurement and the batch is convolved with it offline. With
+ * --stored-latency a setup measured before (see LatencyProfileStore) skips
+ * the latency measurement.
+ */
+class HeadlessRunner : private juce::Timer
+{
+public:
+    enum ExitCode
+    {
+        succeeded = 0,
+        badArguments = 1,
+        deviceError = 2,
+        latencyFailed = 3,
+        filesFailed = 4
+    };
+
+    //==============================================================================
+    HeadlessRunner();
+    ~HeadlessRunner() override;
+
+    /** Parses the arguments and starts the run - quits the application when it is over */
+    void start(const juce::StringArray& arguments);
+
+    /** Usage text printed for --help and bad arguments */
+    static juce::String getUsage();
+
+private:
+    //==============================================================================
+    struct Options
+    {
+        juce::String deviceName;
+        int inputPairLeft = -1;   // 1-indexed, -1 = first pair
+        int outputPairLeft = -1;
+        juce::File outputFolder;
+        juce::Array<juce::File> files;
+        bool oneTake = false;
+        bool reverbMode = false;
+        juce::String pluginPath;  // Set = offline render, no device
+        bool impulseResponseRender = false;
+        int renderThreads = 0;
+        bool trimSilence = false;
+        float trimThresholdDb = -40.0f;
+        float outputGainDb = 0.0f;
+        bool dither = true;
+        SampleRateConverter::Quality resampleQuality = SampleRateConverter::Quality::standard;
+        bool sourceRateOutput = false;
+        double latencyTimeoutSeconds = 10.0;
+        bool storedLatency = false;  // Use the stored profile for this setup when there is one
+        VirtualLoopbackSettings loopbackSettings;
+    };
+
+    /** Returns an error message, or an empty string when the options are usable */
+    static juce::String parseArguments(const juce::StringArray& arguments, Options& options);
+
+    /** Adds the files listed in a text or one-take JSON manifest */
+    static juce::String readManifest(const juce::File& manifestFile, juce::Array<juce::File>& files);
+
+    juce::String setUpDevice();
+    void handleLatencyMeasured(bool succeeded);
+    void startAfterLatency();
+    void handleImpulseResponseCaptured(bool succeeded);
+    void startBatch();
+    void handleFileStatusChanged(int fileIndex);
+    void handleBatchFinished();
+
+    void timerCallback() override;
+
+    /** Writes new engine log lines to stderr */
+    void flushLog();
+
+    /** A progress object with its "event" and "time" properties filled in */
+    static juce::DynamicObject::Ptr makeEvent(const juce::String& eventName);
+
+    /** Prints a progress object to stdout as one line of JSON */
+    static void printEvent(const juce::DynamicObject::Ptr& event);
+
+    void finish(ExitCode exitCode, const juce::String& message = {});
+
+    //==============================================================================
+    juce::AudioDeviceManager deviceManager;
+    juce::AudioSourcePlayer sourcePlayer;
+    BatchEngine engine;
+    AppState& appState;  // Owned by the engine
+
+    Options options;
+    juce::int64 nextLogLine = 0;
+    bool measuringLatency = false;
+    bool capturingImpulseResponse = false;
+    bool finished = false;
+    double latencyStartTimeMs = 0.0;
+    double impulseResponseStartTimeMs = 0.0;
+    double batchStartTimeMs = 0.0;
+    juce::HashMap<int, double> fileStartTimesMs;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HeadlessRunner)
+};
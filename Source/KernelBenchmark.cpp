@@ -0,0 +1,484 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "KernelBenchmark.h"
+#include "AudioAnalysis.h"
+#include <iostream>
+#include <map>
+
+namespace
+{
+constexpr double captureSampleRate = 44100.0;
+constexpr int latencyFrames = 512;          // Typical interface round trip, skipped at the start of each capture
+constexpr double channelAdvanceFrames = 0.37;  // A return's lag beyond the whole frames, for the aligned variant
+constexpr int writerBlockFrames = 4096;     // As CaptureWriter pushes them
+constexpr int batchesPerResult = 5;         // The fastest batch is reported
+constexpr double batchSeconds = 0.1;
+constexpr double quickBatchSeconds = 0.02;
+constexpr int maxFileWriteFrames = 60 * 44100;  // Longer writes measure the disk, not the encoder
+}
+
+//==============================================================================
+juce::String KernelBenchmark::getUsage()
+{
+    return "Usage: F9_JUCE_Batch_Resampler --benchmark [options]\n"
+           "\n"
+           "  --quick                    Skip the 10-minute captures and time shorter batches\n"
+           "  --save <file>              Write the results as a baseline JSON file\n"
+           "  --baseline <file>          Compare against a saved baseline\n"
+           "  --tolerance <percent>      Slowdown allowed before a result counts as a regression (default 10)\n"
+           "  --kernel <name>            Only run kernels whose name contains this\n"
+           "\n"
+           "Exit codes: 0 ok, 1 bad arguments, 5 slower than the baseline\n";
+}
+
+//==============================================================================
+// Argument Parsing
+
+juce::String KernelBenchmark::parseArguments(const juce::StringArray& arguments)
+{
+    const auto workingDirectory = juce::File::getCurrentWorkingDirectory();
+
+    for (int i = 0; i < arguments.size(); ++i)
+    {
+        const juce::String& argument = arguments[i];
+
+        auto nextValue = [&](juce::String& value) -> bool
+        {
+            if (i + 1 >= arguments.size())
+                return false;
+
+            value = arguments[++i];
+            return true;
+        };
+
+        juce::String value;
+
+        if (argument == "--benchmark")
+            continue;
+
+        if (argument == "--quick")
+        {
+            options.quick = true;
+        }
+        else if (argument == "--save")
+        {
+            if (!nextValue(value)) return "--save needs a file";
+            options.saveFile = workingDirectory.getChildFile(value);
+        }
+        else if (argument == "--baseline")
+        {
+            if (!nextValue(value)) return "--baseline needs a file";
+            options.baselineFile = workingDirectory.getChildFile(value);
+
+            if (!options.baselineFile.existsAsFile())
+                return "Baseline not found - " + options.baselineFile.getFullPathName();
+        }
+        else if (argument == "--tolerance")
+        {
+            if (!nextValue(value)) return "--tolerance needs a percentage";
+            options.tolerancePercent = juce::jmax(0.0, value.getDoubleValue());
+        }
+        else if (argument == "--kernel")
+        {
+            if (!nextValue(value)) return "--kernel needs a name";
+            options.kernelFilter = value;
+        }
+        else
+        {
+            return "Unknown option - " + argument;
+        }
+    }
+
+    return {};
+}
+
+//==============================================================================
+// Suite
+
+juce::Array<KernelBenchmark::Shape> KernelBenchmark::getShapes() const
+{
+    const int seconds = (int)captureSampleRate;
+
+    // Audio callback blocks, a short file, a long file and a full-length capture
+    juce::Array<Shape> shapes {
+        { 1, 128 }, { 2, 128 }, { 8, 128 },
+        { 2, 512 }, { 8, 512 },
+        { 2, 4096 }, { 8, 4096 },
+        { 2, 10 * seconds }, { 8, 10 * seconds },
+        { 2, 60 * seconds }
+    };
+
+    if (!options.quick)
+        shapes.add({ 2, 600 * seconds });
+
+    return shapes;
+}
+
+juce::Array<KernelBenchmark::Kernel> KernelBenchmark::getKernels()
+{
+    juce::Array<Kernel> kernels;
+
+    // What every capture costs after recording, as shipped: latency skip, DC removal, dither, 24-bit pack and write
+    CaptureOutput::Format captureFormat;
+    captureFormat.sampleRate = captureSampleRate;
+
+    CaptureOutput::Processing captureProcessing;
+
+    kernels.add({ "captureOutput", 7.0, maxFileWriteFrames, [this, captureFormat, captureProcessing](juce::AudioBuffer<float>& buffer)
+    {
+        writeCapture(buffer, captureFormat, captureProcessing);
+    } });
+
+    // The same with each return lined up to a fraction of a frame
+    kernels.add({ "captureOutputAligned", 7.0, maxFileWriteFrames, [this, captureFormat, captureProcessing](juce::AudioBuffer<float>& buffer)
+    {
+        auto format = captureFormat;
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            format.channelAdvanceFrames.add(channelAdvanceFrames);
+
+        writeCapture(buffer, format, captureProcessing);
+    } });
+
+    // The same converted back to a 48 kHz source's rate
+    kernels.add({ "captureOutputConverted", 7.0, maxFileWriteFrames, [this, captureFormat, captureProcessing](juce::AudioBuffer<float>& buffer)
+    {
+        auto format = captureFormat;
+        format.outputSampleRate = 48000.0;
+        writeCapture(buffer, format, captureProcessing);
+    } });
+
+    kernels.add({ "calculateRMS", 4.0, std::numeric_limits<int>::max(), [this](juce::AudioBuffer<float>& buffer)
+    {
+        sink += AudioAnalysis::calculateRMS(buffer);
+    } });
+
+    kernels.add({ "calculateNoiseFloorDb", 4.0, std::numeric_limits<int>::max(), [this](juce::AudioBuffer<float>& buffer)
+    {
+        sink += AudioAnalysis::calculateNoiseFloorDb(buffer);
+    } });
+
+    kernels.add({ "findPeakPosition", 4.0, std::numeric_limits<int>::max(), [this](juce::AudioBuffer<float>& buffer)
+    {
+        sink += AudioAnalysis::findPeakPosition(buffer, 0.1f);
+    } });
+
+    // Sum, sum of squares and peak in one pass - what the helpers above are built on
+    kernels.add({ "analyse", 4.0, std::numeric_limits<int>::max(), [this](juce::AudioBuffer<float>& buffer)
+    {
+        const auto stats = AudioAnalysis::analyse(buffer);
+        sink += stats.sumOfSquares + stats.peakIndex;
+    } });
+
+    // Reference: JUCE's float -> 24-bit WAV writer, which CaptureOutput replaced, without the disk: 4 bytes in, 3 out
+    kernels.add({ "encodeWav24", 7.0, std::numeric_limits<int>::max(), [this](juce::AudioBuffer<float>& buffer)
+    {
+        std::unique_ptr<juce::OutputStream> stream = std::make_unique<juce::MemoryOutputStream>(encodeBlock, false);
+
+        juce::WavAudioFormat wavFormat;
+        auto writer = wavFormat.createWriterFor(
+            stream,
+            juce::AudioFormatWriter::Options{}
+                .withSampleRate(captureSampleRate)
+                .withNumChannels(buffer.getNumChannels())
+                .withBitsPerSample(24)
+        );
+
+        if (writer != nullptr)
+            writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+
+        writer.reset();
+        sink += (double)encodeBlock.getSize();
+    } });
+
+    // Reference: the same writer to a fresh file, flushed on close - compare with captureOutput
+    kernels.add({ "writeWav24File", 7.0, maxFileWriteFrames, [this](juce::AudioBuffer<float>& buffer)
+    {
+        scratchFile.deleteFile();
+        std::unique_ptr<juce::OutputStream> stream(scratchFile.createOutputStream());
+
+        if (stream == nullptr)
+            return;
+
+        juce::WavAudioFormat wavFormat;
+        auto writer = wavFormat.createWriterFor(
+            stream,
+            juce::AudioFormatWriter::Options{}
+                .withSampleRate(captureSampleRate)
+                .withNumChannels(buffer.getNumChannels())
+                .withBitsPerSample(24)
+        );
+
+        if (writer != nullptr)
+            writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+
+        writer.reset();
+        sink += (double)scratchFile.getSize();
+    } });
+
+    if (options.kernelFilter.isNotEmpty())
+    {
+        for (int i = kernels.size(); --i >= 0;)
+            if (!kernels.getReference(i).name.containsIgnoreCase(options.kernelFilter))
+                kernels.remove(i);
+    }
+
+    return kernels;
+}
+
+void KernelBenchmark::fillCapture(juce::AudioBuffer<float>& buffer)
+{
+    juce::Random random(0x5eed);
+    const float noiseLevel = juce::Decibels::decibelsToGain(-60.0f);
+    const float dcBias = 0.002f;
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        float* data = buffer.getWritePointer(ch);
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            data[i] = dcBias + noiseLevel * (random.nextFloat() * 2.0f - 1.0f);
+
+        data[buffer.getNumSamples() / 2] = 0.9f;
+    }
+}
+
+void KernelBenchmark::writeCapture(const juce::AudioBuffer<float>& buffer, CaptureOutput::Format format,
+                                   const CaptureOutput::Processing& processing)
+{
+    format.numChannels = buffer.getNumChannels();
+    format.skipFrames = juce::jmin(latencyFrames, buffer.getNumSamples() / 4);
+
+    CaptureOutput output;
+
+    if (!output.open(scratchFile, format, processing))
+        return;
+
+    juce::HeapBlock<const float*> channels((size_t)format.numChannels);
+
+    for (int start = 0; start < buffer.getNumSamples(); start += writerBlockFrames)
+    {
+        for (int ch = 0; ch < format.numChannels; ++ch)
+            channels[ch] = buffer.getReadPointer(ch, start);
+
+        output.process(channels.get(), juce::jmin(writerBlockFrames, buffer.getNumSamples() - start));
+    }
+
+    output.finish();
+    sink += (double)output.getFramesWritten();
+}
+
+//==============================================================================
+// Measurement
+
+KernelBenchmark::Result KernelBenchmark::measure(const Kernel& kernel, const Shape& shape)
+{
+    juce::AudioBuffer<float> buffer(shape.numChannels, shape.numFrames);
+    fillCapture(buffer);
+
+    const double minimumBatchSeconds = options.quick ? quickBatchSeconds : batchSeconds;
+
+    auto timeBatch = [&](juce::int64 iterations) -> double
+    {
+        const juce::int64 start = juce::Time::getHighResolutionTicks();
+
+        for (juce::int64 i = 0; i < iterations; ++i)
+            kernel.body(buffer);
+
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    };
+
+    // Warm-up run (page faults, allocator, caches), then grow the batch until it is long enough to time
+    timeBatch(1);
+
+    juce::int64 iterations = 1;
+    double seconds = timeBatch(iterations);
+
+    while (seconds < minimumBatchSeconds && iterations < ((juce::int64)1 << 40))
+    {
+        iterations *= juce::jlimit((juce::int64)2, (juce::int64)100,
+                                   (juce::int64)std::ceil(minimumBatchSeconds / juce::jmax(seconds, 1.0e-9)));
+        seconds = timeBatch(iterations);
+    }
+
+    double fastest = seconds;
+
+    for (int batch = 1; batch < batchesPerResult; ++batch)
+        fastest = juce::jmin(fastest, timeBatch(iterations));
+
+    const double samplesPerIteration = (double)shape.numFrames * shape.numChannels;
+    const double secondsPerIteration = fastest / (double)iterations;
+
+    Result result;
+    result.kernel = kernel.name;
+    result.numChannels = shape.numChannels;
+    result.numFrames = shape.numFrames;
+    result.iterations = iterations;
+    result.nsPerSample = secondsPerIteration * 1.0e9 / samplesPerIteration;
+    result.gigabytesPerSecond = samplesPerIteration * kernel.bytesPerSample / secondsPerIteration / 1.0e9;
+    return result;
+}
+
+//==============================================================================
+// Run
+
+int KernelBenchmark::run(const juce::StringArray& arguments)
+{
+    if (arguments.contains("--help"))
+    {
+        std::cout << getUsage() << std::flush;
+        return ExitCode::succeeded;
+    }
+
+    const juce::String error = parseArguments(arguments);
+
+    if (error.isNotEmpty())
+    {
+        std::cerr << error << "\n\n" << getUsage() << std::endl;
+        return ExitCode::badArguments;
+    }
+
+    juce::var baseline;
+
+    if (options.baselineFile != juce::File())
+    {
+        baseline = juce::JSON::parse(options.baselineFile);
+
+        if (!baseline.getProperty("results", {}).isArray())
+        {
+            std::cerr << "Not a benchmark baseline - " << options.baselineFile.getFullPathName() << std::endl;
+            return ExitCode::badArguments;
+        }
+    }
+
+   #if JUCE_DEBUG
+    std::cerr << "Warning: debug build - only compare against baselines from debug builds" << std::endl;
+   #endif
+
+    scratchFile = juce::File::createTempFile(".wav");
+
+    std::cout << juce::String("kernel").paddedRight(' ', 24)
+              << juce::String("ch").paddedLeft(' ', 4)
+              << juce::String("frames").paddedLeft(' ', 12)
+              << juce::String("ns/sample").paddedLeft(' ', 12)
+              << juce::String("GB/s").paddedLeft(' ', 10) << std::endl;
+
+    juce::Array<Result> results;
+
+    for (const auto& kernel : getKernels())
+    {
+        for (const auto& shape : getShapes())
+        {
+            if (shape.numFrames > kernel.maxFrames)
+                continue;
+
+            const Result result = measure(kernel, shape);
+            results.add(result);
+
+            std::cout << result.kernel.paddedRight(' ', 24)
+                      << juce::String(result.numChannels).paddedLeft(' ', 4)
+                      << juce::String(result.numFrames).paddedLeft(' ', 12)
+                      << juce::String(result.nsPerSample, 3).paddedLeft(' ', 12)
+                      << juce::String(result.gigabytesPerSecond, 2).paddedLeft(' ', 10) << std::endl;
+        }
+    }
+
+    scratchFile.deleteFile();
+
+    if (options.saveFile != juce::File())
+    {
+        if (!options.saveFile.replaceWithText(juce::JSON::toString(toJson(results))))
+        {
+            std::cerr << "Could not write baseline - " << options.saveFile.getFullPathName() << std::endl;
+            return ExitCode::badArguments;
+        }
+
+        std::cout << "Baseline saved: " << options.saveFile.getFullPathName() << std::endl;
+    }
+
+    if (!baseline.isVoid() && compareWithBaseline(results, baseline) > 0)
+        return ExitCode::regressed;
+
+    return ExitCode::succeeded;
+}
+
+//==============================================================================
+// Baselines
+
+juce::String KernelBenchmark::getKey(const juce::String& kernel, int numChannels, int numFrames)
+{
+    return kernel + "/" + juce::String(numChannels) + "/" + juce::String(numFrames);
+}
+
+juce::var KernelBenchmark::toJson(const juce::Array<Result>& results) const
+{
+    juce::Array<juce::var> entries;
+
+    for (const auto& result : results)
+    {
+        juce::DynamicObject::Ptr entry = new juce::DynamicObject();
+        entry->setProperty("kernel", result.kernel);
+        entry->setProperty("channels", result.numChannels);
+        entry->setProperty("frames", result.numFrames);
+        entry->setProperty("iterations", result.iterations);
+        entry->setProperty("nsPerSample", result.nsPerSample);
+        entry->setProperty("gbPerSecond", result.gigabytesPerSecond);
+        entries.add(juce::var(entry.get()));
+    }
+
+    juce::DynamicObject::Ptr root = new juce::DynamicObject();
+    root->setProperty("version", 1);
+    root->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+    root->setProperty("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty("os", juce::SystemStats::getOperatingSystemName());
+   #if JUCE_DEBUG
+    root->setProperty("build", "debug");
+   #else
+    root->setProperty("build", "release");
+   #endif
+    root->setProperty("quick", options.quick);
+    root->setProperty("results", entries);
+    return juce::var(root.get());
+}
+
+int KernelBenchmark::compareWithBaseline(const juce::Array<Result>& results, const juce::var& baseline) const
+{
+    std::map<juce::String, double> baselineNs;
+
+    if (auto* entries = baseline.getProperty("results", {}).getArray())
+    {
+        for (const auto& entry : *entries)
+            baselineNs[getKey(entry.getProperty("kernel", {}).toString(),
+                              (int)entry.getProperty("channels", 0),
+                              (int)entry.getProperty("frames", 0))] = (double)entry.getProperty("nsPerSample", 0.0);
+    }
+
+    std::cout << "\nAgainst " << options.baselineFile.getFileName()
+              << " (" << baseline.getProperty("cpu", "unknown CPU").toString() << ", "
+              << baseline.getProperty("build", "unknown").toString() << " build):" << std::endl;
+
+    const double limit = 1.0 + options.tolerancePercent / 100.0;
+    int numRegressed = 0;
+
+    for (const auto& result : results)
+    {
+        const auto match = baselineNs.find(getKey(result.kernel, result.numChannels, result.numFrames));
+
+        if (match == baselineNs.end() || match->second <= 0.0)
+            continue;
+
+        const double ratio = result.nsPerSample / match->second;
+        const bool isRegression = ratio > limit;
+
+        if (isRegression)
+            ++numRegressed;
+
+        std::cout << result.kernel.paddedRight(' ', 24)
+                  << juce::String(result.numChannels).paddedLeft(' ', 4)
+                  << juce::String(result.numFrames).paddedLeft(' ', 12)
+                  << juce::String(ratio, 2).paddedLeft(' ', 10) << "x"
+                  << (isRegression ? "  REGRESSION" : (ratio < 1.0 / limit ? "  faster" : "")) << std::endl;
+    }
+
+    std::cout << numRegressed << " regression(s) beyond " << options.tolerancePercent << "%" << std::endl;
+    return numRegressed;
+}
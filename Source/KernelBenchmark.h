@@ -0,0 +1,110 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "CaptureOutput.h"
+
+//==============================================================================
+/**
+ * Micro-benchmarks for the analysis and post-processing kernels
+ *
+ * Started by Main.cpp when the command line contains --benchmark. Every
+ * kernel in AudioAnalysis and the CaptureOutput stage every capture is written
+ * through (with JUCE's 24-bit WAV writer as the reference it replaced) run over
+ * buffers from a single 128-frame block up to a 10-minute stereo capture at
+ * several channel counts. Each result is reported in ns/sample and GB/s of
+ * sample data moved.
+ *
+ *   F9_JUCE_Batch_Resampler --benchmark --save baseline.json
+ *   F9_JUCE_Batch_Resampler --benchmark --baseline baseline.json
+ *
+ * With --baseline every result is compared to the saved run and the process
+ * exits with ExitCode::regressed if any kernel got slower than the tolerance
+ * allows, so kernel rewrites can be judged by numbers. Only compare runs of
+ * the same build configuration on the same machine.
+ *
+ * Runs synchronously on the calling thread.
+ */
+class KernelBenchmark
+{
+public:
+    enum ExitCode
+    {
+        succeeded = 0,
+        badArguments = 1,
+        regressed = 5
+    };
+
+    /** One kernel over one buffer shape */
+    struct Result
+    {
+        juce::String kernel;
+        int numChannels = 0;
+        int numFrames = 0;
+        juce::int64 iterations = 0;      // Per timed batch
+        double nsPerSample = 0.0;        // Fastest batch, per sample (frames x channels)
+        double gigabytesPerSecond = 0.0; // Sample data read and written by the kernel
+    };
+
+    //==============================================================================
+    KernelBenchmark() = default;
+
+    /** Parses the arguments, runs the suite and returns the exit code */
+    int run(const juce::StringArray& arguments);
+
+    /** Usage text printed for --help and bad arguments */
+    static juce::String getUsage();
+
+private:
+    //==============================================================================
+    struct Options
+    {
+        bool quick = false;              // Skip the 10-minute captures and time shorter batches
+        juce::File saveFile;
+        juce::File baselineFile;
+        double tolerancePercent = 10.0;  // Slower than the baseline by more than this = regression
+        juce::String kernelFilter;       // Only kernels whose name contains this
+    };
+
+    struct Shape
+    {
+        int numChannels = 2;
+        int numFrames = 0;
+    };
+
+    struct Kernel
+    {
+        juce::String name;
+        double bytesPerSample = 4.0;     // Sample data the kernel has to read and write
+        int maxFrames = std::numeric_limits<int>::max();
+        std::function<void(juce::AudioBuffer<float>&)> body;
+    };
+
+    juce::String parseArguments(const juce::StringArray& arguments);
+    juce::Array<Shape> getShapes() const;
+    juce::Array<Kernel> getKernels();
+
+    Result measure(const Kernel& kernel, const Shape& shape);
+
+    /** Fills a buffer with a plausible capture: noise floor, DC bias and one transient */
+    static void fillCapture(juce::AudioBuffer<float>& buffer);
+
+    /** Writes buffer to scratchFile through CaptureOutput, pushed in writer-sized blocks as CaptureWriter does */
+    void writeCapture(const juce::AudioBuffer<float>& buffer, CaptureOutput::Format format, const CaptureOutput::Processing& processing);
+
+    juce::var toJson(const juce::Array<Result>& results) const;
+
+    /** Prints the comparison and returns the number of regressed results */
+    int compareWithBaseline(const juce::Array<Result>& results, const juce::var& baseline) const;
+
+    static juce::String getKey(const juce::String& kernel, int numChannels, int numFrames);
+
+    Options options;
+
+    // Kernel outputs are folded in here so the optimiser can't drop the work
+    double sink = 0.0;
+
+    juce::MemoryBlock encodeBlock;
+    juce::File scratchFile;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KernelBenchmark)
+};
@@ -0,0 +1,348 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "LatencyMeasurement.h"
+#include "AudioAnalysis.h"
+#include <array>
+
+namespace
+{
+constexpr float sendLevel = 0.1f;              // -20 dBFS
+constexpr double sequenceSeconds = 0.25;       // At least - the order rounds it up to 0.25 - 0.5 s
+constexpr double maxLatencySeconds = 0.4;      // Longest round trip looked for
+constexpr int maxOrder = 17;                   // Of the measurement's own sequence
+
+// Feedback taps of a maximal-length shift register for each order from minSequenceOrder up
+constexpr int sequenceTaps[][4] = { { 12, 6, 4, 1 }, { 13, 4, 3, 1 }, { 14, 5, 3, 1 }, { 15, 14, 0, 0 },
+                                    { 16, 15, 13, 4 }, { 17, 14, 0, 0 }, { 18, 11, 0, 0 }, { 19, 6, 2, 1 },
+                                    { 20, 17, 0, 0 }, { 21, 19, 0, 0 } };
+
+// Frames either side of the correlation peak left out of the sidelobe level - band-limited chains smear the peak
+constexpr int peakExclusionFrames = 64;
+
+// Peak to sidelobe ratio at which a result is fully trusted (minimumPeakToSidelobeDb gives 0)
+constexpr float fullConfidenceDb = 40.0f;
+
+// Between frames the correlation is rebuilt from this many lags either side, at this many steps per frame
+constexpr int interpolationHalfWidth = 16;
+constexpr int interpolationSteps = 64;
+}
+
+//==============================================================================
+LatencyMeasurement::LatencyMeasurement()
+    : juce::Thread("Latency Measurement")
+{
+    startThread();
+}
+
+LatencyMeasurement::~LatencyMeasurement()
+{
+    stopThread(4000);
+    cancelPendingUpdate();
+}
+
+void LatencyMeasurement::prepare(double sampleRate)
+{
+    const int order = juce::jlimit(minSequenceOrder, maxOrder, (int)std::ceil(std::log2(sequenceSeconds * sampleRate)));
+
+    sequenceFrames = (1 << order) - 1;
+    maxLatencyFrames = (int)(maxLatencySeconds * sampleRate);
+
+    stimulus.setSize(2, sequenceFrames);
+    generateSequence(order, sendLevel, stimulus.getWritePointer(0));
+    stimulus.copyFrom(1, 0, stimulus, 0, 0, sequenceFrames);
+
+    capture.setSize(2, sequenceFrames + maxLatencyFrames);
+    capture.clear();
+}
+
+void LatencyMeasurement::analyseCapture()
+{
+    {
+        const juce::ScopedLock sl(lock);
+        pendingCapture.makeCopyOf(capture);
+        pendingSequence.makeCopyOf(stimulus);
+        pendingMaxLatencyFrames = maxLatencyFrames;
+        hasPendingCapture = true;
+    }
+
+    notify();
+}
+
+void LatencyMeasurement::cancel()
+{
+    const juce::ScopedLock sl(lock);
+
+    ++generation;
+    hasPendingCapture = false;
+    finishedResults.clear();
+}
+
+//==============================================================================
+void LatencyMeasurement::run()
+{
+    while (!threadShouldExit())
+    {
+        juce::AudioBuffer<float> captured, sequence;
+        int maxLatency = 0;
+        int analysisGeneration = 0;
+
+        {
+            const juce::ScopedLock sl(lock);
+
+            if (hasPendingCapture)
+            {
+                std::swap(captured, pendingCapture);
+                std::swap(sequence, pendingSequence);
+                maxLatency = pendingMaxLatencyFrames;
+                analysisGeneration = generation;
+                hasPendingCapture = false;
+            }
+        }
+
+        if (sequence.getNumSamples() == 0)
+        {
+            wait(-1);
+            continue;
+        }
+
+        const Result result = analyse(captured, sequence.getReadPointer(0), sequence.getNumSamples(), maxLatency);
+
+        {
+            const juce::ScopedLock sl(lock);
+
+            if (analysisGeneration != generation)
+                continue;
+
+            finishedResults.add(result);
+        }
+
+        triggerAsyncUpdate();
+    }
+}
+
+void LatencyMeasurement::handleAsyncUpdate()
+{
+    juce::Array<Result> results;
+
+    {
+        const juce::ScopedLock sl(lock);
+        results.swapWith(finishedResults);
+    }
+
+    for (const auto& result : results)
+        if (onAnalysed)
+            onAnalysed(result);
+}
+
+LatencyMeasurement::Result LatencyMeasurement::analyse(const juce::AudioBuffer<float>& captured, const float* sequence,
+                                                       int sequenceFrames, int maxLatencyFrames)
+{
+    using Complex = juce::dsp::Complex<float>;
+
+    Result result;
+    const int captureFrames = captured.getNumSamples();
+    const int numReturns = juce::jmin(2, captured.getNumChannels());
+
+    if (numReturns == 0 || captureFrames == 0)
+        return result;
+
+    result.returnPeak = captured.getMagnitude(0, captureFrames);
+
+    // Long enough that the linear correlation never wraps into the lags searched
+    const int fftSize = juce::nextPowerOfTwo(captureFrames + sequenceFrames);
+    juce::dsp::FFT fft(juce::roundToInt(std::log2((double)fftSize)));
+
+    std::vector<Complex> sequenceSpectrum((size_t)fftSize), timeDomain((size_t)fftSize), spectrum((size_t)fftSize);
+
+    double sequenceEnergy = 0.0;
+
+    for (int i = 0; i < fftSize; ++i)
+    {
+        const float value = i < sequenceFrames ? sequence[i] : 0.0f;
+        sequenceEnergy += (double)value * value;
+        timeDomain[(size_t)i] = { value, 0.0f };
+    }
+
+    fft.perform(timeDomain.data(), sequenceSpectrum.data(), false);
+
+    // Both returns in one transform: the sequence is real, so the real and imaginary parts correlate independently
+    const float* left = captured.getReadPointer(0);
+    const float* right = numReturns > 1 ? captured.getReadPointer(1) : nullptr;
+
+    for (int i = 0; i < fftSize; ++i)
+    {
+        const bool inCapture = i < captureFrames;
+        timeDomain[(size_t)i] = { inCapture ? left[i] : 0.0f, inCapture && right != nullptr ? right[i] : 0.0f };
+    }
+
+    fft.perform(timeDomain.data(), spectrum.data(), false);
+
+    for (int i = 0; i < fftSize; ++i)
+        spectrum[(size_t)i] *= std::conj(sequenceSpectrum[(size_t)i]);
+
+    fft.perform(spectrum.data(), timeDomain.data(), true);
+
+    // Largest magnitude per return (either polarity), judged against the rest of the lags searched
+    const int numLags = juce::jmin(maxLatencyFrames + 1, captureFrames);
+    juce::Array<double> fractionalLags;
+    juce::Array<float> peakToSidelobes;
+
+    for (int ret = 0; ret < numReturns; ++ret)
+    {
+        // Negative lags wrap to the end of the transform, where the circular correlation keeps them
+        auto correlationAt = [&timeDomain, ret, fftSize](int lag)
+        {
+            const Complex value = timeDomain[(size_t)(((lag % fftSize) + fftSize) % fftSize)];
+            return ret == 0 ? value.real() : value.imag();
+        };
+
+        int peakLag = 0;
+        float peak = 0.0f;
+
+        for (int lag = 0; lag < numLags; ++lag)
+        {
+            if (std::abs(correlationAt(lag)) > peak)
+            {
+                peak = std::abs(correlationAt(lag));
+                peakLag = lag;
+            }
+        }
+
+        double sidelobeSquares = 0.0;
+        int numSidelobes = 0;
+
+        for (int lag = 0; lag < numLags; ++lag)
+        {
+            if (std::abs(lag - peakLag) > peakExclusionFrames)
+            {
+                sidelobeSquares += (double)correlationAt(lag) * correlationAt(lag);
+                ++numSidelobes;
+            }
+        }
+
+        const float sidelobeRms = (float)std::sqrt(sidelobeSquares / juce::jmax(1, numSidelobes));
+        const float peakToSidelobeDb = juce::Decibels::gainToDecibels(peak / juce::jmax(sidelobeRms, peak * 1.0e-6f, 1.0e-20f));
+
+        fractionalLags.add(findFractionalPeak(correlationAt, peakLag));
+        peakToSidelobes.add(peakToSidelobeDb);
+
+        if (result.returnChannel < 0 || peakToSidelobeDb > result.peakToSidelobeDb)
+        {
+            result.returnChannel = ret;
+            result.peakToSidelobeDb = peakToSidelobeDb;
+            result.returnGainDb = juce::Decibels::gainToDecibels((float)(peak / juce::jmax(sequenceEnergy, 1.0e-20)), -120.0f);
+        }
+    }
+
+    result.succeeded = result.peakToSidelobeDb >= minimumPeakToSidelobeDb;
+    result.confidence = getConfidence(result.peakToSidelobeDb);
+
+    // A return too faint to show its own peak (one side of a mono chain) is taken to match the clearest
+    double earliest = fractionalLags[result.returnChannel];
+
+    for (int ret = 0; ret < numReturns; ++ret)
+    {
+        const bool clear = peakToSidelobes[ret] >= minimumPeakToSidelobeDb;
+        result.channelLatencyFrames.add(clear ? fractionalLags[ret] : fractionalLags[result.returnChannel]);
+        earliest = juce::jmin(earliest, result.channelLatencyFrames.getLast());
+    }
+
+    result.latencyFrames = juce::jmax(0, (int)std::floor(earliest));
+
+    // Noise floor: everything but the returned sequence and a short ring-out after it
+    const int signalStart = result.latencyFrames;
+    const int signalEnd = juce::jmin(captureFrames, signalStart + sequenceFrames + sequenceFrames / 8);
+    double noiseSquares = 0.0;
+    juce::int64 numNoiseSamples = 0;
+
+    for (int ch = 0; ch < numReturns; ++ch)
+    {
+        const float* data = captured.getReadPointer(ch);
+        noiseSquares += AudioAnalysis::analyseChannel(data, signalStart).sumOfSquares
+                      + AudioAnalysis::analyseChannel(data + signalEnd, captureFrames - signalEnd).sumOfSquares;
+        numNoiseSamples += signalStart + (captureFrames - signalEnd);
+    }
+
+    if (numNoiseSamples > 0)
+        result.noiseFloorDb = 20.0f * std::log10(juce::jmax((float)std::sqrt(noiseSquares / (double)numNoiseSamples), 1e-6f));
+
+    return result;
+}
+
+//==============================================================================
+// Shared with RouteCalibration
+
+float LatencyMeasurement::getConfidence(float peakToSidelobeDb) noexcept
+{
+    return juce::jlimit(0.0f, 1.0f, (peakToSidelobeDb - minimumPeakToSidelobeDb) / (fullConfidenceDb - minimumPeakToSidelobeDb));
+}
+
+void LatencyMeasurement::generateSequence(int order, float level, float* destination)
+{
+    jassert(order >= minSequenceOrder && order <= maxSequenceOrder);
+    const auto& taps = sequenceTaps[juce::jlimit(minSequenceOrder, maxSequenceOrder, order) - minSequenceOrder];
+
+    juce::uint32 feedbackMask = 0;
+    for (int tap : taps)
+        if (tap > 0)
+            feedbackMask |= 1u << (tap - 1);
+
+    const juce::uint32 stateMask = (1u << order) - 1;
+    const int numFrames = (1 << order) - 1;
+    juce::uint32 state = 1;
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        destination[i] = (state & 1) != 0 ? level : -level;
+
+        const juce::uint32 feedback = (juce::uint32)(juce::countNumberOfBits(state & feedbackMask) & 1);
+        state = ((state << 1) | feedback) & stateMask;
+    }
+}
+
+double LatencyMeasurement::findFractionalPeak(const std::function<float(int)>& correlationAt, int peakLag)
+{
+    // The correlation is band limited, so a Hann-windowed sinc rebuilds it between lags;
+    // the finest step around the peak is then refined by a parabola
+    const double pi = juce::MathConstants<double>::pi;
+    const double polarity = correlationAt(peakLag) < 0.0f ? -1.0 : 1.0;
+
+    auto interpolateAt = [&](double lag)
+    {
+        const int before = (int)std::floor(lag);
+        double sum = 0.0;
+
+        for (int i = before - interpolationHalfWidth + 1; i <= before + interpolationHalfWidth; ++i)
+        {
+            const double x = lag - i;
+            const double sinc = x == 0.0 ? 1.0 : std::sin(pi * x) / (pi * x);
+            const double window = 0.5 + 0.5 * std::cos(pi * x / interpolationHalfWidth);
+            sum += correlationAt(i) * sinc * window;
+        }
+
+        return sum * polarity;
+    };
+
+    // The peak is within a frame of the largest lag
+    std::array<double, 2 * interpolationSteps + 1> values;
+    size_t best = interpolationSteps;
+
+    for (size_t step = 0; step < values.size(); ++step)
+    {
+        values[step] = interpolateAt(peakLag + ((int)step - interpolationSteps) / (double)interpolationSteps);
+
+        if (values[step] > values[best])
+            best = step;
+    }
+
+    double offset = 0.0;
+
+    if (best > 0 && best < values.size() - 1)
+    {
+        const double curvature = values[best - 1] - 2.0 * values[best] + values[best + 1];
+
+        if (curvature < 0.0)
+            offset = 0.5 * (values[best - 1] - values[best + 1]) / curvature;
+    }
+
+    return peakLag + ((double)best + offset - interpolationSteps) / interpolationSteps;
+}
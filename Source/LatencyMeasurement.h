@@ -0,0 +1,106 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * Round-trip latency measurement by cross-correlation with a maximum-length sequence
+ *
+ * One period of an MLS (about a third of a second at any rate) is sent on both
+ * send channels at -20 dBFS, and the returns are recorded for that long plus
+ * the longest round trip looked for. The capture is cross-correlated with the
+ * sequence by FFT on the measurement's own thread; the lag of the largest
+ * correlation magnitude is each return's latency. The chain is band limited,
+ * so so is the correlation, and interpolating it between lags places the
+ * peak to a small fraction of a frame - the returns of a chain rarely differ
+ * by whole frames (see FractionalDelay).
+ *
+ * The correlation gains about 10 log10(N) dB over the noise, so the
+ * sequence can be sent far below the level an impulse needs, and noise,
+ * polarity or a low return gain no longer hide it. How far the peak stands
+ * above the rest of the correlation gives the confidence of the result.
+ *
+ * Threading: prepare() / analyseCapture() / results on the message thread,
+ * the capture is written by the audio thread in between, the correlation
+ * runs on the measurement's thread.
+ */
+class LatencyMeasurement : private juce::Thread,
+                           private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    /** Reported on the message thread once a capture has been analysed */
+    struct Result
+    {
+        bool succeeded = false;
+        int latencyFrames = -1;         // Whole frames common to every return - the earliest, rounded down
+        juce::Array<double> channelLatencyFrames;  // Per return; one with no clear peak of its own takes the clearest one's
+        int returnChannel = -1;         // The return that shows the sequence most clearly
+        float peakToSidelobeDb = 0.0f;  // Correlation peak over the RMS of the rest
+        float confidence = 0.0f;        // 0 - 1, from peakToSidelobeDb
+        float returnGainDb = 0.0f;      // Chain gain, send to return
+        float returnPeak = 0.0f;        // Largest captured sample, to spot clipping
+        float noiseFloorDb = -120.0f;   // RMS of the capture outside the returned sequence
+    };
+
+    /** Results below this are reported as failed */
+    static constexpr float minimumPeakToSidelobeDb = 20.0f;
+
+    /** Sequence orders generateSequence() has feedback taps for */
+    static constexpr int minSequenceOrder = 12, maxSequenceOrder = 21;
+
+    /** Confidence (0 - 1) of a correlation peak this far above the rest */
+    static float getConfidence(float peakToSidelobeDb) noexcept;
+
+    /** Writes the 2^order - 1 frames of a maximum-length sequence of +-level */
+    static void generateSequence(int order, float level, float* destination);
+
+    /**
+     * Lag of a band-limited correlation's peak to a fraction of a frame
+     * @param correlationAt Signed correlation at any lag within 17 frames of peakLag
+     * @param peakLag The lag of the largest magnitude
+     */
+    static double findFractionalPeak(const std::function<float(int)>& correlationAt, int peakLag);
+
+    //==============================================================================
+    LatencyMeasurement();
+    ~LatencyMeasurement() override;
+
+    /** Builds the sequence for a sample rate and clears the capture */
+    void prepare(double sampleRate);
+
+    /** Two channels, the same sequence on both */
+    juce::AudioBuffer<float>& getStimulus() noexcept { return stimulus; }
+
+    /** Two channels, written by the audio thread from the first frame sent */
+    juce::AudioBuffer<float>& getCapture() noexcept { return capture; }
+
+    /** Correlates a copy of the completed capture on the measurement's thread */
+    void analyseCapture();
+
+    /** Drops an analysis not yet delivered */
+    void cancel();
+
+    /** Called on the message thread with each analysed capture */
+    std::function<void(const Result&)> onAnalysed;
+
+private:
+    //==============================================================================
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    static Result analyse(const juce::AudioBuffer<float>& captured, const float* sequence, int sequenceFrames, int maxLatencyFrames);
+
+    int sequenceFrames = 0;
+    int maxLatencyFrames = 0;
+    juce::AudioBuffer<float> stimulus, capture;
+
+    juce::CriticalSection lock;
+    juce::AudioBuffer<float> pendingCapture, pendingSequence;  // Copied for the thread by analyseCapture()
+    int pendingMaxLatencyFrames = 0;
+    bool hasPendingCapture = false;
+    int generation = 0;  // Bumped by cancel() to discard a running analysis
+    juce::Array<Result> finishedResults;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyMeasurement)
+};
@@ -0,0 +1,144 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "LatencyProfileStore.h"
+
+namespace
+{
+// Bump when the profile layout changes - older stores are then ignored and rebuilt
+constexpr int storeVersion = 3;
+
+// Measurements this close (frames) count as the same latency
+constexpr int agreementFrames = 1;
+}
+
+//==============================================================================
+LatencyProfileStore::LatencyProfileStore(const juce::File& storeFileToUse)
+    : storeFile(storeFileToUse)
+{
+    load();
+}
+
+juce::File LatencyProfileStore::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("F9 Batch Resampler")
+               .getChildFile("LatencyProfiles.json");
+}
+
+//==============================================================================
+// Profiles
+
+bool LatencyProfileStore::lookup(const Key& key, Profile& profile) const
+{
+    for (const auto& candidate : profiles)
+    {
+        if (candidate.key == key)
+        {
+            profile = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+LatencyProfileStore::Profile LatencyProfileStore::store(const Key& key, int latencyFrames, const juce::Array<double>& channelLatencyFrames,
+                                                        float noiseFloorDb, float confidence)
+{
+    Profile profile;
+    profile.key = key;
+    profile.latencyFrames = latencyFrames;
+    profile.channelLatencyFrames = channelLatencyFrames;
+    profile.noiseFloorDb = noiseFloorDb;
+    profile.measuredAt = juce::Time::getCurrentTime();
+    profile.confidence = confidence;
+    profile.numMeasurements = 1;
+
+    Profile previous;
+    const bool hadProfile = lookup(key, previous);
+
+    // Agreeing measurements are independent evidence: each one removes part of the remaining doubt
+    if (hadProfile && std::abs(previous.latencyFrames - latencyFrames) <= agreementFrames)
+    {
+        profile.confidence = 1.0f - (1.0f - previous.confidence) * (1.0f - confidence);
+        profile.numMeasurements = previous.numMeasurements + 1;
+    }
+
+    profiles.removeIf([&key](const Profile& p) { return p.key == key; });
+    profiles.add(profile);
+    save();
+
+    return profile;
+}
+
+//==============================================================================
+// Storage
+
+void LatencyProfileStore::load()
+{
+    const juce::var stored = juce::JSON::parse(storeFile);
+
+    if ((int)stored.getProperty("version", 0) != storeVersion)
+        return;
+
+    if (auto* entries = stored.getProperty("profiles", {}).getArray())
+    {
+        for (const auto& entry : *entries)
+        {
+            Profile profile;
+            profile.key.deviceTypeName = entry.getProperty("type", {}).toString();
+            profile.key.deviceID = entry.getProperty("device", {}).toString();
+            profile.key.sampleRate = entry.getProperty("sampleRate", 0.0);
+            profile.key.bufferSize = entry.getProperty("bufferSize", 0);
+            profile.key.inputLeft = entry.getProperty("inputLeft", 0);
+            profile.key.inputRight = entry.getProperty("inputRight", 0);
+            profile.key.outputLeft = entry.getProperty("outputLeft", 0);
+            profile.key.outputRight = entry.getProperty("outputRight", 0);
+            profile.latencyFrames = entry.getProperty("latencyFrames", -1);
+
+            if (auto* channelLatencies = entry.getProperty("channelLatencyFrames", {}).getArray())
+                for (const auto& latency : *channelLatencies)
+                    profile.channelLatencyFrames.add((double)latency);
+
+            profile.noiseFloorDb = entry.getProperty("noiseFloorDb", 0.0f);
+            profile.measuredAt = juce::Time((juce::int64)entry.getProperty("measuredAt", 0));
+            profile.confidence = entry.getProperty("confidence", 0.0f);
+            profile.numMeasurements = entry.getProperty("measurements", 1);
+
+            if (profile.latencyFrames >= 0)
+                profiles.add(profile);
+        }
+    }
+}
+
+bool LatencyProfileStore::save() const
+{
+    juce::Array<juce::var> entries;
+
+    for (const auto& profile : profiles)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("type", profile.key.deviceTypeName);
+        entry->setProperty("device", profile.key.deviceID);
+        entry->setProperty("sampleRate", profile.key.sampleRate);
+        entry->setProperty("bufferSize", profile.key.bufferSize);
+        entry->setProperty("inputLeft", profile.key.inputLeft);
+        entry->setProperty("inputRight", profile.key.inputRight);
+        entry->setProperty("outputLeft", profile.key.outputLeft);
+        entry->setProperty("outputRight", profile.key.outputRight);
+        entry->setProperty("latencyFrames", profile.latencyFrames);
+        entry->setProperty("channelLatencyFrames", juce::Array<juce::var>(profile.channelLatencyFrames.begin(),
+                                                                          profile.channelLatencyFrames.size()));
+        entry->setProperty("noiseFloorDb", profile.noiseFloorDb);
+        entry->setProperty("measuredAt", profile.measuredAt.toMilliseconds());
+        entry->setProperty("confidence", profile.confidence);
+        entry->setProperty("measurements", profile.numMeasurements);
+        entries.add(juce::var(entry));
+    }
+
+    auto* stored = new juce::DynamicObject();
+    stored->setProperty("version", storeVersion);
+    stored->setProperty("profiles", entries);
+
+    storeFile.getParentDirectory().createDirectory();
+    return storeFile.replaceWithText(juce::JSON::toString(juce::var(stored)));
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * Persistent latency and noise floor measurements, one per device setup
+ *
+ * A round trip only stays the same while the device, its type, sample rate,
+ * buffer size and the channels in use do, so that whole configuration is the
+ * key. Each profile keeps the latency (to a fraction of a frame per return)
+ * and noise floor, when they were
+ * measured and how far the measurement can be trusted: the confidence comes
+ * from the measurement itself (see LatencyMeasurement), and grows when a new
+ * measurement agrees with the stored one.
+ *
+ * Going back to a setup measured before then restores its profile instead of
+ * invalidating the latency, so a batch can start without measuring again.
+ *
+ * Profiles are kept in a small JSON file and written on every change.
+ * Message thread only.
+ */
+class LatencyProfileStore
+{
+public:
+    //==============================================================================
+    /** Everything a measured latency depends on */
+    struct Key
+    {
+        juce::String deviceTypeName;
+        juce::String deviceID;
+        double sampleRate = 0.0;
+        int bufferSize = 0;
+        int inputLeft = 0, inputRight = 0;    // 1-indexed, as in StereoPair
+        int outputLeft = 0, outputRight = 0;
+
+        bool operator==(const Key& other) const
+        {
+            return deviceTypeName == other.deviceTypeName && deviceID == other.deviceID
+                && juce::roundToInt(sampleRate) == juce::roundToInt(other.sampleRate) && bufferSize == other.bufferSize
+                && inputLeft == other.inputLeft && inputRight == other.inputRight
+                && outputLeft == other.outputLeft && outputRight == other.outputRight;
+        }
+    };
+
+    struct Profile
+    {
+        Key key;
+        int latencyFrames = -1;      // Whole frames, as ProcessingSettings::measuredLatencyFrames
+        juce::Array<double> channelLatencyFrames;  // Per return, as ProcessingSettings::measuredChannelLatencyFrames
+        float noiseFloorDb = 0.0f;
+        juce::Time measuredAt;       // Of the latest measurement
+        float confidence = 0.0f;     // 0 - 1
+        int numMeasurements = 0;     // Agreeing measurements behind this profile
+    };
+
+    /** Profiles below this are kept, but not restored */
+    static constexpr float minimumRestoreConfidence = 0.5f;
+
+    //==============================================================================
+    /** Loads the profiles stored in storeFile */
+    explicit LatencyProfileStore(const juce::File& storeFile = getDefaultFile());
+
+    /** Returns false if the setup has never been measured */
+    bool lookup(const Key& key, Profile& profile) const;
+
+    /**
+     * Records a measurement and saves the store
+     * A result that matches the stored latency adds to its confidence; one that doesn't replaces it.
+     * @return The profile as stored
+     */
+    Profile store(const Key& key, int latencyFrames, const juce::Array<double>& channelLatencyFrames,
+                  float noiseFloorDb, float confidence);
+
+    /** Where the app keeps its profiles */
+    static juce::File getDefaultFile();
+
+private:
+    //==============================================================================
+    void load();
+    bool save() const;
+
+    const juce::File storeFile;
+    juce::Array<Profile> profiles;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyProfileStore)
+};
@@ -0,0 +1,222 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "LogBuffer.h"
+
+namespace
+{
+// How often the sink thread drains the queue and writes the file
+constexpr int sinkIntervalMs = 100;
+}
+
+//==============================================================================
+LogBuffer::LogBuffer()
+    : LogBuffer(getDefaultFile())
+{
+}
+
+LogBuffer::LogBuffer(const juce::File& logFileToUse)
+    : juce::Thread("Log Sink"),
+      logFile(logFileToUse),
+      slots(new Slot[(size_t)queueCapacity])
+{
+    static_assert((queueCapacity & (queueCapacity - 1)) == 0, "queueCapacity must be a power of two");
+
+    for (int i = 0; i < queueCapacity; ++i)
+        slots[(size_t)i].sequence.store((juce::uint64)i, std::memory_order_relaxed);
+
+    startThread(juce::Thread::Priority::background);
+}
+
+LogBuffer::~LogBuffer()
+{
+    stopThread(2000);
+
+    // Whatever was logged after the last pass still belongs in the file
+    drain();
+    writeToFile(unwrittenLines);
+}
+
+juce::File LogBuffer::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("F9 Batch Resampler")
+               .getChildFile("Logs")
+               .getChildFile("F9BatchResampler.log");
+}
+
+//==============================================================================
+// Producers
+
+void LogBuffer::append(const juce::String& message)
+{
+    const juce::String line = juce::Time::getCurrentTime().formatted("[%Y-%m-%dT%H:%M:%S]") + " " + message;
+
+    juce::uint64 position = enqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+
+    for (;;)
+    {
+        slot = &slots[(size_t)(position & (queueCapacity - 1))];
+        const juce::uint64 sequence = slot->sequence.load(std::memory_order_acquire);
+        const auto difference = (juce::int64)(sequence - position);
+
+        if (difference == 0)
+        {
+            // Free slot for this position - claim it
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            // Full - the consumer hasn't freed this slot since its last lap
+            ++droppedLines;
+            ++linesAppended;
+            return;
+        }
+        else
+        {
+            // Another producer took it first
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->text = line;
+    slot->sequence.store(position + 1, std::memory_order_release);
+    ++linesAppended;
+}
+
+//==============================================================================
+// Consumer
+
+bool LogBuffer::pop(juce::String& line)
+{
+    Slot& slot = slots[(size_t)(dequeuePosition & (queueCapacity - 1))];
+
+    if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+        return false;
+
+    line = std::move(slot.text);
+    slot.text = {};
+    slot.sequence.store(dequeuePosition + queueCapacity, std::memory_order_release);
+    ++dequeuePosition;
+    return true;
+}
+
+void LogBuffer::drain()
+{
+    const juce::ScopedLock sl(drainLock);
+
+    juce::String line;
+    while (pop(line))
+    {
+        history.add(line);
+        unwrittenLines.add(line);
+    }
+
+    if (const int dropped = droppedLines.exchange(0); dropped > 0)
+    {
+        line = juce::Time::getCurrentTime().formatted("[%Y-%m-%dT%H:%M:%S]") + " Warning: "
+             + juce::String(dropped) + " log lines dropped";
+        history.add(line);
+        unwrittenLines.add(line);
+    }
+
+    // Trim in chunks, so the history isn't shuffled down on every line
+    if (history.size() > historyLines + historyLines / 4)
+    {
+        const int excess = history.size() - historyLines;
+        history.removeRange(0, excess);
+        firstHistoryLine += excess;
+    }
+}
+
+juce::StringArray LogBuffer::getLinesSince(juce::int64& nextLine)
+{
+    drain();
+
+    const juce::ScopedLock sl(drainLock);
+    const juce::int64 endLine = firstHistoryLine + history.size();
+
+    juce::StringArray lines;
+
+    for (juce::int64 line = juce::jmax(nextLine, firstHistoryLine); line < endLine; ++line)
+        lines.add(history[(int)(line - firstHistoryLine)]);
+
+    nextLine = endLine;
+    return lines;
+}
+
+juce::StringArray LogBuffer::getRetainedLines()
+{
+    juce::int64 fromStart = 0;
+    return getLinesSince(fromStart);
+}
+
+//==============================================================================
+// File Sink
+
+void LogBuffer::run()
+{
+    while (!threadShouldExit())
+    {
+        wait(sinkIntervalMs);
+        drain();
+
+        juce::StringArray lines;
+
+        {
+            const juce::ScopedLock sl(drainLock);
+            lines.swapWith(unwrittenLines);
+        }
+
+        writeToFile(lines);
+    }
+}
+
+void LogBuffer::writeToFile(const juce::StringArray& lines)
+{
+    if (lines.isEmpty() || logFile == juce::File())
+        return;
+
+    if (fileStream == nullptr)
+    {
+        if (!logFile.getParentDirectory().createDirectory())
+            return;
+
+        fileStream = std::make_unique<juce::FileOutputStream>(logFile);  // Appends
+
+        if (fileStream->failedToOpen())
+        {
+            fileStream.reset();
+            return;
+        }
+    }
+
+    for (const auto& line : lines)
+        *fileStream << line << juce::newLine;
+
+    fileStream->flush();
+
+    if (fileStream->getPosition() > maxLogFileBytes)
+        rotateLogFile();
+}
+
+void LogBuffer::rotateLogFile()
+{
+    fileStream.reset();
+
+    auto rotatedFile = [this](int index)
+    {
+        return logFile.getSiblingFile(logFile.getFileNameWithoutExtension() + "." + juce::String(index)
+                                      + logFile.getFileExtension());
+    };
+
+    // F9BatchResampler.log -> .1.log -> .2.log ... the oldest falls off the end
+    rotatedFile(numRotatedFiles).deleteFile();
+
+    for (int i = numRotatedFiles - 1; i >= 1; --i)
+        rotatedFile(i).moveFileTo(rotatedFile(i + 1));
+
+    logFile.moveFileTo(rotatedFile(1));
+
+    // The next write reopens a fresh file
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * Application log: bounded, thread-safe, with a rotating file behind it
+ *
+ * append() can be called from any thread (the device thread logs from
+ * prepareToPlay) without taking a lock: lines go into a fixed ring of slots
+ * claimed with a compare-and-swap (a bounded multi-producer queue after
+ * Vyukov). If producers outrun the consumer the extra lines are counted and
+ * reported as dropped rather than blocking anyone.
+ *
+ * The queue is drained by the sink thread every few milliseconds, or on
+ * demand by readers. Drained lines are kept in a bounded history of the most
+ * recent lines for the UI and the headless runner, which read only what is new
+ * by line number. Every line is also written to a log file that is rotated
+ * when it grows too large, so the full history survives on disk.
+ *
+ * Threading: append() from anywhere; the readers from one thread at a time
+ * each (they share the drain under a lock).
+ */
+class LogBuffer : private juce::Thread
+{
+public:
+    //==============================================================================
+    /** Logs to getDefaultFile() */
+    LogBuffer();
+
+    /** Logs to the given file; an empty File keeps the history in memory only */
+    explicit LogBuffer(const juce::File& logFileToUse);
+
+    ~LogBuffer() override;
+
+    /** Timestamps and queues a line - lock-free, safe from any thread */
+    void append(const juce::String& message);
+
+    /**
+     * Returns the lines from nextLine on and moves nextLine past them
+     * Lines that have already dropped out of the history are skipped; start at 0 for everything retained
+     */
+    juce::StringArray getLinesSince(juce::int64& nextLine);
+
+    /** Lines still in the history */
+    juce::StringArray getRetainedLines();
+
+    /** Counts every line appended so far - cheap, for readers to check before asking for lines */
+    juce::uint64 getNumLinesAppended() const noexcept { return linesAppended.load(); }
+
+    const juce::File& getLogFile() const noexcept { return logFile; }
+
+    /** Where the app writes its log */
+    static juce::File getDefaultFile();
+
+private:
+    //==============================================================================
+    static constexpr int queueCapacity = 1024;      // Lines between two drains - a power of two
+    static constexpr int historyLines = 2000;        // Kept in memory for the readers
+    static constexpr juce::int64 maxLogFileBytes = 4 * 1024 * 1024;
+    static constexpr int numRotatedFiles = 4;        // F9BatchResampler.1.log ... .4.log
+
+    struct Slot
+    {
+        std::atomic<juce::uint64> sequence { 0 };
+        juce::String text;
+    };
+
+    void run() override;
+
+    /** Moves queued lines into the history (consumer side, under drainLock) */
+    void drain();
+    bool pop(juce::String& line);
+
+    void writeToFile(const juce::StringArray& lines);
+    void rotateLogFile();
+
+    const juce::File logFile;
+
+    // Producers -> consumer
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<juce::uint64> enqueuePosition { 0 };
+    juce::uint64 dequeuePosition = 0;              // Consumer only
+    std::atomic<int> droppedLines { 0 };
+    std::atomic<juce::uint64> linesAppended { 0 };  // Published or dropped
+
+    // Consumer side
+    juce::CriticalSection drainLock;
+    juce::StringArray history;
+    juce::int64 firstHistoryLine = 0;              // Line number of history[0]
+    juce::StringArray unwrittenLines;              // Drained, not yet in the file
+
+    // Sink thread only
+    std::unique_ptr<juce::FileOutputStream> fileStream;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LogBuffer)
+};
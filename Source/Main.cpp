@@ -9,6 +9,8 @@
 #include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "HeadlessRunner.h"
+#include "KernelBenchmark.h"
 
 //==============================================================================
 class NewProjectApplication  : public juce::JUCEApplication
@@ -26,6 +28,23 @@ public:
     {
         // This method is where you should put your application's initialisation code..
 
+        // Console mode: same engine, no window - see HeadlessRunner for the options
+        if (getCommandLineParameterArray().contains ("--headless"))
+        {
+            headlessRunner.reset (new HeadlessRunner());
+            headlessRunner->start (getCommandLineParameterArray());
+            return;
+        }
+
+        // Kernel micro-benchmarks: runs to completion, then quits
+        if (getCommandLineParameterArray().contains ("--benchmark"))
+        {
+            KernelBenchmark benchmark;
+            setApplicationReturnValue (benchmark.run (getCommandLineParameterArray()));
+            quit();
+            return;
+        }
+
         mainWindow.reset (new MainWindow (getApplicationName()));
     }
 
@@ -34,6 +53,7 @@ public:
         // Add your application's shutdown code here..
 
         mainWindow = nullptr; // (deletes our window)
+        headlessRunner = nullptr;
     }
 
     //==============================================================================
@@ -99,6 +119,7 @@ public:
 
 private:
     std::unique_ptr<MainWindow> mainWindow;
+    std::unique_ptr<HeadlessRunner> headlessRunner;
 };
 
 //==============================================================================
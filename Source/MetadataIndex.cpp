@@ -0,0 +1,250 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "MetadataIndex.h"
+
+namespace
+{
+// Bump when Record or FileHeader change - older files are then ignored and rebuilt
+constexpr juce::uint32 indexVersion = 1;
+constexpr char indexMagic[4] = { 'F', '9', 'M', 'I' };
+
+struct FileHeader
+{
+    char magic[4];
+    juce::uint32 version;
+    juce::uint64 numRecords;
+};
+
+static_assert(sizeof(FileHeader) == 16, "Records must start 8-byte aligned");
+}
+
+//==============================================================================
+MetadataIndex::MetadataIndex(const juce::File& fileToUse)
+    : indexFile(fileToUse)
+{
+    openMapping();
+}
+
+MetadataIndex::~MetadataIndex()
+{
+    save();
+}
+
+juce::File MetadataIndex::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("F9 Batch Resampler")
+               .getChildFile("MetadataIndex.bin");
+}
+
+juce::uint64 MetadataIndex::hashPath(const juce::File& file) noexcept
+{
+    // FNV-1a over the UTF-8 path - stable across runs and builds, unlike String::hash()
+    juce::uint64 hash = 0xcbf29ce484222325ull;
+
+    for (auto* c = file.getFullPathName().toRawUTF8(); *c != 0; ++c)
+        hash = (hash ^ (juce::uint8)*c) * 0x100000001b3ull;
+
+    return hash;
+}
+
+//==============================================================================
+// Lookup
+
+AudioFile::Metadata MetadataIndex::getMetadata(const juce::File& file)
+{
+    Entry entry;
+
+    if (!lookup(file, entry))
+    {
+        if (!file.existsAsFile())
+            return {};
+
+        const AudioFile::Metadata probed = AudioFile::probe(file);
+
+        entry = Entry();
+        entry.fileSize = file.getSize();
+        entry.modificationTime = file.getLastModificationTime().toMilliseconds();
+        entry.sampleRate = probed.sampleRate;
+        entry.durationSamples = probed.durationSamples;
+        entry.numChannels = (juce::uint32)probed.numChannels;
+        entry.flags = probed.readable ? Entry::readable : 0;
+
+        store(hashPath(file), entry);
+        return probed;
+    }
+
+    AudioFile::Metadata metadata;
+    metadata.readable = (entry.flags & Entry::readable) != 0;
+    metadata.sampleRate = entry.sampleRate;
+    metadata.durationSamples = entry.durationSamples;
+    metadata.numChannels = (int)entry.numChannels;
+    return metadata;
+}
+
+bool MetadataIndex::lookup(const juce::File& file, Entry& entry)
+{
+    const juce::uint64 pathHash = hashPath(file);
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (!findEntry(pathHash, entry))
+            return false;
+    }
+
+    // Revalidated on every use: an edited or replaced file no longer matches
+    return entry.fileSize == file.getSize()
+        && entry.modificationTime == file.getLastModificationTime().toMilliseconds();
+}
+
+void MetadataIndex::storeAnalysis(const juce::File& file, float peak, float rms, juce::uint64 contentHash)
+{
+    Entry entry;
+
+    if (!lookup(file, entry))
+        return;
+
+    entry.peak = peak;
+    entry.rms = rms;
+    entry.contentHash = contentHash;
+    entry.flags |= Entry::hasAnalysis;
+
+    store(hashPath(file), entry);
+}
+
+bool MetadataIndex::findEntry(juce::uint64 pathHash, Entry& entry) const
+{
+    const auto changed = changedEntries.find(pathHash);
+
+    if (changed != changedEntries.end())
+    {
+        entry = changed->second;
+        return true;
+    }
+
+    const Record* end = mappedRecords + numMappedRecords;
+    const Record* record = std::lower_bound(mappedRecords, end, pathHash,
+                                            [](const Record& r, juce::uint64 hash) { return r.pathHash < hash; });
+
+    if (record == end || record->pathHash != pathHash)
+        return false;
+
+    std::memcpy(&entry, &record->entry, sizeof(Entry));
+    return true;
+}
+
+void MetadataIndex::store(juce::uint64 pathHash, const Entry& entry)
+{
+    const juce::ScopedLock sl(lock);
+    changedEntries[pathHash] = entry;
+}
+
+//==============================================================================
+// Storage
+
+void MetadataIndex::openMapping()
+{
+    mappedRecords = nullptr;
+    numMappedRecords = 0;
+    mappedFile.reset();
+
+    if (!indexFile.existsAsFile())
+        return;
+
+    auto mapping = std::make_unique<juce::MemoryMappedFile>(indexFile, juce::MemoryMappedFile::readOnly);
+
+    if (mapping->getData() == nullptr || mapping->getSize() < sizeof(FileHeader))
+        return;
+
+    FileHeader header;
+    std::memcpy(&header, mapping->getData(), sizeof(header));
+
+    if (std::memcmp(header.magic, indexMagic, sizeof(indexMagic)) != 0
+        || header.version != indexVersion
+        || header.numRecords > (mapping->getSize() - sizeof(FileHeader)) / sizeof(Record))
+    {
+        DBG("Ignoring unreadable metadata index - " << indexFile.getFullPathName());
+        return;
+    }
+
+    mappedRecords = reinterpret_cast<const Record*>(static_cast<const char*>(mapping->getData()) + sizeof(FileHeader));
+    numMappedRecords = (size_t)header.numRecords;
+    mappedFile = std::move(mapping);
+}
+
+bool MetadataIndex::save()
+{
+    const juce::ScopedLock sl(lock);
+
+    if (changedEntries.empty())
+        return true;
+
+    if (!indexFile.getParentDirectory().createDirectory())
+        return false;
+
+    juce::TemporaryFile tempFile(indexFile);
+
+    {
+        juce::FileOutputStream out(tempFile.getFile());
+
+        if (out.failedToOpen())
+            return false;
+
+        // Count first: the merged size is needed for the header
+        juce::uint64 numRecords = changedEntries.size();
+        for (size_t i = 0; i < numMappedRecords; ++i)
+            if (changedEntries.count(mappedRecords[i].pathHash) == 0)
+                ++numRecords;
+
+        FileHeader header;
+        std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+        header.version = indexVersion;
+        header.numRecords = numRecords;
+        out.write(&header, sizeof(header));
+
+        // Merge the two sorted sequences; a changed entry replaces its mapped one
+        size_t mapped = 0;
+        auto changed = changedEntries.begin();
+
+        while (mapped < numMappedRecords || changed != changedEntries.end())
+        {
+            Record record;
+
+            if (changed == changedEntries.end()
+                || (mapped < numMappedRecords && mappedRecords[mapped].pathHash < changed->first))
+            {
+                std::memcpy(&record, mappedRecords + mapped++, sizeof(Record));
+            }
+            else
+            {
+                if (mapped < numMappedRecords && mappedRecords[mapped].pathHash == changed->first)
+                    ++mapped;
+
+                record.pathHash = changed->first;
+                record.entry = changed->second;
+                ++changed;
+            }
+
+            out.write(&record, sizeof(record));
+        }
+
+        out.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    // The old file can't be replaced while it is mapped (Windows)
+    mappedFile.reset();
+    mappedRecords = nullptr;
+    numMappedRecords = 0;
+
+    const bool replaced = tempFile.overwriteTargetFileWithTemporary();
+
+    openMapping();
+
+    if (replaced)
+        changedEntries.clear();
+
+    return replaced;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AppState.h"
+
+//==============================================================================
+/**
+ * Persistent index of source file metadata
+ *
+ * Remembers what was learned about every file ever added - header fields, and
+ * once a file has been decoded for a batch its peak, RMS and a content hash -
+ * so re-adding a large library costs one stat() per file instead of a header
+ * parse. Entries are keyed by a 64-bit hash of the full path and are only
+ * trusted while the file's size and modification time still match; anything
+ * stale is re-probed the next time it is asked for.
+ *
+ * On disk the index is a sorted array of fixed 64-byte records behind a small
+ * header, memory-mapped read-only and binary-searched in place. New and
+ * updated entries collect in memory and are merged into a fresh file by
+ * save(). Records are native-endian - the index is a cache, and a file from a
+ * different build simply fails the header check and starts over.
+ *
+ * Thread safe: lookups and stores may come from any thread.
+ */
+class MetadataIndex
+{
+public:
+    //==============================================================================
+    /** Everything stored for one file */
+    struct Entry
+    {
+        enum Flags : juce::uint32
+        {
+            readable    = 1 << 0,  // The header could be read - otherwise only size and time are valid
+            hasAnalysis = 1 << 1   // peak, rms and contentHash are set
+        };
+
+        juce::int64 fileSize = 0;
+        juce::int64 modificationTime = 0;  // Milliseconds since 1970
+        double sampleRate = 0.0;
+        juce::int64 durationSamples = 0;
+        juce::uint32 numChannels = 0;
+        juce::uint32 flags = 0;
+        float peak = 0.0f;
+        float rms = 0.0f;
+        juce::uint64 contentHash = 0;
+    };
+
+    //==============================================================================
+    /** Opens (or starts) the index stored in indexFile */
+    explicit MetadataIndex(const juce::File& indexFile = getDefaultFile());
+
+    /** Saves any new entries */
+    ~MetadataIndex();
+
+    /** Metadata from the index if the file is unchanged, otherwise read from its header and stored */
+    AudioFile::Metadata getMetadata(const juce::File& file);
+
+    /** Returns false if there is no up-to-date entry for the file */
+    bool lookup(const juce::File& file, Entry& entry);
+
+    /** Records the decoded content of an up-to-date entry */
+    void storeAnalysis(const juce::File& file, float peak, float rms, juce::uint64 contentHash);
+
+    /** Merges the new entries into the file on disk; does nothing if nothing changed */
+    bool save();
+
+    /** Where the app keeps its index */
+    static juce::File getDefaultFile();
+
+private:
+    //==============================================================================
+    struct Record
+    {
+        juce::uint64 pathHash;
+        Entry entry;
+    };
+
+    static_assert(sizeof(Record) == 64, "Index records must stay 64 bytes - bump the file version if the layout changes");
+
+    static juce::uint64 hashPath(const juce::File& file) noexcept;
+
+    void openMapping();
+    bool findEntry(juce::uint64 pathHash, Entry& entry) const;
+    void store(juce::uint64 pathHash, const Entry& entry);
+
+    const juce::File indexFile;
+
+    mutable juce::CriticalSection lock;
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const Record* mappedRecords = nullptr;  // Sorted by pathHash
+    size_t numMappedRecords = 0;
+    std::map<juce::uint64, Entry> changedEntries;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MetadataIndex)
+};
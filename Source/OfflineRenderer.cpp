@@ -0,0 +1,429 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "OfflineRenderer.h"
+#include "AudioAnalysis.h"
+
+namespace
+{
+// Output channels written per file (the first two processor outputs)
+constexpr int outputChannels = 2;
+
+// Consecutive blocks below the threshold before a reverb tail counts as decayed
+constexpr int requiredSilentBlocks = 8;
+}
+
+//==============================================================================
+/**
+ * What the workers render through - a plugin instance or a convolution engine
+ *
+ * prepare() and release() are called on the message thread, the rest on the
+ * owning worker's thread.
+ */
+class OfflineRenderer::Processor
+{
+public:
+    virtual ~Processor() = default;
+
+    virtual void prepare(double sampleRate, int blockSize) = 0;
+    virtual void release() {}
+
+    /** Channels the process buffer needs (at least outputChannels) */
+    virtual int getNumChannels() const = 0;
+    virtual int getNumInputChannels() const = 0;
+    virtual int getLatencySamples() const = 0;
+
+    /** Clears any state left over from the previous file */
+    virtual void reset() = 0;
+
+    /** Processes one block in place; the first outputChannels channels are the result */
+    virtual void process(juce::AudioBuffer<float>& buffer) = 0;
+};
+
+//==============================================================================
+class OfflineRenderer::PluginProcessor : public OfflineRenderer::Processor
+{
+public:
+    explicit PluginProcessor(std::unique_ptr<juce::AudioPluginInstance> pluginToUse)
+        : plugin(std::move(pluginToUse))
+    {
+    }
+
+    void prepare(double sampleRate, int blockSize) override
+    {
+        // Stereo in/out where the plugin allows it, otherwise its default layout
+        juce::AudioProcessor::BusesLayout stereoLayout;
+        stereoLayout.inputBuses.add(juce::AudioChannelSet::stereo());
+        stereoLayout.outputBuses.add(juce::AudioChannelSet::stereo());
+        plugin->setBusesLayout(stereoLayout);
+
+        plugin->setNonRealtime(true);
+        plugin->prepareToPlay(sampleRate, blockSize);
+    }
+
+    void release() override { plugin->releaseResources(); }
+
+    int getNumChannels() const override
+    {
+        return juce::jmax(outputChannels, plugin->getTotalNumInputChannels(), plugin->getTotalNumOutputChannels());
+    }
+
+    int getNumInputChannels() const override { return plugin->getTotalNumInputChannels(); }
+    int getLatencySamples() const override   { return plugin->getLatencySamples(); }
+    void reset() override                    { plugin->reset(); }
+
+    void process(juce::AudioBuffer<float>& buffer) override
+    {
+        midiBuffer.clear();
+        plugin->processBlock(buffer, midiBuffer);
+    }
+
+private:
+    std::unique_ptr<juce::AudioPluginInstance> plugin;
+    juce::MidiBuffer midiBuffer;
+};
+
+//==============================================================================
+class OfflineRenderer::ConvolutionProcessor : public OfflineRenderer::Processor
+{
+public:
+    explicit ConvolutionProcessor(std::shared_ptr<const PartitionedConvolution::Kernel> kernel)
+        : convolution(std::move(kernel))
+    {
+    }
+
+    void prepare(double, int blockSize) override
+    {
+        jassert(blockSize == convolution.getKernel().getBlockSize());
+        inputCopy.setSize(outputChannels, blockSize);
+    }
+
+    int getNumChannels() const override      { return outputChannels; }
+    int getNumInputChannels() const override { return outputChannels; }
+    int getLatencySamples() const override   { return 0; }
+    void reset() override                    { convolution.reset(); }
+
+    void process(juce::AudioBuffer<float>& buffer) override
+    {
+        inputCopy.makeCopyOf(buffer, true);
+        convolution.process(inputCopy, buffer);
+    }
+
+private:
+    PartitionedConvolution convolution;
+    juce::AudioBuffer<float> inputCopy;
+};
+
+//==============================================================================
+/**
+ * One render thread and the processor it drives
+ */
+class OfflineRenderer::Worker : public juce::Thread
+{
+public:
+    Worker(OfflineRenderer& ownerToUse, std::unique_ptr<Processor> processorToUse, const Job& jobToUse)
+        : juce::Thread("Offline Render"),
+          owner(ownerToUse),
+          processor(std::move(processorToUse)),
+          job(jobToUse)
+    {
+        job.items.clear();
+        formatManager.registerBasicFormats();
+
+        processor->prepare(job.sampleRate, job.blockSize);
+
+        processBuffer.setSize(processor->getNumChannels(), job.blockSize);
+        readBuffer.setSize(outputChannels, job.blockSize);
+    }
+
+    ~Worker() override
+    {
+        stopThread(4000);
+        processor->release();
+    }
+
+    void run() override
+    {
+        Item item;
+
+        while (!threadShouldExit() && owner.popNextItem(item))
+        {
+            const double startTime = juce::Time::getMillisecondCounterHiRes();
+            Result result = renderItem(item);
+            result.renderSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+            if (!threadShouldExit())
+                owner.postResult(result);
+        }
+    }
+
+private:
+    Result renderItem(const Item& item)
+    {
+        Result result;
+        result.sessionId = job.sessionId;
+        result.fileIndex = item.fileIndex;
+        result.outputFile = item.outputFile;
+
+        // Sources at another rate are converted to the render rate first (or taken from the cache)
+        std::unique_ptr<juce::AudioFormatReader> reader(sourceCache.createReaderFor(item.sourceFile, job.sampleRate,
+                                                                                    job.processing.resampleQuality,
+                                                                                    formatManager, result.errorMessage));
+
+        if (reader == nullptr)
+            return result;
+
+        // Stream layout: [pre-roll silence][source][silence for the tail]
+        // Output layout: [pre-roll + processor latency, skipped and measured for DC][kept audio]
+        const juce::int64 sourceFrames = reader->lengthInSamples;
+        const juce::int64 skipFrames = job.preRollFrames + processor->getLatencySamples();
+
+        CaptureOutput::Format format;
+        format.sampleRate = job.sampleRate;
+        format.outputSampleRate = item.outputSampleRate;
+        format.numChannels = outputChannels;
+        format.skipFrames = skipFrames;
+        format.maxOutputFrames = job.keepTail ? sourceFrames + job.maxTailFrames : sourceFrames;
+
+        CaptureOutput output;
+
+        if (!output.open(item.outputFile, format, job.processing))
+        {
+            result.errorMessage = output.getErrorMessage();
+            return result;
+        }
+
+        juce::int64 streamPosition = 0;
+        int silentBlocks = 0;
+
+        juce::ScopedNoDenormals noDenormals;
+        processor->reset();
+
+        while (!output.isFull())
+        {
+            if (threadShouldExit())
+            {
+                output.abandon();
+                result.errorMessage = "Render cancelled - " + item.outputFile.getFileName();
+                return result;
+            }
+
+            const int numFrames = job.blockSize;
+            processBuffer.clear();
+
+            // 1. Source frames falling in this block (mono files feed both channels)
+            const juce::int64 sourceOffset = streamPosition - job.preRollFrames;
+
+            if (sourceOffset + numFrames > 0 && sourceOffset < sourceFrames)
+            {
+                const int destinationStart = (int)juce::jmax((juce::int64)0, -sourceOffset);
+                const juce::int64 readStart = juce::jmax((juce::int64)0, sourceOffset);
+                const int numToRead = (int)juce::jmin((juce::int64)(numFrames - destinationStart), sourceFrames - readStart);
+
+                reader->read(&readBuffer, 0, numToRead, readStart, true, true);
+
+                for (int ch = 0; ch < processor->getNumInputChannels(); ++ch)
+                    processBuffer.copyFrom(ch, destinationStart, readBuffer, ch % outputChannels, 0, numToRead);
+            }
+
+            // 2. The stand-in for the hardware
+            processor->process(processBuffer);
+
+            // 3. Skip, DC, trim, dither and write
+            if (!output.process(processBuffer.getArrayOfReadPointers(), numFrames))
+            {
+                result.errorMessage = output.getErrorMessage();
+                return result;
+            }
+
+            const int keptStart = (int)juce::jlimit((juce::int64)0, (juce::int64)numFrames, skipFrames - streamPosition);
+            streamPosition += numFrames;
+
+            // Reverb mode: stop once the tail after the source has decayed
+            if (job.keepTail && streamPosition - skipFrames > sourceFrames && keptStart < numFrames)
+            {
+                const int numKept = numFrames - keptStart;
+                double sumOfSquares = 0.0;
+                for (int ch = 0; ch < outputChannels; ++ch)
+                    sumOfSquares = juce::jmax(sumOfSquares, AudioAnalysis::analyseChannel(processBuffer.getReadPointer(ch, keptStart), numKept).sumOfSquares);
+
+                const float rms = (float)std::sqrt(sumOfSquares / numKept);
+
+                if (juce::Decibels::gainToDecibels(rms, -200.0f) < job.tailThresholdDb)
+                {
+                    if (++silentBlocks >= requiredSilentBlocks)
+                        break;
+                }
+                else
+                {
+                    silentBlocks = 0;
+                }
+            }
+        }
+
+        if (!output.finish())
+        {
+            result.errorMessage = output.getErrorMessage();
+            return result;
+        }
+
+        result.framesWritten = output.getFramesWritten();
+        result.dcOffsetSkipped = output.isDCOffsetSkipped();
+        result.succeeded = true;
+        return result;
+    }
+
+    OfflineRenderer& owner;
+    std::unique_ptr<Processor> processor;
+    Job job;  // Settings only - items come from the owner's queue
+
+    juce::AudioFormatManager formatManager;
+    ConvertedSourceCache sourceCache;
+    juce::AudioBuffer<float> processBuffer, readBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Worker)
+};
+
+//==============================================================================
+OfflineRenderer::OfflineRenderer()
+{
+    pluginFormatManager.addDefaultFormats();
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+    cancel();
+}
+
+juce::String OfflineRenderer::startPluginRender(const juce::String& pluginFileOrIdentifier, const Job& job)
+{
+    cancel();
+
+    // Find the plugin in whichever format recognises the path or URI
+    juce::OwnedArray<juce::PluginDescription> descriptions;
+
+    for (auto* format : pluginFormatManager.getFormats())
+    {
+        if (format->fileMightContainThisPluginType(pluginFileOrIdentifier))
+            format->findAllTypesForFile(descriptions, pluginFileOrIdentifier);
+
+        if (!descriptions.isEmpty())
+            break;
+    }
+
+    if (descriptions.isEmpty())
+        return "No VST3 or LV2 plugin found in - " + pluginFileOrIdentifier;
+
+    const juce::PluginDescription& description = *descriptions.getFirst();
+    const int numWorkers = getNumWorkersFor(job);
+
+    // Instances are created here rather than on the workers - some plugins insist on the message thread
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        juce::String errorMessage;
+        auto instance = pluginFormatManager.createPluginInstance(description, job.sampleRate, job.blockSize, errorMessage);
+
+        if (instance == nullptr)
+        {
+            workers.clear();
+            return "Could not load plugin " + description.name + " - " + errorMessage;
+        }
+
+        workers.add(new Worker(*this, std::make_unique<PluginProcessor>(std::move(instance)), job));
+    }
+
+    startWorkers(job, description.name);
+    return {};
+}
+
+juce::String OfflineRenderer::startConvolutionRender(const juce::AudioBuffer<float>& impulseResponses, const Job& job)
+{
+    cancel();
+
+    if (impulseResponses.getNumChannels() < 4 || impulseResponses.getNumSamples() == 0)
+        return "No impulse response captured";
+
+    if (!juce::isPowerOfTwo(job.blockSize))
+        return "Convolution block size must be a power of two";
+
+    // Transformed once, shared read-only by every worker
+    auto kernel = std::make_shared<const PartitionedConvolution::Kernel>(impulseResponses, 2, 2, job.blockSize);
+
+    for (int i = getNumWorkersFor(job); --i >= 0;)
+        workers.add(new Worker(*this, std::make_unique<ConvolutionProcessor>(kernel), job));
+
+    startWorkers(job, "impulse response");
+    return {};
+}
+
+int OfflineRenderer::getNumWorkersFor(const Job& job)
+{
+    return juce::jlimit(1, juce::jmax(1, job.items.size()),
+                        job.numWorkers > 0 ? job.numWorkers : juce::SystemStats::getNumPhysicalCpus());
+}
+
+void OfflineRenderer::startWorkers(const Job& job, const juce::String& nameOfProcessor)
+{
+    processorName = nameOfProcessor;
+
+    {
+        const juce::ScopedLock sl(lock);
+        pendingItems = job.items;
+    }
+
+    for (auto* worker : workers)
+        worker->startThread();
+}
+
+void OfflineRenderer::cancel()
+{
+    {
+        const juce::ScopedLock sl(lock);
+        pendingItems.clear();
+    }
+
+    // Deleting a worker stops its thread and releases its processor
+    workers.clear();
+
+    {
+        const juce::ScopedLock sl(lock);
+        finishedResults.clear();
+    }
+
+    cancelPendingUpdate();
+}
+
+bool OfflineRenderer::popNextItem(Item& item)
+{
+    const juce::ScopedLock sl(lock);
+
+    if (pendingItems.isEmpty())
+        return false;
+
+    item = pendingItems.removeAndReturn(0);
+    return true;
+}
+
+void OfflineRenderer::postResult(const Result& result)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        finishedResults.add(result);
+    }
+
+    triggerAsyncUpdate();
+}
+
+void OfflineRenderer::handleAsyncUpdate()
+{
+    juce::Array<Result> results;
+
+    {
+        const juce::ScopedLock sl(lock);
+        results.swapWith(finishedResults);
+    }
+
+    for (const auto& result : results)
+    {
+        if (onFileRendered)
+            onFileRendered(result);
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PartitionedConvolution.h"
+#include "CaptureOutput.h"
+#include "ConvertedSourceCache.h"
+
+//==============================================================================
+/**
+ * Offline batch renderer - a software stand-in for the hardware chain
+ *
+ * Renders batch files without the audio device, as fast as the CPU allows,
+ * through one of:
+ * - a hosted VST3 or LV2 plugin (startPluginRender)
+ * - the measured impulse response of the hardware chain (startConvolutionRender)
+ *
+ * Each worker thread owns its own processor (plugin instance or convolution
+ * state) and pulls the next file from a shared queue, so a batch spreads
+ * across all cores. The output is repeatable, which makes it usable as a
+ * regression target.
+ *
+ * Each file goes through the same chain as a hardware capture. First a
+ * pre-roll of silence is sent, then the source. The processor latency and the
+ * pre-roll are skipped on the way out, and the mean of that skipped region is
+ * removed as DC. The rest of the output path is the same CaptureOutput stage
+ * CaptureWriter uses. Sources at another rate are converted to the job's rate
+ * by the worker that renders them (see ConvertedSourceCache).
+ *
+ * Threading:
+ * - start / cancel / results: message thread (plugins are created, prepared
+ *   and released here)
+ * - Rendering: one worker thread per processor
+ */
+class OfflineRenderer : private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    struct Item
+    {
+        int fileIndex = -1;  // Index into AppState::files
+        juce::File sourceFile;
+        juce::File outputFile;
+        double outputSampleRate = 0.0;  // Rate written to the output file, 0 = the job's rate
+    };
+
+    struct Job
+    {
+        double sampleRate = 44100.0;
+        int blockSize = 512;                  // Power of two for convolution renders
+        int numWorkers = 0;                   // 0 = one per physical core
+        juce::int64 preRollFrames = 0;        // Silence sent before each file, measured for DC
+        CaptureOutput::Processing processing;
+        bool keepTail = false;                // Reverb mode: render past the source until the tail decays
+        juce::int64 maxTailFrames = 0;        // Safety limit after the source in reverb mode
+        float tailThresholdDb = -80.0f;
+        int sessionId = -1;                   // The owner's batch, echoed in each Result
+        juce::Array<Item> items;
+    };
+
+    /** Outcome of one file, reported on the message thread */
+    struct Result
+    {
+        int sessionId = -1;
+        int fileIndex = -1;
+        juce::File outputFile;
+        bool succeeded = false;
+        juce::int64 framesWritten = 0;
+        bool dcOffsetSkipped = false;  // DC removal had no latency region to measure in (see CaptureOutput)
+        double renderSeconds = 0.0;
+        juce::String errorMessage;
+    };
+
+    //==============================================================================
+    OfflineRenderer();
+    ~OfflineRenderer() override;
+
+    /**
+     * Creates one plugin instance per worker and starts rendering the job's items
+     * @param pluginFileOrIdentifier VST3 bundle path or LV2 URI
+     * @return An error message, or an empty string once the workers are running
+     */
+    juce::String startPluginRender(const juce::String& pluginFileOrIdentifier, const Job& job);
+
+    /**
+     * Starts rendering the job's items through a stereo impulse response matrix
+     * @param impulseResponses 4 channels: L->L, L->R, R->L, R->R, already aligned (no latency)
+     * @return An error message, or an empty string once the workers are running
+     */
+    juce::String startConvolutionRender(const juce::AudioBuffer<float>& impulseResponses, const Job& job);
+
+    /** Stops the workers, deleting half-rendered files; no further results are reported */
+    void cancel();
+
+    /** What the last successful start renders through (plugin name or "impulse response") */
+    juce::String getProcessorName() const { return processorName; }
+
+    /** Number of worker threads started by the last successful start */
+    int getNumWorkers() const { return workers.size(); }
+
+    /** Called on the message thread for every rendered (or failed) file */
+    std::function<void(const Result&)> onFileRendered;
+
+private:
+    //==============================================================================
+    class Processor;
+    class PluginProcessor;
+    class ConvolutionProcessor;
+    class Worker;
+
+    /** Number of workers for a job: the requested count, capped by the number of files */
+    static int getNumWorkersFor(const Job& job);
+
+    /** Queues the items and starts the workers already added to `workers` */
+    void startWorkers(const Job& job, const juce::String& nameOfProcessor);
+
+    /** Takes the next file off the queue (worker threads), false when it is empty */
+    bool popNextItem(Item& item);
+
+    void postResult(const Result& result);
+    void handleAsyncUpdate() override;
+
+    juce::AudioPluginFormatManager pluginFormatManager;
+    juce::OwnedArray<Worker> workers;
+    juce::String processorName;
+
+    // Shared with the workers
+    juce::CriticalSection lock;
+    juce::Array<Item> pendingItems;
+    juce::Array<Result> finishedResults;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OfflineRenderer)
+};
@@ -0,0 +1,156 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "PartitionedConvolution.h"
+
+//==============================================================================
+PartitionedConvolution::Kernel::Kernel(const juce::AudioBuffer<float>& impulseResponses,
+                                       int numInputsToUse, int numOutputsToUse, int blockSizeToUse)
+    : blockSize(juce::nextPowerOfTwo(juce::jmax(16, blockSizeToUse))),
+      numInputs(juce::jmax(1, numInputsToUse)),
+      numOutputs(juce::jmax(1, numOutputsToUse))
+{
+    jassert(blockSize == blockSizeToUse);  // Partition size must be a power of two
+    jassert(impulseResponses.getNumChannels() >= numInputs * numOutputs);
+
+    fftOrder = juce::roundToInt(std::log2((double)blockSize)) + 1;
+    numBins = blockSize + 1;
+    numPartitions = juce::jmax(1, (impulseResponses.getNumSamples() + blockSize - 1) / blockSize);
+
+    const int numPaths = numInputs * numOutputs;
+    real.assign((size_t)numPaths * (size_t)numPartitions * (size_t)numBins, 0.0f);
+    imag.assign(real.size(), 0.0f);
+
+    juce::dsp::FFT kernelFFT(fftOrder);
+    std::vector<float> buffer((size_t)(4 * blockSize));
+
+    for (int path = 0; path < numPaths; ++path)
+    {
+        // Paths without an impulse response stay silent
+        if (path >= impulseResponses.getNumChannels())
+            continue;
+
+        const float* ir = impulseResponses.getReadPointer(path);
+
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            // Partition p, zero-padded to the FFT size
+            std::fill(buffer.begin(), buffer.end(), 0.0f);
+            const int start = p * blockSize;
+            const int length = juce::jmin(blockSize, impulseResponses.getNumSamples() - start);
+            std::copy(ir + start, ir + start + length, buffer.begin());
+
+            kernelFFT.performRealOnlyForwardTransform(buffer.data(), true);
+
+            float* re = real.data() + getOffset(path, p);
+            float* im = imag.data() + getOffset(path, p);
+            for (int bin = 0; bin < numBins; ++bin)
+            {
+                re[bin] = buffer[(size_t)(2 * bin)];
+                im[bin] = buffer[(size_t)(2 * bin + 1)];
+            }
+        }
+    }
+}
+
+//==============================================================================
+PartitionedConvolution::PartitionedConvolution(std::shared_ptr<const Kernel> kernelToUse)
+    : kernel(std::move(kernelToUse)),
+      fft(kernel->fftOrder)
+{
+    const auto& k = *kernel;
+
+    inputHistory.setSize(k.numInputs, 2 * k.blockSize);
+    fftBuffer.assign((size_t)(4 * k.blockSize), 0.0f);
+    delayReal.assign((size_t)k.numInputs * (size_t)k.numPartitions * (size_t)k.numBins, 0.0f);
+    delayImag.assign(delayReal.size(), 0.0f);
+    sumReal.assign((size_t)k.numBins, 0.0f);
+    sumImag.assign((size_t)k.numBins, 0.0f);
+
+    reset();
+}
+
+void PartitionedConvolution::reset()
+{
+    inputHistory.clear();
+    std::fill(delayReal.begin(), delayReal.end(), 0.0f);
+    std::fill(delayImag.begin(), delayImag.end(), 0.0f);
+    delayIndex = 0;
+}
+
+void PartitionedConvolution::process(const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output)
+{
+    const auto& k = *kernel;
+    const int blockSize = k.blockSize;
+    const int numBins = k.numBins;
+
+    jassert(input.getNumSamples() >= blockSize && output.getNumSamples() >= blockSize);
+
+    auto slotOffset = [&k](int inputIndex, int slot)
+    {
+        return ((size_t)inputIndex * (size_t)k.numPartitions + (size_t)slot) * (size_t)k.numBins;
+    };
+
+    // 1. Slide each input's window by one block and transform it into the newest ring slot
+    for (int in = 0; in < k.numInputs; ++in)
+    {
+        float* history = inputHistory.getWritePointer(in);
+        std::copy(history + blockSize, history + 2 * blockSize, history);
+
+        if (in < input.getNumChannels())
+            juce::FloatVectorOperations::copy(history + blockSize, input.getReadPointer(in), blockSize);
+        else
+            juce::FloatVectorOperations::clear(history + blockSize, blockSize);
+
+        std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+        std::copy(history, history + 2 * blockSize, fftBuffer.begin());
+        fft.performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+        float* re = delayReal.data() + slotOffset(in, delayIndex);
+        float* im = delayImag.data() + slotOffset(in, delayIndex);
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            re[bin] = fftBuffer[(size_t)(2 * bin)];
+            im[bin] = fftBuffer[(size_t)(2 * bin + 1)];
+        }
+    }
+
+    // 2. Per output: multiply-accumulate every input's delay line with its partitions
+    for (int out = 0; out < k.numOutputs && out < output.getNumChannels(); ++out)
+    {
+        std::fill(sumReal.begin(), sumReal.end(), 0.0f);
+        std::fill(sumImag.begin(), sumImag.end(), 0.0f);
+
+        for (int in = 0; in < k.numInputs; ++in)
+        {
+            const int path = in * k.numOutputs + out;
+
+            for (int p = 0; p < k.numPartitions; ++p)
+            {
+                // Partition p meets the input spectrum from p blocks ago
+                const int slot = (delayIndex - p + k.numPartitions) % k.numPartitions;
+                const float* xr = delayReal.data() + slotOffset(in, slot);
+                const float* xi = delayImag.data() + slotOffset(in, slot);
+                const float* hr = k.getReal(path, p);
+                const float* hi = k.getImag(path, p);
+
+                // (xr + i xi)(hr + i hi) = (xr hr - xi hi) + i (xr hi + xi hr)
+                juce::FloatVectorOperations::addWithMultiply(sumReal.data(), xr, hr, numBins);
+                juce::FloatVectorOperations::subtractWithMultiply(sumReal.data(), xi, hi, numBins);
+                juce::FloatVectorOperations::addWithMultiply(sumImag.data(), xr, hi, numBins);
+                juce::FloatVectorOperations::addWithMultiply(sumImag.data(), xi, hr, numBins);
+            }
+        }
+
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            fftBuffer[(size_t)(2 * bin)] = sumReal[(size_t)bin];
+            fftBuffer[(size_t)(2 * bin + 1)] = sumImag[(size_t)bin];
+        }
+
+        fft.performRealOnlyInverseTransform(fftBuffer.data());
+
+        // Overlap-save: the second half of the window is the valid (non-wrapped) output
+        juce::FloatVectorOperations::copy(output.getWritePointer(out), fftBuffer.data() + blockSize, blockSize);
+    }
+
+    delayIndex = (delayIndex + 1) % k.numPartitions;
+}
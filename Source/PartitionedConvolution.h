@@ -0,0 +1,86 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * Uniformly partitioned FFT convolution (overlap-save, frequency-domain delay line)
+ *
+ * Convolves N inputs with an N x M matrix of impulse responses, so a stereo
+ * chain with crosstalk (L->L, L->R, R->L, R->R) renders in one pass. Each input
+ * block is transformed once, then every path is accumulated with
+ * FloatVectorOperations on split real/imaginary spectra, which keeps the inner
+ * loop vectorised.
+ *
+ * The Kernel holds the transformed impulse responses. It is immutable once
+ * built, so render threads share one Kernel and each keeps its own
+ * PartitionedConvolution state. Latency is zero: the output of block n
+ * includes the contribution of input block n.
+ */
+class PartitionedConvolution
+{
+public:
+    //==============================================================================
+    class Kernel
+    {
+    public:
+        /**
+         * @param impulseResponses One channel per path, path = input * numOutputs + output
+         * @param blockSize Frames per process() call (the partition size)
+         */
+        Kernel(const juce::AudioBuffer<float>& impulseResponses, int numInputs, int numOutputs, int blockSize);
+
+        int getBlockSize() const noexcept     { return blockSize; }
+        int getNumInputs() const noexcept     { return numInputs; }
+        int getNumOutputs() const noexcept    { return numOutputs; }
+        int getNumPartitions() const noexcept { return numPartitions; }
+
+    private:
+        friend class PartitionedConvolution;
+
+        const float* getReal(int path, int partition) const noexcept { return real.data() + getOffset(path, partition); }
+        const float* getImag(int path, int partition) const noexcept { return imag.data() + getOffset(path, partition); }
+        size_t getOffset(int path, int partition) const noexcept
+        {
+            return ((size_t)path * (size_t)numPartitions + (size_t)partition) * (size_t)numBins;
+        }
+
+        int blockSize = 0;
+        int fftOrder = 0;
+        int numInputs = 0;
+        int numOutputs = 0;
+        int numPartitions = 0;
+        int numBins = 0;                 // blockSize + 1 (DC to Nyquist of a 2 * blockSize FFT)
+        std::vector<float> real, imag;   // Split spectra, [path][partition][bin]
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Kernel)
+    };
+
+    //==============================================================================
+    explicit PartitionedConvolution(std::shared_ptr<const Kernel> kernelToUse);
+
+    /** Clears the input history, as if silence had been playing forever */
+    void reset();
+
+    /**
+     * Convolves exactly one block
+     * @param input At least getNumInputs() channels of getBlockSize() frames
+     * @param output At least getNumOutputs() channels, overwritten (may not alias input)
+     */
+    void process(const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output);
+
+    const Kernel& getKernel() const noexcept { return *kernel; }
+
+private:
+    //==============================================================================
+    std::shared_ptr<const Kernel> kernel;
+    juce::dsp::FFT fft;
+
+    juce::AudioBuffer<float> inputHistory;   // Per input: previous block + current block
+    std::vector<float> fftBuffer;            // 2 * fftSize, interleaved complex in place
+    std::vector<float> delayReal, delayImag; // Input spectra, [input][partition][bin] ring
+    std::vector<float> sumReal, sumImag;     // Accumulated output spectrum
+    int delayIndex = 0;                      // Ring slot of the newest input spectrum
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartitionedConvolution)
+};
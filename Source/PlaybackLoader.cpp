@@ -0,0 +1,189 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "PlaybackLoader.h"
+#include "AudioAnalysis.h"
+
+//==============================================================================
+PlaybackLoader::PlaybackLoader()
+    : juce::Thread("Playback Loader")
+{
+    formatManager.registerBasicFormats();
+    startThread();
+}
+
+PlaybackLoader::~PlaybackLoader()
+{
+    stopThread(2000);
+    cancelPendingUpdate();
+}
+
+void PlaybackLoader::setConversion(double sampleRate, SampleRateConverter::Quality quality)
+{
+    const juce::ScopedLock sl(lock);
+    targetSampleRate = sampleRate;
+    resampleQuality = quality;
+}
+
+void PlaybackLoader::requestLoad(Purpose purpose, int index, const juce::File& file)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        pendingRequests.add({ purpose, index, file });
+    }
+
+    notify();
+}
+
+void PlaybackLoader::releaseBuffer(juce::AudioBuffer<float>* buffer)
+{
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (auto* slot = findSlotFor(buffer))
+            slot->isFree = true;
+    }
+
+    notify();
+}
+
+void PlaybackLoader::cancelPendingLoads()
+{
+    const juce::ScopedLock sl(lock);
+
+    ++generation;
+    pendingRequests.clear();
+
+    // Results not yet delivered never reached the engine, so their buffers can be reused now
+    for (const auto& result : finishedResults)
+    {
+        if (auto* slot = findSlotFor(result.buffer))
+            slot->isFree = true;
+    }
+
+    finishedResults.clear();
+}
+
+//==============================================================================
+void PlaybackLoader::run()
+{
+    while (!threadShouldExit())
+    {
+        Request request;
+        Slot* slot = nullptr;
+        int requestGeneration = 0;
+        double sampleRate = 0.0;
+        auto quality = SampleRateConverter::Quality::standard;
+
+        {
+            const juce::ScopedLock sl(lock);
+
+            if (!pendingRequests.isEmpty())
+            {
+                slot = findFreeSlot();
+
+                if (slot != nullptr)
+                {
+                    slot->isFree = false;
+                    request = pendingRequests.removeAndReturn(0);
+                    requestGeneration = generation;
+                    sampleRate = targetSampleRate;
+                    quality = resampleQuality;
+                }
+            }
+        }
+
+        if (slot == nullptr)
+        {
+            wait(50);
+            continue;
+        }
+
+        // Decode outside the lock - the slot is reserved for us
+        Result result;
+        result.request = request;
+
+        std::unique_ptr<juce::AudioFormatReader> reader(sourceCache.createReaderFor(request.file, sampleRate, quality, formatManager,
+                                                                                    result.errorMessage, &result.converted));
+
+        if (reader != nullptr)
+        {
+            const int numFrames = (int)reader->lengthInSamples;
+
+            // Stereo playback buffer - mono files are copied to both L/R channels by read()
+            slot->buffer.setSize(2, numFrames, false, false, true);
+            slot->buffer.clear();
+            result.succeeded = reader->read(&slot->buffer, 0, numFrames, 0, true, true);
+        }
+
+        if (result.succeeded)
+        {
+            result.buffer = &slot->buffer;
+        }
+        else if (result.errorMessage.isEmpty())
+        {
+            result.errorMessage = "Could not read file - " + request.file.getFileName();
+        }
+
+        // The index describes the source - a conversion's content doesn't belong in it
+        if (result.succeeded && !result.converted)
+        {
+            const auto stats = AudioAnalysis::analyse(slot->buffer);
+            result.peak = stats.peak;
+            result.rms = stats.getRMS();
+            result.contentHash = AudioAnalysis::hashContent(slot->buffer);
+        }
+
+        {
+            const juce::ScopedLock sl(lock);
+
+            if (!result.succeeded || requestGeneration != generation)
+                slot->isFree = true;
+
+            if (requestGeneration != generation)
+                continue;
+
+            finishedResults.add(result);
+        }
+
+        triggerAsyncUpdate();
+    }
+}
+
+void PlaybackLoader::handleAsyncUpdate()
+{
+    juce::Array<Result> results;
+
+    {
+        const juce::ScopedLock sl(lock);
+        results.swapWith(finishedResults);
+    }
+
+    for (const auto& result : results)
+    {
+        if (onFileLoaded)
+            onFileLoaded(result);
+        else if (result.buffer != nullptr)
+            releaseBuffer(result.buffer);
+    }
+}
+
+PlaybackLoader::Slot* PlaybackLoader::findFreeSlot()
+{
+    for (auto& slot : slots)
+    {
+        if (slot.isFree)
+            return &slot;
+    }
+
+    return nullptr;
+}
+
+PlaybackLoader::Slot* PlaybackLoader::findSlotFor(const juce::AudioBuffer<float>* buffer)
+{
+    for (auto& slot : slots)
+    {
+        if (&slot.buffer == buffer)
+            return &slot;
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ConvertedSourceCache.h"
+
+//==============================================================================
+/**
+ * Double-buffered background file loader
+ *
+ * Decodes upcoming batch/preview files into one of two playback buffers on its
+ * own thread, so file N+1 is ready in memory while file N is still being sent.
+ * The audio thread switches buffers at the file boundary by taking the pointer
+ * from the next EngineCommand - nothing is decoded or allocated on the message
+ * thread or the audio thread.
+ *
+ * Files at another rate than the device are converted to it here as well
+ * (see setConversion() and ConvertedSourceCache), so the engine only ever
+ * sees audio at the device rate.
+ *
+ * A buffer handed out in a Result belongs to the caller (and then the audio
+ * engine) until releaseBuffer() is called; only then is it reused for a later
+ * file. Requests are queued and served in order as buffers become free.
+ */
+class PlaybackLoader : private juce::Thread,
+                       private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    enum class Purpose
+    {
+        processing,  // index = index into AppState::files
+        preview      // index = index into AppState::previewPlaylist
+    };
+
+    struct Request
+    {
+        Purpose purpose = Purpose::processing;
+        int index = -1;
+        juce::File file;
+    };
+
+    /** Reported on the message thread when a request has been decoded (or failed) */
+    struct Result
+    {
+        Request request;
+        juce::AudioBuffer<float>* buffer = nullptr;  // Stereo, exactly the (converted) file length
+        bool succeeded = false;
+        bool converted = false;                      // Resampled to the device rate on the way in
+        juce::String errorMessage;
+
+        // Measured while the decoded file is still hot in the cache, for the metadata index (unconverted files only)
+        float peak = 0.0f;
+        float rms = 0.0f;
+        juce::uint64 contentHash = 0;
+    };
+
+    //==============================================================================
+    PlaybackLoader();
+    ~PlaybackLoader() override;
+
+    /** Sets the rate files are converted to on load, and how well - applies to requests not yet started */
+    void setConversion(double sampleRate, SampleRateConverter::Quality quality);
+
+    /** Queues a file for decoding */
+    void requestLoad(Purpose purpose, int index, const juce::File& file);
+
+    /** Returns a buffer once the audio thread has stopped reading it */
+    void releaseBuffer(juce::AudioBuffer<float>* buffer);
+
+    /** Drops queued requests and undelivered results (buffers held by the caller are unaffected) */
+    void cancelPendingLoads();
+
+    /** Called on the message thread for every completed request */
+    std::function<void(const Result&)> onFileLoaded;
+
+private:
+    //==============================================================================
+    static constexpr int numSlots = 2;
+
+    struct Slot
+    {
+        juce::AudioBuffer<float> buffer;
+        bool isFree = true;
+    };
+
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    Slot* findFreeSlot();
+    Slot* findSlotFor(const juce::AudioBuffer<float>* buffer);
+
+    juce::AudioFormatManager formatManager;
+    ConvertedSourceCache sourceCache;
+
+    juce::CriticalSection lock;
+    double targetSampleRate = 44100.0;
+    SampleRateConverter::Quality resampleQuality = SampleRateConverter::Quality::standard;
+    Slot slots[numSlots];
+    juce::Array<Request> pendingRequests;
+    juce::Array<Result> finishedResults;
+    int generation = 0;  // Bumped by cancelPendingLoads() to discard in-flight decodes
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PlaybackLoader)
+};
@@ -0,0 +1,275 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "RouteCalibration.h"
+#include "LatencyMeasurement.h"
+
+namespace
+{
+constexpr float sendLevel = 0.1f;         // -20 dBFS on every output
+constexpr double slotSeconds = 0.4;       // Per output pair - routes up to a few ms shorter than this are found
+
+// Frames either side of a correlation peak left out of the noise - band-limited chains smear the peak
+constexpr int peakExclusionFrames = 64;
+}
+
+//==============================================================================
+RouteCalibration::RouteCalibration()
+    : juce::Thread("Route Calibration")
+{
+    startThread();
+}
+
+RouteCalibration::~RouteCalibration()
+{
+    stopThread(4000);
+    cancelPendingUpdate();
+}
+
+bool RouteCalibration::prepare(double sampleRate, int numOutputPairsToUse, int numInputs)
+{
+    numOutputPairs = juce::jmax(1, numOutputPairsToUse);
+    slotFrames = (int)(slotSeconds * sampleRate);
+
+    // Shortest sequence with a slot per output pair
+    const juce::int64 framesNeeded = (juce::int64)numOutputPairs * slotFrames;
+    int order = LatencyMeasurement::minSequenceOrder;
+
+    while (order < LatencyMeasurement::maxSequenceOrder && (1 << order) - 1 < framesNeeded)
+        ++order;
+
+    if ((1 << order) - 1 < framesNeeded)
+        return false;
+
+    const int sequenceFrames = (1 << order) - 1;
+    sequence.setSize(1, sequenceFrames);
+    LatencyMeasurement::generateSequence(order, sendLevel, sequence.getWritePointer(0));
+
+    capture.setSize(juce::jmax(1, numInputs), sequenceFrames);
+    capture.clear();
+    return true;
+}
+
+void RouteCalibration::analyseCapture()
+{
+    {
+        const juce::ScopedLock sl(lock);
+
+        // The capture is large - it is handed over rather than copied
+        std::swap(pendingCapture, capture);
+        pendingSequence.makeCopyOf(sequence);
+        pendingSlotFrames = slotFrames;
+        pendingOutputPairs = numOutputPairs;
+        hasPendingCapture = true;
+    }
+
+    capture.setSize(0, 0);
+    notify();
+}
+
+void RouteCalibration::cancel()
+{
+    const juce::ScopedLock sl(lock);
+
+    ++generation;
+    hasPendingCapture = false;
+    pendingCapture.setSize(0, 0);
+    finishedResults.clear();
+}
+
+//==============================================================================
+void RouteCalibration::run()
+{
+    while (!threadShouldExit())
+    {
+        juce::AudioBuffer<float> captured, sequenceToMatch;
+        int slot = 0, numPairs = 0;
+        int analysisGeneration = 0;
+
+        {
+            const juce::ScopedLock sl(lock);
+
+            if (hasPendingCapture)
+            {
+                std::swap(captured, pendingCapture);
+                std::swap(sequenceToMatch, pendingSequence);
+                slot = pendingSlotFrames;
+                numPairs = pendingOutputPairs;
+                analysisGeneration = generation;
+                hasPendingCapture = false;
+            }
+        }
+
+        if (sequenceToMatch.getNumSamples() == 0)
+        {
+            wait(-1);
+            continue;
+        }
+
+        const Result result = analyse(captured, sequenceToMatch, slot, numPairs);
+
+        {
+            const juce::ScopedLock sl(lock);
+
+            if (analysisGeneration != generation)
+                continue;
+
+            finishedResults.add(result);
+        }
+
+        triggerAsyncUpdate();
+    }
+}
+
+void RouteCalibration::handleAsyncUpdate()
+{
+    juce::Array<Result> results;
+
+    {
+        const juce::ScopedLock sl(lock);
+        results.swapWith(finishedResults);
+    }
+
+    for (const auto& result : results)
+        if (onAnalysed)
+            onAnalysed(result);
+}
+
+RouteCalibration::Result RouteCalibration::analyse(const juce::AudioBuffer<float>& captured, const juce::AudioBuffer<float>& sequence,
+                                                   int slotFrames, int numOutputPairs)
+{
+    using Complex = juce::dsp::Complex<float>;
+
+    Result result;
+    const int sequenceFrames = sequence.getNumSamples();
+    const int numInputs = captured.getNumChannels();
+    result.numOutputPairs = numOutputPairs;
+    result.numInputs = numInputs;
+
+    if (numInputs == 0 || sequenceFrames == 0 || captured.getNumSamples() < sequenceFrames || slotFrames <= 0)
+        return result;
+
+    result.returnPeak = captured.getMagnitude(0, sequenceFrames);
+
+    // Periodic correlation: the captured period repeated twice against one period of the sequence,
+    // in a transform long enough that neither wraps into the lags read
+    const int fftSize = juce::nextPowerOfTwo(2 * sequenceFrames);
+    juce::dsp::FFT fft(juce::roundToInt(std::log2((double)fftSize)));
+
+    std::vector<Complex> sequenceSpectrum((size_t)fftSize), timeDomain((size_t)fftSize), spectrum((size_t)fftSize);
+
+    const float* code = sequence.getReadPointer(0);
+    double sequenceEnergy = 0.0;
+
+    for (int i = 0; i < fftSize; ++i)
+    {
+        const float value = i < sequenceFrames ? code[i] : 0.0f;
+        sequenceEnergy += (double)value * value;
+        timeDomain[(size_t)i] = { value, 0.0f };
+    }
+
+    fft.perform(timeDomain.data(), sequenceSpectrum.data(), false);
+
+    // Two inputs per transform, in the real and imaginary parts
+    for (int first = 0; first < numInputs; first += 2)
+    {
+        const float* left = captured.getReadPointer(first);
+        const float* right = first + 1 < numInputs ? captured.getReadPointer(first + 1) : nullptr;
+
+        for (int i = 0; i < fftSize; ++i)
+        {
+            const int frame = i < 2 * sequenceFrames ? i % sequenceFrames : -1;
+            timeDomain[(size_t)i] = frame < 0 ? Complex() : Complex(left[frame], right != nullptr ? right[frame] : 0.0f);
+        }
+
+        fft.perform(timeDomain.data(), spectrum.data(), false);
+
+        for (int i = 0; i < fftSize; ++i)
+            spectrum[(size_t)i] *= std::conj(sequenceSpectrum[(size_t)i]);
+
+        fft.perform(spectrum.data(), timeDomain.data(), true);
+
+        for (int input = first; input < juce::jmin(first + 2, numInputs); ++input)
+        {
+            const bool imaginary = input != first;
+
+            // The correlation repeats every period
+            auto correlationAt = [&timeDomain, imaginary, sequenceFrames](int lag)
+            {
+                const Complex value = timeDomain[(size_t)(((lag % sequenceFrames) + sequenceFrames) % sequenceFrames)];
+                return imaginary ? value.imag() : value.real();
+            };
+
+            // Largest magnitude in each output pair's slot, searched from a little before it so a route with
+            // almost no latency keeps the whole of its peak. Judged against the rest of the slot, like
+            // LatencyMeasurement: a reverberant route's tail spilling into the next slot raises that slot's floor too
+            juce::Array<int> peakLags;
+            juce::Array<float> peaks, sidelobeLevels;
+
+            for (int pair = 0; pair < numOutputPairs; ++pair)
+            {
+                const int windowStart = pair * slotFrames - peakExclusionFrames;
+                int peakLag = windowStart;
+                float peak = 0.0f;
+
+                for (int lag = windowStart; lag < windowStart + slotFrames; ++lag)
+                {
+                    if (std::abs(correlationAt(lag)) > peak)
+                    {
+                        peak = std::abs(correlationAt(lag));
+                        peakLag = lag;
+                    }
+                }
+
+                double sidelobeSquares = 0.0;
+                int numSidelobes = 0;
+
+                for (int lag = windowStart; lag < windowStart + slotFrames; ++lag)
+                {
+                    if (std::abs(lag - peakLag) > peakExclusionFrames)
+                    {
+                        sidelobeSquares += (double)correlationAt(lag) * correlationAt(lag);
+                        ++numSidelobes;
+                    }
+                }
+
+                peakLags.add(peakLag);
+                peaks.add(peak);
+                sidelobeLevels.add((float)std::sqrt(sidelobeSquares / juce::jmax(1, numSidelobes)));
+            }
+
+            // An MLS's periodic sidelobes are flat at -1/N of the peak, so the quietest slot holds only the input's noise.
+            // White noise of RMS n in the return comes out of the correlation as n * sqrt(sequenceEnergy)
+            float noiseLevel = sidelobeLevels[0];
+            for (auto level : sidelobeLevels)
+                noiseLevel = juce::jmin(noiseLevel, level);
+
+            result.noiseFloorsDb.add(juce::Decibels::gainToDecibels((float)(noiseLevel / std::sqrt(juce::jmax(sequenceEnergy, 1.0e-20))), -120.0f));
+
+            for (int pair = 0; pair < numOutputPairs; ++pair)
+            {
+                const float peak = peaks[pair];
+                const float peakToSidelobeDb = juce::Decibels::gainToDecibels(peak / juce::jmax(sidelobeLevels[pair], peak * 1.0e-6f, 1.0e-20f));
+                const float gainDb = juce::Decibels::gainToDecibels((float)(peak / juce::jmax(sequenceEnergy, 1.0e-20)), -120.0f);
+
+                // A largest value at the edge of the window is the skirt of the neighbouring pair's peak
+                const int windowStart = pair * slotFrames - peakExclusionFrames;
+                const bool atEdge = peakLags[pair] - windowStart < peakExclusionFrames / 2
+                                 || windowStart + slotFrames - peakLags[pair] <= peakExclusionFrames / 2;
+
+                if (atEdge || peakToSidelobeDb < LatencyMeasurement::minimumPeakToSidelobeDb || gainDb < minimumRouteGainDb)
+                    continue;
+
+                Route route;
+                route.outputPair = pair;
+                route.input = input;
+                route.latencyFrames = juce::jmax(0.0, LatencyMeasurement::findFractionalPeak(correlationAt, peakLags[pair]) - pair * slotFrames);
+                route.peakToSidelobeDb = peakToSidelobeDb;
+                route.confidence = LatencyMeasurement::getConfidence(peakToSidelobeDb);
+                route.gainDb = gainDb;
+                result.routes.add(route);
+            }
+        }
+    }
+
+    result.succeeded = true;
+    return result;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * Latency of every send x return route of an interface in one pass
+ *
+ * LatencyMeasurement calibrates the selected pairs only, so a rig of outboard
+ * inserts on a large interface takes a run per route. Here every output pair
+ * sends the same maximum-length sequence at once, each shifted cyclically by
+ * its own slot of the period, while every input is captured. Cyclic shifts
+ * of an MLS are orthogonal under periodic correlation: correlating a return
+ * with the sequence over one period shows one peak per output pair that
+ * reaches it, inside that pair's slot, at the route's latency. The whole
+ * matrix comes out of one capture.
+ *
+ * Each send starts with the last slot of the period (a cyclic prefix), so
+ * every return is already periodic when the analysed period begins. The
+ * period is the shortest sequence with a slot per output pair - about 11 s
+ * for 16 pairs at 48 kHz - and the capture is one period per input, in
+ * memory. Both channels of an output pair send the same code, as in
+ * LatencyMeasurement, so a route is an output pair to one input.
+ *
+ * Threading: prepare() / analyseCapture() / results on the message thread,
+ * the capture is written by the audio thread in between, the correlation
+ * runs on the calibration's own thread.
+ */
+class RouteCalibration : private juce::Thread,
+                         private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    /** One output pair reaching one input */
+    struct Route
+    {
+        int outputPair = -1;           // 0-based: outputs 2n + 1 and 2n + 2
+        int input = -1;                // 0-based
+        double latencyFrames = 0.0;    // To a fraction of a frame
+        float peakToSidelobeDb = 0.0f; // Correlation peak over the RMS of the rest of its slot
+        float confidence = 0.0f;       // 0 - 1, as LatencyMeasurement::Result::confidence
+        float gainDb = 0.0f;           // Send to return
+    };
+
+    /** Reported on the message thread once a capture has been analysed */
+    struct Result
+    {
+        bool succeeded = false;             // False if the capture could not be analysed at all
+        int numOutputPairs = 0;
+        int numInputs = 0;
+        juce::Array<Route> routes;          // Connected routes only
+        juce::Array<float> noiseFloorsDb;   // Per input, from the quietest slot of its correlation
+        float returnPeak = 0.0f;            // Largest captured sample, to spot clipping
+    };
+
+    /** Returns weaker than this are crosstalk between channels, not a connection */
+    static constexpr float minimumRouteGainDb = -60.0f;
+
+    //==============================================================================
+    RouteCalibration();
+    ~RouteCalibration() override;
+
+    /**
+     * Builds the sequence and clears the capture
+     * @return false if no sequence is long enough for a slot per output pair at this rate
+     */
+    bool prepare(double sampleRate, int numOutputPairs, int numInputs);
+
+    /** One channel, one period - the audio thread sends it from getPrefixFrames() before the start, shifted per pair */
+    juce::AudioBuffer<float>& getSequence() noexcept { return sequence; }
+
+    /** One channel per input, written by the audio thread with the period after the prefix */
+    juce::AudioBuffer<float>& getCapture() noexcept { return capture; }
+
+    /** Frames between the codes of consecutive output pairs - routes must be a little shorter */
+    int getSlotFrames() const noexcept { return slotFrames; }
+
+    /** Frames sent before the analysed period: the last slot of the period, so every return is periodic by then */
+    int getPrefixFrames() const noexcept { return slotFrames; }
+
+    /** Hands the completed capture to the calibration's thread (the capture is empty until the next prepare()) */
+    void analyseCapture();
+
+    /** Drops an analysis not yet delivered */
+    void cancel();
+
+    /** Called on the message thread with each analysed capture */
+    std::function<void(const Result&)> onAnalysed;
+
+private:
+    //==============================================================================
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    static Result analyse(const juce::AudioBuffer<float>& captured, const juce::AudioBuffer<float>& sequence,
+                          int slotFrames, int numOutputPairs);
+
+    int numOutputPairs = 0;
+    int slotFrames = 0;
+    juce::AudioBuffer<float> sequence, capture;
+
+    juce::CriticalSection lock;
+    juce::AudioBuffer<float> pendingCapture, pendingSequence;  // Handed over by analyseCapture()
+    int pendingSlotFrames = 0;
+    int pendingOutputPairs = 0;
+    bool hasPendingCapture = false;
+    int generation = 0;  // Bumped by cancel() to discard a running analysis
+    juce::Array<Result> finishedResults;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RouteCalibration)
+};
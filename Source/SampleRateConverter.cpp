@@ -0,0 +1,278 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "SampleRateConverter.h"
+#include <numeric>
+
+#if JUCE_USE_SSE_INTRINSICS
+ #include <emmintrin.h>
+#elif JUCE_USE_ARM_NEON
+ #include <arm_neon.h>
+#endif
+
+namespace
+{
+struct Design
+{
+    int tapsPerPhase;    // Input frames each output frame is computed from (before scaling for decimation)
+    double kaiserBeta;   // Stopband attenuation ~ beta / 0.1102 + 8.7 dB
+    double cutoff;       // Fraction of the lower Nyquist frequency
+};
+
+Design getDesign(SampleRateConverter::Quality quality)
+{
+    switch (quality)
+    {
+        case SampleRateConverter::Quality::fast:     return { 16, 5.0, 0.80 };
+        case SampleRateConverter::Quality::standard: return { 48, 7.5, 0.90 };
+        case SampleRateConverter::Quality::best:     return { 96, 11.0, 0.94 };
+    }
+
+    return { 48, 7.5, 0.90 };
+}
+
+// Zeroth-order modified Bessel function of the first kind, for the Kaiser window
+double besselI0(double x)
+{
+    const double halfX = x * 0.5;
+    double sum = 1.0;
+    double term = 1.0;
+
+    for (int k = 1; k < 64 && term > sum * 1.0e-12; ++k)
+    {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+    }
+
+    return sum;
+}
+
+// The whole inner loop: numTaps is a multiple of 4
+inline float dotProduct(const float* a, const float* b, int numTaps) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    __m128 sum = _mm_setzero_ps();
+
+    for (int i = 0; i < numTaps; i += 4)
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, sum);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+   #elif JUCE_USE_ARM_NEON
+    float32x4_t sum = vdupq_n_f32(0.0f);
+
+    for (int i = 0; i < numTaps; i += 4)
+        sum = vmlaq_f32(sum, vld1q_f32(a + i), vld1q_f32(b + i));
+
+    const float32x2_t pairs = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+    return vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+   #else
+    // Four independent sums, which compilers vectorise without reassociating
+    float sums[4] = {};
+
+    for (int i = 0; i < numTaps; i += 4)
+        for (int lane = 0; lane < 4; ++lane)
+            sums[lane] += a[i + lane] * b[i + lane];
+
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+   #endif
+}
+}
+
+//==============================================================================
+SampleRateConverter::SampleRateConverter(double sourceRate, double targetRate, int numChannelsToUse, Quality quality)
+    : numChannels(juce::jmax(1, numChannelsToUse))
+{
+    // Rates are whole numbers of Hz in practice; the ratio is reduced so 44.1 -> 48 kHz needs 160 phases, not 48000
+    const auto source = (juce::int64)juce::jmax(1, juce::roundToInt(sourceRate));
+    const auto target = (juce::int64)juce::jmax(1, juce::roundToInt(targetRate));
+    const juce::int64 divisor = std::gcd(source, target);
+
+    upFactor = target / divisor;
+    downFactor = source / divisor;
+
+    buildKernel(quality);
+    reset();
+}
+
+SampleRateConverter::~SampleRateConverter()
+{
+}
+
+bool SampleRateConverter::isNeeded(double sourceRate, double targetRate) noexcept
+{
+    return sourceRate > 0.0 && targetRate > 0.0 && juce::roundToInt(sourceRate) != juce::roundToInt(targetRate);
+}
+
+juce::int64 SampleRateConverter::getOutputLength(juce::int64 numInputFrames) const noexcept
+{
+    return (numInputFrames * upFactor + downFactor - 1) / downFactor;
+}
+
+void SampleRateConverter::buildKernel(Quality quality)
+{
+    const Design design = getDesign(quality);
+    jassert(design.tapsPerPhase % 4 == 0);
+
+    // The design's lengths are in frames at the lower rate: decimating narrows the passband by L / M, so the
+    // prototype grows by M / L to keep the transition band as narrow, relative to the output Nyquist
+    const juce::int64 decimation = (downFactor + upFactor - 1) / upFactor;
+    tapsPerPhase = design.tapsPerPhase * (int)juce::jmax((juce::int64)1, decimation);
+
+    // Prototype at the upsampled rate, centred on an integer frame so the delay is exact
+    const juce::int64 length = (juce::int64)tapsPerPhase * upFactor;
+    delay = length / 2;
+
+    // Cutoff in cycles per input frame - below the lower of the two Nyquist frequencies
+    const double cutoff = 0.5 * design.cutoff * juce::jmin(1.0, (double)upFactor / (double)downFactor);
+    const double windowScale = 1.0 / besselI0(design.kaiserBeta);
+
+    std::vector<double> prototype((size_t)length);
+
+    for (juce::int64 k = 0; k < length; ++k)
+    {
+        const double offset = (double)(k - delay);
+        const double inputTime = offset / (double)upFactor;
+        const double x = 2.0 * cutoff * inputTime;
+        const double sinc = x == 0.0 ? 1.0 : std::sin(juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+
+        const double r = offset / (double)delay;
+        const double window = besselI0(design.kaiserBeta * std::sqrt(juce::jmax(0.0, 1.0 - r * r))) * windowScale;
+
+        prototype[(size_t)k] = 2.0 * cutoff * sinc * window;
+    }
+
+    // Split into phases, each reversed and normalised to unity gain at DC
+    phases.assign((size_t)(upFactor * tapsPerPhase), 0.0f);
+
+    for (juce::int64 phase = 0; phase < upFactor; ++phase)
+    {
+        float* row = phases.data() + phase * tapsPerPhase;
+        double sum = 0.0;
+
+        for (int tap = 0; tap < tapsPerPhase; ++tap)
+            sum += prototype[(size_t)(phase + tap * upFactor)];
+
+        const double scale = sum != 0.0 ? 1.0 / sum : 1.0;
+
+        for (int tap = 0; tap < tapsPerPhase; ++tap)
+            row[tapsPerPhase - 1 - tap] = (float)(prototype[(size_t)(phase + tap * upFactor)] * scale);
+    }
+}
+
+void SampleRateConverter::reset()
+{
+    // A filter's worth of silence before the first frame
+    history.setSize(numChannels, juce::jmax(history.getNumSamples(), tapsPerPhase), false, false, true);
+    history.clear();
+    historyStart = -tapsPerPhase;
+    historyFrames = tapsPerPhase;
+
+    inputFramesPushed = 0;
+    outputFramesProduced = 0;
+    flushed = false;
+}
+
+//==============================================================================
+// Processing
+
+int SampleRateConverter::process(const float* const* input, int numFrames, juce::AudioBuffer<float>& output)
+{
+    jassert(!flushed);
+
+    appendInput(input, numFrames);
+    inputFramesPushed += numFrames;
+
+    // Output frame n needs input up to frame (n * M + delay) / L
+    const juce::int64 inputEnd = historyStart + historyFrames;
+    const juce::int64 available = juce::jmax((juce::int64)0, (inputEnd * upFactor - delay + downFactor - 1) / downFactor);
+
+    return produce(available, output);
+}
+
+int SampleRateConverter::flush(juce::AudioBuffer<float>& output)
+{
+    if (flushed)
+    {
+        output.setSize(numChannels, 0, false, false, true);
+        return 0;
+    }
+
+    flushed = true;
+
+    const juce::int64 outputEnd = getOutputLength(inputFramesPushed);
+
+    if (outputEnd > outputFramesProduced)
+    {
+        // Silence after the end, up to the input the last frame reaches
+        const juce::int64 lastInput = ((outputEnd - 1) * downFactor + delay) / upFactor;
+        const juce::int64 padding = lastInput + 1 - (historyStart + historyFrames);
+
+        if (padding > 0)
+            appendInput(nullptr, (int)padding);
+    }
+
+    return produce(outputEnd, output);
+}
+
+int SampleRateConverter::produce(juce::int64 outputEnd, juce::AudioBuffer<float>& output)
+{
+    const int numOutput = (int)juce::jmax((juce::int64)0, outputEnd - outputFramesProduced);
+    output.setSize(numChannels, numOutput, false, false, true);
+
+    float* const* destination = output.getArrayOfWritePointers();
+    const float* const* source = history.getArrayOfReadPointers();
+
+    for (int i = 0; i < numOutput; ++i)
+    {
+        const juce::int64 position = (outputFramesProduced + i) * downFactor + delay;
+        const float* row = phases.data() + (position % upFactor) * tapsPerPhase;
+        const int first = (int)(position / upFactor - (tapsPerPhase - 1) - historyStart);
+
+        jassert(first >= 0 && first + tapsPerPhase <= historyFrames);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            destination[ch][i] = dotProduct(row, source[ch] + first, tapsPerPhase);
+    }
+
+    outputFramesProduced += numOutput;
+
+    // Drop the input no later frame reaches
+    const juce::int64 nextPosition = outputFramesProduced * downFactor + delay;
+    const int unused = (int)juce::jlimit((juce::int64)0, (juce::int64)historyFrames,
+                                         nextPosition / upFactor - (tapsPerPhase - 1) - historyStart);
+
+    if (unused > 0)
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            float* data = history.getWritePointer(ch);
+            std::memmove(data, data + unused, sizeof(float) * (size_t)(historyFrames - unused));
+        }
+
+        historyStart += unused;
+        historyFrames -= unused;
+    }
+
+    return numOutput;
+}
+
+void SampleRateConverter::appendInput(const float* const* input, int numFrames)
+{
+    if (numFrames <= 0)
+        return;
+
+    if (historyFrames + numFrames > history.getNumSamples())
+        history.setSize(numChannels, historyFrames + numFrames, true, false, true);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        float* destination = history.getWritePointer(ch, historyFrames);
+
+        if (input != nullptr)
+            juce::FloatVectorOperations::copy(destination, input[ch], numFrames);
+        else
+            juce::FloatVectorOperations::clear(destination, numFrames);
+    }
+
+    historyFrames += numFrames;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * Streaming polyphase sample-rate converter
+ *
+ * Converts between any two integer rates by the exact rational ratio
+ * L / M (44.1 -> 48 kHz is 160 / 147): a Kaiser-windowed sinc prototype is
+ * split into L phases, and each output frame is one dot product of a phase
+ * against the most recent input frames. The dot product is the whole inner
+ * loop, so it runs on SSE or NEON registers where available (the phase
+ * lengths are whole numbers of registers).
+ *
+ * The filter's group delay is compensated: output frame n lines up with input
+ * time n * M / L, and after flush() exactly ceil(inputFrames * L / M) frames
+ * have come out. Captures converted back to the source rate therefore stay
+ * sample-aligned with the source.
+ *
+ * Not thread safe - one instance per thread. Building the kernel allocates,
+ * processing only grows the scratch buffers.
+ */
+class SampleRateConverter
+{
+public:
+    //==============================================================================
+    /** Filter length and steepness - taps per phase are per output frame when decimating (x4 for 192 -> 48 kHz) */
+    enum class Quality
+    {
+        fast,      // 16 taps per phase, ~55 dB stopband, cutoff at 80% of Nyquist
+        standard,  // 48 taps per phase, ~75 dB stopband, cutoff at 90% of Nyquist
+        best       // 96 taps per phase, ~110 dB stopband, cutoff at 94% of Nyquist
+    };
+
+    //==============================================================================
+    SampleRateConverter(double sourceRate, double targetRate, int numChannels, Quality quality);
+    ~SampleRateConverter();
+
+    /** True if audio at sourceRate has to be converted to play at targetRate */
+    static bool isNeeded(double sourceRate, double targetRate) noexcept;
+
+    /** Frames that come out of numInputFrames once flushed */
+    juce::int64 getOutputLength(juce::int64 numInputFrames) const noexcept;
+
+    /**
+     * Converts the next numFrames frames
+     * @param input One pointer per channel
+     * @param output Resized as needed (without shrinking its allocation); the frames ready so far go to its start
+     * @return The number of frames written to output
+     */
+    int process(const float* const* input, int numFrames, juce::AudioBuffer<float>& output);
+
+    /** Writes the frames still held back by the filter delay and ends the stream */
+    int flush(juce::AudioBuffer<float>& output);
+
+    /** Forgets all input, ready for a new stream */
+    void reset();
+
+    int getNumChannels() const noexcept { return numChannels; }
+
+private:
+    //==============================================================================
+    void buildKernel(Quality quality);
+    int produce(juce::int64 outputEnd, juce::AudioBuffer<float>& output);
+    void appendInput(const float* const* input, int numFrames);
+
+    const int numChannels;
+    juce::int64 upFactor = 1;           // L
+    juce::int64 downFactor = 1;         // M
+    int tapsPerPhase = 0;               // A multiple of the SIMD register width
+    juce::int64 delay = 0;              // Prototype delay, in upsampled frames
+
+    std::vector<float> phases;          // [phase][tap], taps reversed so the dot product runs forwards
+
+    // Input still needed by the filter, as absolute frame numbers [historyStart, historyStart + historyFrames)
+    juce::AudioBuffer<float> history;
+    juce::int64 historyStart = 0;
+    int historyFrames = 0;
+
+    juce::int64 inputFramesPushed = 0;
+    juce::int64 outputFramesProduced = 0;
+    bool flushed = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleRateConverter)
+};
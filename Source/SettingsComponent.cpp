@@ -108,6 +108,14 @@ SettingsComponent::SettingsComponent(AppState& state)
     measureLatencyButton.addListener(this);
     addAndMakeVisible(measureLatencyButton);
 
+    captureImpulseResponseButton.setButtonText("Capture Impulse Response");
+    captureImpulseResponseButton.addListener(this);
+    addAndMakeVisible(captureImpulseResponseButton);
+
+    calibrateRoutesButton.setButtonText("Calibrate All Routes");
+    calibrateRoutesButton.addListener(this);
+    addAndMakeVisible(calibrateRoutesButton);
+
     // Output Folder
     outputFolderLabel.setText("Output Folder:", juce::dontSendNotification);
     addAndMakeVisible(outputFolderLabel);
@@ -166,9 +174,48 @@ SettingsComponent::SettingsComponent(AppState& state)
 
     // Trim Silence
     trimSilenceToggle.setButtonText("Trim silence");
-    trimSilenceToggle.setToggleState(true, juce::dontSendNotification);
+    trimSilenceToggle.setToggleState(false, juce::dontSendNotification);
     trimSilenceToggle.addListener(this);
     addAndMakeVisible(trimSilenceToggle);
+
+    // One-Take Mode
+    oneTakeToggle.setButtonText("One-take render (short one-shots)");
+    oneTakeToggle.addListener(this);
+    addAndMakeVisible(oneTakeToggle);
+
+    // Sample-Rate Conversion
+    resampleQualityLabel.setText("Rate conversion:", juce::dontSendNotification);
+    addAndMakeVisible(resampleQualityLabel);
+
+    resampleQualityCombo.addItem("Fast", 1);
+    resampleQualityCombo.addItem("Standard", 2);
+    resampleQualityCombo.addItem("Best", 3);
+    resampleQualityCombo.setSelectedId(2); // Default standard
+    resampleQualityCombo.addListener(this);
+    addAndMakeVisible(resampleQualityCombo);
+
+    sourceRateOutputToggle.setButtonText("Write outputs at the source rate");
+    sourceRateOutputToggle.addListener(this);
+    addAndMakeVisible(sourceRateOutputToggle);
+
+    // Offline Plugin Render
+    offlinePluginToggle.setButtonText("Offline render through plugin");
+    offlinePluginToggle.addListener(this);
+    addAndMakeVisible(offlinePluginToggle);
+
+    pluginPathLabel.setText("No plugin", juce::dontSendNotification);
+    pluginPathLabel.setFont(makeFont(11.0f));
+    pluginPathLabel.setColour(juce::Label::textColourId, juce::Colour(0xff86868b));
+    addAndMakeVisible(pluginPathLabel);
+
+    choosePluginButton.setButtonText("Plugin...");
+    choosePluginButton.addListener(this);
+    addAndMakeVisible(choosePluginButton);
+
+    // Impulse Response Render
+    impulseResponseRenderToggle.setButtonText("Render through captured impulse response");
+    impulseResponseRenderToggle.addListener(this);
+    addAndMakeVisible(impulseResponseRenderToggle);
 }
 
 SettingsComponent::~SettingsComponent()
@@ -249,6 +296,10 @@ void SettingsComponent::resized()
     latencyValueLabel.setBounds(bounds.getX(), yPos, bounds.getWidth(), 16);
     yPos += 16 + 4;
     measureLatencyButton.setBounds(bounds.getX(), yPos, bounds.getWidth(), itemHeight);
+    yPos += itemHeight + 4;
+    captureImpulseResponseButton.setBounds(bounds.getX(), yPos, bounds.getWidth(), itemHeight);
+    yPos += itemHeight + 4;
+    calibrateRoutesButton.setBounds(bounds.getX(), yPos, bounds.getWidth(), itemHeight);
     yPos += itemHeight + sectionSpacing;
 
     // Output Settings
@@ -283,6 +334,24 @@ void SettingsComponent::resized()
     yPos += itemHeight + spacing;
 
     trimSilenceToggle.setBounds(bounds.getX(), yPos, bounds.getWidth(), itemHeight);
+    yPos += itemHeight + spacing;
+
+    oneTakeToggle.setBounds(bounds.getX(), yPos, bounds.getWidth(), itemHeight);
+    yPos += itemHeight + spacing;
+
+    resampleQualityLabel.setBounds(bounds.getX(), yPos, bounds.getWidth() - 110, itemHeight);
+    resampleQualityCombo.setBounds(bounds.getRight() - 100, yPos, 100, itemHeight);
+    yPos += itemHeight + 4;
+    sourceRateOutputToggle.setBounds(bounds.getX(), yPos, bounds.getWidth(), itemHeight);
+    yPos += itemHeight + spacing;
+
+    offlinePluginToggle.setBounds(bounds.getX(), yPos, bounds.getWidth(), itemHeight);
+    yPos += itemHeight + 4;
+    pluginPathLabel.setBounds(bounds.getX(), yPos, pathWidth, itemHeight);
+    choosePluginButton.setBounds(bounds.getX() + pathWidth + 8, yPos, 72, itemHeight);
+    yPos += itemHeight + spacing;
+
+    impulseResponseRenderToggle.setBounds(bounds.getX(), yPos, bounds.getWidth(), itemHeight);
 }
 
 void SettingsComponent::comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged)
@@ -320,7 +389,7 @@ void SettingsComponent::comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged)
         }
         // Warn user that latency needs re-measurement
         appState.appendLog("Sample rate changed to " + juce::String(appState.settings.sampleRate) + " Hz - reconfiguring device...");
-        appState.settings.measuredLatencySamples = -1; // Invalidate latency
+        appState.settings.invalidateLatency();
 
         // CRITICAL: Reconfigure audio device with new sample rate
         if (onDeviceNeedsReconfiguration)
@@ -337,6 +406,15 @@ void SettingsComponent::comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged)
             case 4: appState.settings.bufferSize = BufferSize::samples1024; break;
         }
     }
+    else if (comboBoxThatHasChanged == &resampleQualityCombo)
+    {
+        switch (resampleQualityCombo.getSelectedId())
+        {
+            case 1: appState.settings.resampleQuality = SampleRateConverter::Quality::fast; break;
+            case 2: appState.settings.resampleQuality = SampleRateConverter::Quality::standard; break;
+            case 3: appState.settings.resampleQuality = SampleRateConverter::Quality::best; break;
+        }
+    }
 }
 
 void SettingsComponent::buttonClicked(juce::Button* button)
@@ -378,6 +456,37 @@ void SettingsComponent::buttonClicked(juce::Button* button)
     {
         appState.settings.trimEnabled = trimSilenceToggle.getToggleState();
     }
+    else if (button == &oneTakeToggle)
+    {
+        appState.settings.useOneTakeMode = oneTakeToggle.getToggleState();
+    }
+    else if (button == &sourceRateOutputToggle)
+    {
+        appState.settings.convertCapturesToSourceRate = sourceRateOutputToggle.getToggleState();
+    }
+    else if (button == &offlinePluginToggle)
+    {
+        appState.settings.useOfflinePluginRender = offlinePluginToggle.getToggleState();
+    }
+    else if (button == &choosePluginButton)
+    {
+        if (onPluginSelected)
+            onPluginSelected();
+    }
+    else if (button == &captureImpulseResponseButton)
+    {
+        if (onCaptureImpulseResponse)
+            onCaptureImpulseResponse();
+    }
+    else if (button == &calibrateRoutesButton)
+    {
+        if (onCalibrateRoutes)
+            onCalibrateRoutes();
+    }
+    else if (button == &impulseResponseRenderToggle)
+    {
+        appState.settings.useImpulseResponseRender = impulseResponseRenderToggle.getToggleState();
+    }
 }
 
 void SettingsComponent::sliderValueChanged(juce::Slider* slider)
@@ -397,6 +506,27 @@ void SettingsComponent::sliderValueChanged(juce::Slider* slider)
 }
 
 void SettingsComponent::updateFromState()
+{
+    // Only sections that changed since the last call are refreshed
+    const bool devicesChanged = stateWatcher.hasChanged(appState, StateSection::devices);
+    const bool settingsChanged = stateWatcher.hasChanged(appState, StateSection::settings);
+    const bool progressChanged = stateWatcher.hasChanged(appState, StateSection::progress);
+
+    if (devicesChanged)
+        updateDevicesFromState();
+
+    if (settingsChanged)
+        updateSettingsFromState();
+
+    if (settingsChanged || progressChanged)
+    {
+        impulseResponseRenderToggle.setEnabled(appState.chainImpulseResponse.getNumSamples() > 0);
+        captureImpulseResponseButton.setEnabled(!appState.isCapturingImpulseResponse);
+        calibrateRoutesButton.setEnabled(!appState.isCalibratingRoutes);
+    }
+}
+
+void SettingsComponent::updateDevicesFromState()
 {
     auto rebuildComboIfNeeded = [](juce::ComboBox& combo, const auto& itemsProvider)
     {
@@ -447,6 +577,18 @@ void SettingsComponent::updateFromState()
                 deviceInfoLabel.setText(juce::String(device.inputChannelCount) + " inputs, " +
                                        juce::String(device.outputChannelCount) + " outputs",
                                        juce::dontSendNotification);
+
+                // Grey out what the driver doesn't offer - nothing is known for a device that couldn't be opened
+                const double rates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+                const int sizes[] = { 128, 256, 512, 1024 };
+
+                for (int item = 0; item < juce::numElementsInArray(rates); ++item)
+                    sampleRateCombo.setItemEnabled(item + 1, device.sampleRates.isEmpty()
+                                                                 || device.sampleRates.contains(rates[item]));
+
+                for (int item = 0; item < juce::numElementsInArray(sizes); ++item)
+                    bufferSizeCombo.setItemEnabled(item + 1, device.bufferSizes.isEmpty()
+                                                                 || device.bufferSizes.contains(sizes[item]));
                 break;
             }
         }
@@ -525,15 +667,24 @@ void SettingsComponent::updateFromState()
     {
         outputInfoLabel.setText("No output pair selected", juce::dontSendNotification);
     }
+}
 
+void SettingsComponent::updateSettingsFromState()
+{
     // Update latency display
-    if (appState.settings.measuredLatencySamples >= 0)
+    if (appState.settings.measuredLatencyFrames >= 0)
     {
-        latencyValueLabel.setText(juce::String(appState.settings.measuredLatencySamples) + " samples (" +
+        latencyValueLabel.setText(juce::String(appState.settings.measuredLatencyFrames) + " samples (" +
                                  juce::String(appState.settings.getLatencyInMs(), 2) + " ms)",
                                  juce::dontSendNotification);
         latencyValueLabel.setColour(juce::Label::textColourId, juce::Colour(0xff34c759)); // Green
     }
+    else
+    {
+        // Reconfigured to a setup without a stored profile
+        latencyValueLabel.setText("Not measured", juce::dontSendNotification);
+        latencyValueLabel.setColour(juce::Label::textColourId, juce::Colour(0xffff3b30)); // Red
+    }
 
     // Update output folder
     if (appState.settings.outputFolderPath.isNotEmpty())
@@ -554,6 +705,21 @@ void SettingsComponent::updateFromState()
     noiseFloorMarginSlider.setValue(appState.settings.noiseFloorMarginPercent, juce::dontSendNotification);
     silenceDelaySlider.setValue(appState.settings.silenceBetweenFilesMs, juce::dontSendNotification);
     trimSilenceToggle.setToggleState(appState.settings.trimEnabled, juce::dontSendNotification);
+    oneTakeToggle.setToggleState(appState.settings.useOneTakeMode, juce::dontSendNotification);
+    resampleQualityCombo.setSelectedId((int)appState.settings.resampleQuality + 1, juce::dontSendNotification);
+    sourceRateOutputToggle.setToggleState(appState.settings.convertCapturesToSourceRate, juce::dontSendNotification);
+    offlinePluginToggle.setToggleState(appState.settings.useOfflinePluginRender, juce::dontSendNotification);
+    impulseResponseRenderToggle.setToggleState(appState.settings.useImpulseResponseRender, juce::dontSendNotification);
+
+    // Update offline plugin
+    if (appState.settings.offlinePluginPath.isNotEmpty())
+    {
+        pluginPathLabel.setText(juce::File::isAbsolutePath(appState.settings.offlinePluginPath)
+                                    ? juce::File(appState.settings.offlinePluginPath).getFileName()
+                                    : appState.settings.offlinePluginPath,
+                                juce::dontSendNotification);
+        pluginPathLabel.setColour(juce::Label::textColourId, juce::Colour(0xff1d1d1f));
+    }
 }
 
 void SettingsComponent::drawSectionHeader(juce::Graphics& g, juce::Rectangle<int> bounds, const juce::String& title)
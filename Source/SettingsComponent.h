@@ -31,12 +31,15 @@ public:
     // Callbacks for actions
     std::function<void()> onRefreshDevices;
     std::function<void()> onMeasureLatency;
+    std::function<void()> onCaptureImpulseResponse;
+    std::function<void()> onCalibrateRoutes;
     std::function<void()> onStartLoopTest;
     std::function<void()> onStopLoopTest;
     std::function<void(const juce::String&)> onDeviceSelected;
     std::function<void(int)> onInputPairSelected;
     std::function<void(int)> onOutputPairSelected;
     std::function<void()> onOutputFolderSelected;
+    std::function<void()> onPluginSelected;
     std::function<void()> onDeviceNeedsReconfiguration;
 
 private:
@@ -72,6 +75,8 @@ private:
     juce::Label latencyLabel;
     juce::Label latencyValueLabel;
     juce::TextButton measureLatencyButton;
+    juce::TextButton captureImpulseResponseButton;
+    juce::TextButton calibrateRoutesButton;
 
     // Output Settings Section
     juce::Label outputFolderLabel;
@@ -93,6 +98,23 @@ private:
     juce::Label silenceDelayValueLabel;
 
     juce::ToggleButton trimSilenceToggle;
+    juce::ToggleButton oneTakeToggle;
+
+    // Sample-rate conversion of sources at another rate
+    juce::Label resampleQualityLabel;
+    juce::ComboBox resampleQualityCombo;
+    juce::ToggleButton sourceRateOutputToggle;
+
+    // Offline Render Section
+    juce::ToggleButton offlinePluginToggle;
+    juce::Label pluginPathLabel;
+    juce::TextButton choosePluginButton;
+    juce::ToggleButton impulseResponseRenderToggle;
+
+    // Change tracking - updateFromState() only touches sections whose version moved
+    StateWatcher stateWatcher;
+    void updateDevicesFromState();
+    void updateSettingsFromState();
 
     // Section separators
     void drawSectionHeader(juce::Graphics& g, juce::Rectangle<int> bounds, const juce::String& title);
@@ -0,0 +1,115 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "SweepMeasurement.h"
+
+namespace
+{
+constexpr double sweepStartHz = 20.0;
+constexpr float sweepLevel = 0.5f;         // -6 dBFS leaves headroom for resonant gear
+constexpr double fadeInSeconds = 0.01;
+constexpr double fadeOutSeconds = 0.005;
+
+// Bins where the sweep has (almost) no energy are divided by this fraction of the peak instead
+constexpr float regularisation = 1.0e-6f;
+}
+
+//==============================================================================
+SweepMeasurement::SweepMeasurement(double sampleRateToUse, double sweepSeconds,
+                                   double impulseResponseSeconds, int latencyFramesToUse)
+    : sampleRate(sampleRateToUse),
+      sweepFrames(juce::jmax(1024, (int)(sweepSeconds * sampleRateToUse))),
+      impulseResponseFrames(juce::jmax(256, (int)(impulseResponseSeconds * sampleRateToUse))),
+      latencyFrames(juce::jmax(0, latencyFramesToUse))
+{
+    // The first response must ring out before the second sweep starts
+    segmentFrames = sweepFrames + latencyFrames + impulseResponseFrames;
+
+    // Exponential sweep: equal time per octave, from 20 Hz to just below Nyquist
+    const double endHz = juce::jmin(20000.0, sampleRate * 0.45);
+    const double duration = sweepFrames / sampleRate;
+    const double logRatio = std::log(endHz / sweepStartHz);
+    const int fadeInFrames = (int)(fadeInSeconds * sampleRate);
+    const int fadeOutFrames = (int)(fadeOutSeconds * sampleRate);
+
+    sweep.setSize(1, sweepFrames);
+    float* data = sweep.getWritePointer(0);
+
+    for (int i = 0; i < sweepFrames; ++i)
+    {
+        const double t = i / sampleRate;
+        const double phase = juce::MathConstants<double>::twoPi * sweepStartHz * duration / logRatio
+                           * (std::exp(t / duration * logRatio) - 1.0);
+
+        float gain = sweepLevel;
+        if (i < fadeInFrames)
+            gain *= 0.5f - 0.5f * std::cos(juce::MathConstants<float>::pi * (float)i / (float)fadeInFrames);
+        else if (i >= sweepFrames - fadeOutFrames)
+            gain *= 0.5f - 0.5f * std::cos(juce::MathConstants<float>::pi * (float)(sweepFrames - 1 - i) / (float)fadeOutFrames);
+
+        data[i] = gain * (float)std::sin(phase);
+    }
+
+    stimulus.setSize(2, 2 * segmentFrames);
+    stimulus.clear();
+    stimulus.copyFrom(0, 0, sweep, 0, 0, sweepFrames);
+    stimulus.copyFrom(1, segmentFrames, sweep, 0, 0, sweepFrames);
+}
+
+juce::AudioBuffer<float> SweepMeasurement::extractImpulseResponses(const juce::AudioBuffer<float>& capture) const
+{
+    using Complex = juce::dsp::Complex<float>;
+
+    // Long enough that the linear convolution of sweep and response never wraps into the kept region
+    const int fftSize = juce::nextPowerOfTwo(segmentFrames + sweepFrames);
+    juce::dsp::FFT fft(juce::roundToInt(std::log2((double)fftSize)));
+
+    std::vector<Complex> sweepSpectrum((size_t)fftSize), timeDomain((size_t)fftSize), spectrum((size_t)fftSize);
+
+    for (int i = 0; i < fftSize; ++i)
+        timeDomain[(size_t)i] = { i < sweepFrames ? sweep.getSample(0, i) : 0.0f, 0.0f };
+
+    fft.perform(timeDomain.data(), sweepSpectrum.data(), false);
+
+    float peakPower = 0.0f;
+    for (const auto& bin : sweepSpectrum)
+        peakPower = juce::jmax(peakPower, std::norm(bin));
+
+    const float floorPower = peakPower * regularisation;
+
+    juce::AudioBuffer<float> responses(4, impulseResponseFrames);
+    responses.clear();
+
+    for (int send = 0; send < 2; ++send)
+    {
+        const int segmentStart = send * segmentFrames;
+
+        for (int ret = 0; ret < juce::jmin(2, capture.getNumChannels()); ++ret)
+        {
+            const float* captured = capture.getReadPointer(ret);
+
+            for (int i = 0; i < fftSize; ++i)
+            {
+                const int position = segmentStart + i;
+                const bool inSegment = i < segmentFrames && position < capture.getNumSamples();
+                timeDomain[(size_t)i] = { inSegment ? captured[position] : 0.0f, 0.0f };
+            }
+
+            fft.perform(timeDomain.data(), spectrum.data(), false);
+
+            // H = Y X* / (|X|^2 + floor)
+            for (int i = 0; i < fftSize; ++i)
+            {
+                const Complex x = sweepSpectrum[(size_t)i];
+                spectrum[(size_t)i] = spectrum[(size_t)i] * std::conj(x) / (std::norm(x) + floorPower);
+            }
+
+            fft.perform(spectrum.data(), timeDomain.data(), true);
+
+            // The chain's response starts one round trip after the send
+            float* response = responses.getWritePointer(send * 2 + ret);
+            for (int i = 0; i < impulseResponseFrames; ++i)
+                response[i] = timeDomain[(size_t)(latencyFrames + i)].real();
+        }
+    }
+
+    return responses;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * Swept-sine impulse response measurement of a stereo send/return chain
+ *
+ * The stimulus is an exponential sine sweep on the left send, then silence
+ * long enough for the chain to ring out, then the same sweep on the right
+ * send. Both returns are recorded throughout, so one capture yields the full
+ * 2 x 2 matrix: L->L, L->R, R->L and R->R.
+ *
+ * Each response is recovered by regularised spectral division of the return
+ * by the sweep. The round-trip latency is cut off the front, so a file
+ * convolved with the result lines up with its hardware capture sample for
+ * sample. Harmonic distortion products land at negative time and are
+ * discarded with the rest of the wrapped region.
+ */
+class SweepMeasurement
+{
+public:
+    //==============================================================================
+    SweepMeasurement(double sampleRate, double sweepSeconds, double impulseResponseSeconds, int latencyFrames);
+
+    /** Two channels: the sweep on channel 0, silence, then the sweep on channel 1 */
+    const juce::AudioBuffer<float>& getStimulus() const noexcept { return stimulus; }
+
+    /** Frames to capture from the first frame sent (the stimulus plus the last response) */
+    int getCaptureFrames() const noexcept { return stimulus.getNumSamples(); }
+
+    /**
+     * Deconvolves a two-channel capture of the stimulus
+     * @return Four channels (send * 2 + return), getImpulseResponseFrames() long
+     */
+    juce::AudioBuffer<float> extractImpulseResponses(const juce::AudioBuffer<float>& capture) const;
+
+    int getImpulseResponseFrames() const noexcept { return impulseResponseFrames; }
+
+private:
+    //==============================================================================
+    double sampleRate;
+    int sweepFrames;
+    int impulseResponseFrames;
+    int latencyFrames;
+    int segmentFrames;  // Sweep + ring-out, one per send channel
+
+    juce::AudioBuffer<float> sweep;     // Mono
+    juce::AudioBuffer<float> stimulus;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SweepMeasurement)
+};
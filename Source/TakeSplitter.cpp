@@ -0,0 +1,230 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "TakeSplitter.h"
+
+namespace
+{
+// Frames read and written per call on the splitter thread
+constexpr int splitterBlockFrames = 4096;
+}
+
+//==============================================================================
+TakeSplitter::TakeSplitter()
+    : juce::Thread("Take Splitter")
+{
+    formatManager.registerBasicFormats();
+    startThread();
+}
+
+TakeSplitter::~TakeSplitter()
+{
+    stopThread(4000);
+    cancelPendingUpdate();
+}
+
+void TakeSplitter::splitTake(const Job& job)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        pendingJobs.add(job);
+    }
+
+    notify();
+}
+
+void TakeSplitter::cancelPendingJobs()
+{
+    const juce::ScopedLock sl(lock);
+    pendingJobs.clear();
+}
+
+bool TakeSplitter::writeManifest(const Job& job)
+{
+    juce::Array<juce::var> segments;
+
+    for (const auto& segment : job.segments)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("fileIndex", segment.fileIndex);
+        entry->setProperty("source", segment.sourceFile.getFullPathName());
+        entry->setProperty("output", segment.outputFile.getFullPathName());
+        entry->setProperty("sendOffset", segment.sendOffset);
+        entry->setProperty("sourceFrames", segment.sourceFrames);
+        entry->setProperty("capturedFrames", segment.capturedFrames);
+        entry->setProperty("outputSampleRate", segment.outputSampleRate > 0.0 ? segment.outputSampleRate : job.sampleRate);
+        segments.add(juce::var(entry));
+    }
+
+    auto* manifest = new juce::DynamicObject();
+    manifest->setProperty("take", job.takeFile.getFileName());
+    manifest->setProperty("sampleRate", job.sampleRate);
+    manifest->setProperty("latencyFrames", job.latencyFrames);
+    manifest->setProperty("channelAdvanceFrames", juce::Array<juce::var>(job.channelAdvanceFrames.begin(), job.channelAdvanceFrames.size()));
+    manifest->setProperty("keepTail", job.keepTail);
+    manifest->setProperty("segments", segments);
+
+    return job.manifestFile.replaceWithText(juce::JSON::toString(juce::var(manifest)));
+}
+
+//==============================================================================
+// Splitter Thread
+
+void TakeSplitter::run()
+{
+    while (!threadShouldExit())
+    {
+        Job job;
+        bool hasJob = false;
+
+        {
+            const juce::ScopedLock sl(lock);
+
+            if (!pendingJobs.isEmpty())
+            {
+                job = pendingJobs.removeAndReturn(0);
+                hasJob = true;
+            }
+        }
+
+        if (!hasJob)
+        {
+            wait(50);
+            continue;
+        }
+
+        processJob(job);
+    }
+}
+
+void TakeSplitter::processJob(const Job& job)
+{
+    // The manifest is written first so the take can still be split by hand if we fail below
+    juce::String jobWarning;
+
+    if (!writeManifest(job))
+        jobWarning = "Could not write the take manifest - " + job.manifestFile.getFullPathName();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(job.takeFile));
+    bool allSucceeded = reader != nullptr;
+
+    for (const auto& segment : job.segments)
+    {
+        Result result;
+
+        if (threadShouldExit())
+        {
+            result.fileIndex = segment.fileIndex;
+            result.outputFile = segment.outputFile;
+            result.errorMessage = "Split cancelled - " + segment.outputFile.getFileName();
+        }
+        else if (reader == nullptr)
+        {
+            result.fileIndex = segment.fileIndex;
+            result.outputFile = segment.outputFile;
+            result.errorMessage = "Could not read take - " + job.takeFile.getFileName();
+        }
+        else
+        {
+            result = writeSegment(*reader, job, segment);
+        }
+
+        result.sessionId = job.sessionId;
+        result.jobWarning = jobWarning;
+        jobWarning.clear();
+
+        allSucceeded = allSucceeded && result.succeeded;
+        postResult(result);
+    }
+
+    reader.reset();
+
+    if (allSucceeded && job.deleteTakeWhenDone)
+        job.takeFile.deleteFile();
+}
+
+TakeSplitter::Result TakeSplitter::writeSegment(juce::AudioFormatReader& reader, const Job& job, const Segment& segment)
+{
+    Result result;
+    result.fileIndex = segment.fileIndex;
+    result.outputFile = segment.outputFile;
+
+    if (segment.sendOffset < 0)
+    {
+        result.errorMessage = "File was not captured in the take - " + segment.sourceFile.getFileName();
+        return result;
+    }
+
+    const int numChannels = juce::jmax(1, (int)reader.numChannels);
+    const juce::int64 numFrames = job.keepTail ? juce::jmax((juce::int64)0, segment.capturedFrames - job.latencyFrames)
+                                               : segment.sourceFrames;
+
+    scratchBuffer.setSize(numChannels, splitterBlockFrames, false, false, true);
+
+    CaptureOutput::Format format;
+    format.sampleRate = job.sampleRate;
+    format.outputSampleRate = segment.outputSampleRate;
+    format.numChannels = numChannels;
+    format.skipFrames = job.latencyFrames;
+    format.channelAdvanceFrames = job.channelAdvanceFrames;
+    format.maxOutputFrames = numFrames;
+
+    CaptureOutput output;
+
+    if (!output.open(segment.outputFile, format, job.processing))
+    {
+        result.errorMessage = output.getErrorMessage();
+        return result;
+    }
+
+    // From the send start: the latency region (measured for DC), then the segment and what the alignment reads past it.
+    // Reads past the end of the take come back as silence, which pads short captures
+    const juce::int64 totalFrames = job.latencyFrames + numFrames + output.getLookahead();
+
+    for (juce::int64 position = 0; position < totalFrames; position += splitterBlockFrames)
+    {
+        const int chunk = (int)juce::jmin((juce::int64)splitterBlockFrames, totalFrames - position);
+        reader.read(&scratchBuffer, 0, chunk, segment.sendOffset + position, true, true);
+
+        if (!output.process(scratchBuffer.getArrayOfReadPointers(), chunk))
+        {
+            result.errorMessage = output.getErrorMessage();
+            return result;
+        }
+    }
+
+    if (!output.finish())
+    {
+        result.errorMessage = output.getErrorMessage();
+        return result;
+    }
+
+    result.framesWritten = output.getFramesWritten();
+    result.dcOffsetSkipped = output.isDCOffsetSkipped();
+    result.succeeded = true;
+    return result;
+}
+
+void TakeSplitter::postResult(const Result& result)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        finishedResults.add(result);
+    }
+
+    triggerAsyncUpdate();
+}
+
+void TakeSplitter::handleAsyncUpdate()
+{
+    juce::Array<Result> results;
+
+    {
+        const juce::ScopedLock sl(lock);
+        results.swapWith(finishedResults);
+    }
+
+    for (const auto& result : results)
+    {
+        if (onSegmentFinished)
+            onSegmentFinished(result);
+    }
+}
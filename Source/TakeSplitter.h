@@ -0,0 +1,104 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "CaptureOutput.h"
+
+//==============================================================================
+/**
+ * Background splitter for one-take batch renders
+ *
+ * In one-take mode every file is sent back to back as a single continuous
+ * stream and captured as one take. The engine reports where each file's send
+ * started in that take; this class writes those offsets to a JSON manifest next
+ * to the take, then cuts, latency-trims and DC-corrects each segment into its
+ * own output file on a worker thread.
+ *
+ * Each segment goes through the same CaptureOutput stage as a per-file
+ * capture (see LATENCY_TRIMMING_FIX.md): it starts latencyFrames after the
+ * send offset, each return is advanced by what remains of its own latency,
+ * and its DC bias is measured over that skipped latency region.
+ *
+ * Threading: splitTake() and results on the message thread, everything else on
+ * the splitter thread.
+ */
+class TakeSplitter : private juce::Thread,
+                     private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    /** One source file inside the take */
+    struct Segment
+    {
+        int fileIndex = -1;              // Index into AppState::files
+        juce::File sourceFile;
+        juce::File outputFile;
+        juce::int64 sendOffset = -1;     // Take frame where the file's send started (-1 = never sent)
+        juce::int64 sourceFrames = 0;
+        juce::int64 capturedFrames = 0;  // Frames captured from the send start to the end of its tail
+        double outputSampleRate = 0.0;   // Rate written to the output file, 0 = the take's rate
+    };
+
+    /** A captured take and everything needed to split it */
+    struct Job
+    {
+        juce::File takeFile;
+        juce::File manifestFile;
+        double sampleRate = 44100.0;
+        juce::int64 latencyFrames = 0;
+        juce::Array<double> channelAdvanceFrames;  // Each return's latency beyond latencyFrames, fractional
+        bool keepTail = false;           // Reverb mode: keep everything captured after the latency
+        CaptureOutput::Processing processing;
+        bool deleteTakeWhenDone = true;  // Only if every segment was written
+        int sessionId = -1;              // The owner's batch, echoed in each Result
+        juce::Array<Segment> segments;
+    };
+
+    /** Outcome of one segment, reported on the message thread */
+    struct Result
+    {
+        int sessionId = -1;
+        int fileIndex = -1;
+        juce::File outputFile;
+        bool succeeded = false;
+        juce::int64 framesWritten = 0;
+        bool dcOffsetSkipped = false;  // DC removal had no latency region to measure in (see CaptureOutput)
+        juce::String errorMessage;
+        juce::String jobWarning;       // Problem with the job as a whole (e.g. no manifest), on its first segment only
+    };
+
+    //==============================================================================
+    TakeSplitter();
+    ~TakeSplitter() override;
+
+    /** Queues a take for splitting - one Result is reported per segment */
+    void splitTake(const Job& job);
+
+    /** Drops queued jobs that have not started yet */
+    void cancelPendingJobs();
+
+    /** Called on the message thread each time a segment has been written (or failed) */
+    std::function<void(const Result&)> onSegmentFinished;
+
+    /** Writes the segment offsets of a job as JSON */
+    static bool writeManifest(const Job& job);
+
+private:
+    //==============================================================================
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    void processJob(const Job& job);
+    Result writeSegment(juce::AudioFormatReader& reader, const Job& job, const Segment& segment);
+    void postResult(const Result& result);
+
+    juce::AudioFormatManager formatManager;
+
+    juce::CriticalSection lock;
+    juce::Array<Job> pendingJobs;
+    juce::Array<Result> finishedResults;
+
+    // Splitter thread state
+    juce::AudioBuffer<float> scratchBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TakeSplitter)
+};
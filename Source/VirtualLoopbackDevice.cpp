@@ -0,0 +1,336 @@
+#include "JUCEIteratorFix.h"  // MUST be first - Fix for StrideIterator compatibility
+#include "VirtualLoopbackDevice.h"
+
+//==============================================================================
+VirtualLoopbackDevice::VirtualLoopbackDevice(const juce::String& deviceNameToUse, const juce::String& typeNameToUse,
+                                             const VirtualLoopbackSettings& initialSettings)
+    : juce::AudioIODevice(deviceNameToUse, typeNameToUse),
+      juce::Thread("Virtual Loopback"),
+      settings(initialSettings)
+{
+    settings.numChannels = juce::jmax(2, settings.numChannels);
+}
+
+VirtualLoopbackDevice::~VirtualLoopbackDevice()
+{
+    close();
+}
+
+juce::StringArray VirtualLoopbackDevice::getOutputChannelNames()
+{
+    juce::StringArray names;
+    for (int ch = 0; ch < settings.numChannels; ++ch)
+        names.add("Loop Out " + juce::String(ch + 1));
+    return names;
+}
+
+juce::StringArray VirtualLoopbackDevice::getInputChannelNames()
+{
+    juce::StringArray names;
+    for (int ch = 0; ch < settings.numChannels; ++ch)
+        names.add("Loop In " + juce::String(ch + 1));
+    return names;
+}
+
+juce::Array<double> VirtualLoopbackDevice::getAvailableSampleRates()
+{
+    return { 44100.0, 48000.0, 88200.0, 96000.0 };
+}
+
+juce::Array<int> VirtualLoopbackDevice::getAvailableBufferSizes()
+{
+    return { 64, 128, 256, 512, 1024, 2048 };
+}
+
+int VirtualLoopbackDevice::getDefaultBufferSize()
+{
+    return 256;
+}
+
+juce::String VirtualLoopbackDevice::open(const juce::BigInteger& inputChannels, const juce::BigInteger& outputChannels,
+                                         double sampleRate, int bufferSizeSamples)
+{
+    close();
+
+    currentSampleRate = sampleRate > 0.0 ? sampleRate : 44100.0;
+    currentBufferSize = bufferSizeSamples > 0 ? bufferSizeSamples : getDefaultBufferSize();
+
+    activeInputs = inputChannels;
+    activeOutputs = outputChannels;
+    activeInputs.setRange(settings.numChannels, juce::jmax(0, activeInputs.getHighestBit() + 1 - settings.numChannels), false);
+    activeOutputs.setRange(settings.numChannels, juce::jmax(0, activeOutputs.getHighestBit() + 1 - settings.numChannels), false);
+
+    activeInputChannels.clearQuick();
+    activeOutputChannels.clearQuick();
+    for (int ch = 0; ch < settings.numChannels; ++ch)
+    {
+        if (activeInputs[ch])  activeInputChannels.add(ch);
+        if (activeOutputs[ch]) activeOutputChannels.add(ch);
+    }
+
+    // Like a real interface the return can't arrive before the block that sent it has been rendered
+    const int jitterRange = (int)std::ceil(juce::jmax(0.0f, settings.clockJitterFrames));
+    loopDelayFrames = juce::jmax(settings.roundTripLatencyFrames, currentBufferSize + jitterRange + 2);
+
+    const int delayLineSize = juce::nextPowerOfTwo(loopDelayFrames + jitterRange + currentBufferSize + 4);
+    delayLines.setSize(settings.numChannels, delayLineSize);
+    delayLines.clear();
+    delayLineMask = delayLineSize - 1;
+    writePosition = 0;
+    currentJitter = 0.0;
+
+    loopGain = juce::Decibels::decibelsToGain(settings.gainDb);
+    noiseAmplitude = juce::Decibels::decibelsToGain(settings.noiseFloorDb);
+
+    inputBlock.setSize(juce::jmax(1, activeInputChannels.size()), currentBufferSize);
+    outputBlock.setSize(juce::jmax(1, activeOutputChannels.size()), currentBufferSize);
+    loopBlock.setSize(1, currentBufferSize);
+
+    inputPointers.clearQuick();
+    outputPointers.clearQuick();
+    for (int i = 0; i < activeInputChannels.size(); ++i)
+        inputPointers.add(inputBlock.getReadPointer(i));
+    for (int i = 0; i < activeOutputChannels.size(); ++i)
+        outputPointers.add(outputBlock.getWritePointer(i));
+
+    // One mono convolution per looped channel; a stereo IR alternates L/R across channels
+    convolutions.clear();
+    if (settings.impulseResponse.getNumSamples() > 0 && settings.impulseResponse.getNumChannels() > 0)
+    {
+        const juce::dsp::ProcessSpec spec { currentSampleRate, (juce::uint32)currentBufferSize, 1 };
+
+        for (int ch = 0; ch < settings.numChannels; ++ch)
+        {
+            const int irChannel = ch % settings.impulseResponse.getNumChannels();
+            juce::AudioBuffer<float> ir(1, settings.impulseResponse.getNumSamples());
+            ir.copyFrom(0, 0, settings.impulseResponse, irChannel, 0, ir.getNumSamples());
+
+            auto* convolution = convolutions.add(new juce::dsp::Convolution());
+            convolution->prepare(spec);
+            convolution->loadImpulseResponse(std::move(ir), settings.impulseResponseSampleRate,
+                                             juce::dsp::Convolution::Stereo::no,
+                                             juce::dsp::Convolution::Trim::no,
+                                             juce::dsp::Convolution::Normalise::no);
+        }
+    }
+
+    xrunCount = 0;
+    lastError.clear();
+    deviceIsOpen = true;
+    return {};
+}
+
+void VirtualLoopbackDevice::close()
+{
+    stop();
+    deviceIsOpen = false;
+}
+
+bool VirtualLoopbackDevice::isOpen()
+{
+    return deviceIsOpen;
+}
+
+void VirtualLoopbackDevice::start(juce::AudioIODeviceCallback* callback)
+{
+    if (!deviceIsOpen || callback == nullptr)
+        return;
+
+    stop();
+
+    callback->audioDeviceAboutToStart(this);
+
+    {
+        const juce::ScopedLock sl(callbackLock);
+        currentCallback = callback;
+    }
+
+    playing = true;
+    startThread(juce::Thread::Priority::highest);
+}
+
+void VirtualLoopbackDevice::stop()
+{
+    stopThread(2000);
+    playing = false;
+
+    juce::AudioIODeviceCallback* lastCallback = nullptr;
+
+    {
+        const juce::ScopedLock sl(callbackLock);
+        std::swap(lastCallback, currentCallback);
+    }
+
+    if (lastCallback != nullptr)
+        lastCallback->audioDeviceStopped();
+}
+
+bool VirtualLoopbackDevice::isPlaying()
+{
+    return playing;
+}
+
+juce::String VirtualLoopbackDevice::getLastError()                 { return lastError; }
+int VirtualLoopbackDevice::getCurrentBufferSizeSamples()           { return currentBufferSize; }
+double VirtualLoopbackDevice::getCurrentSampleRate()               { return currentSampleRate; }
+int VirtualLoopbackDevice::getCurrentBitDepth()                    { return 32; }
+juce::BigInteger VirtualLoopbackDevice::getActiveOutputChannels() const { return activeOutputs; }
+juce::BigInteger VirtualLoopbackDevice::getActiveInputChannels() const  { return activeInputs; }
+int VirtualLoopbackDevice::getOutputLatencyInSamples()             { return loopDelayFrames / 2; }
+int VirtualLoopbackDevice::getInputLatencyInSamples()              { return loopDelayFrames - loopDelayFrames / 2; }
+int VirtualLoopbackDevice::getXRunCount() const noexcept           { return xrunCount; }
+
+//==============================================================================
+// Render Thread
+
+void VirtualLoopbackDevice::run()
+{
+    const double blockMs = 1000.0 * currentBufferSize / currentSampleRate;
+    double nextBlockTime = juce::Time::getMillisecondCounterHiRes();
+
+    while (!threadShouldExit())
+    {
+        renderBlock();
+
+        if (!settings.runInRealTime)
+            continue;
+
+        nextBlockTime += blockMs;
+        const double now = juce::Time::getMillisecondCounterHiRes();
+
+        // Fell several blocks behind: a real interface would have dropped out here
+        if (now - nextBlockTime > blockMs * 4.0)
+        {
+            ++xrunCount;
+            nextBlockTime = now;
+            continue;
+        }
+
+        const double wakeTime = nextBlockTime + random.nextDouble() * settings.callbackJitterMs;
+
+        if (wakeTime > now)
+            wait(juce::jmax(0, juce::roundToInt(wakeTime - now)));
+    }
+}
+
+void VirtualLoopbackDevice::renderBlock()
+{
+    const int numFrames = currentBufferSize;
+
+    // 1. Inputs: the loop return plus the noise floor
+    // Each block ramps the delay towards a new random point so the wander stays smooth
+    const double nextJitter = (random.nextDouble() * 2.0 - 1.0) * settings.clockJitterFrames;
+
+    for (int i = 0; i < activeInputChannels.size(); ++i)
+    {
+        float* destination = inputBlock.getWritePointer(i);
+        readLoopReturn(activeInputChannels[i], destination,
+                       loopDelayFrames + currentJitter, loopDelayFrames + nextJitter);
+
+        // Uniform white noise scaled so its RMS matches the requested floor
+        const float noiseScale = noiseAmplitude * std::sqrt(3.0f);
+        for (int n = 0; n < numFrames; ++n)
+            destination[n] += noiseScale * (random.nextFloat() * 2.0f - 1.0f);
+    }
+
+    currentJitter = nextJitter;
+
+    // 2. The host callback
+    outputBlock.clear();
+
+    {
+        const juce::ScopedLock sl(callbackLock);
+
+        if (currentCallback != nullptr)
+            currentCallback->audioDeviceIOCallbackWithContext(inputPointers.getRawDataPointer(), inputPointers.size(),
+                                                              outputPointers.getRawDataPointer(), outputPointers.size(),
+                                                              numFrames, {});
+    }
+
+    // 3. Outputs into the loop: impulse response and gain, then the delay line
+    for (int ch = 0; ch < settings.numChannels; ++ch)
+    {
+        const int outputIndex = activeOutputChannels.indexOf(ch);
+
+        if (outputIndex >= 0)
+            loopBlock.copyFrom(0, 0, outputBlock, outputIndex, 0, numFrames);
+        else
+            loopBlock.clear();
+
+        if (auto* convolution = convolutions[ch])
+        {
+            juce::dsp::AudioBlock<float> block(loopBlock);
+            convolution->process(juce::dsp::ProcessContextReplacing<float>(block));
+        }
+
+        loopBlock.applyGain(loopGain);
+
+        const float* source = loopBlock.getReadPointer(0);
+        float* line = delayLines.getWritePointer(ch);
+        for (int n = 0; n < numFrames; ++n)
+            line[(int)((writePosition + n) & delayLineMask)] = source[n];
+    }
+
+    writePosition += numFrames;
+}
+
+void VirtualLoopbackDevice::readLoopReturn(int channel, float* destination, double startDelay, double endDelay)
+{
+    const int numFrames = currentBufferSize;
+    const float* line = delayLines.getReadPointer(channel);
+    const double delayStep = (endDelay - startDelay) / numFrames;
+
+    // Linear interpolation between the two frames around the (fractional) read point
+    for (int n = 0; n < numFrames; ++n)
+    {
+        const double readPosition = (double)(writePosition + n) - (startDelay + delayStep * n);
+        const auto index = (juce::int64)std::floor(readPosition);
+        const float fraction = (float)(readPosition - (double)index);
+
+        const float a = line[(int)(index & delayLineMask)];
+        const float b = line[(int)((index + 1) & delayLineMask)];
+        destination[n] = a + fraction * (b - a);
+    }
+}
+
+//==============================================================================
+VirtualLoopbackDeviceType::VirtualLoopbackDeviceType()
+    : juce::AudioIODeviceType(loopbackTypeName)
+{
+}
+
+void VirtualLoopbackDeviceType::setLoopbackSettings(const VirtualLoopbackSettings& newSettings)
+{
+    const juce::ScopedLock sl(settingsLock);
+    settings = newSettings;
+}
+
+VirtualLoopbackSettings VirtualLoopbackDeviceType::getLoopbackSettings() const
+{
+    const juce::ScopedLock sl(settingsLock);
+    return settings;
+}
+
+juce::StringArray VirtualLoopbackDeviceType::getDeviceNames(bool) const
+{
+    return { loopbackDeviceName };
+}
+
+int VirtualLoopbackDeviceType::getDefaultDeviceIndex(bool) const
+{
+    return 0;
+}
+
+int VirtualLoopbackDeviceType::getIndexOfDevice(juce::AudioIODevice* device, bool) const
+{
+    return device != nullptr && device->getName() == loopbackDeviceName ? 0 : -1;
+}
+
+juce::AudioIODevice* VirtualLoopbackDeviceType::createDevice(const juce::String& outputDeviceName,
+                                                             const juce::String& inputDeviceName)
+{
+    if (outputDeviceName != loopbackDeviceName && inputDeviceName != loopbackDeviceName)
+        return nullptr;
+
+    return new VirtualLoopbackDevice(loopbackDeviceName, loopbackTypeName, getLoopbackSettings());
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+ * Behaviour of the simulated send -> hardware -> return chain
+ */
+struct VirtualLoopbackSettings
+{
+    int numChannels = 8;                    // Inputs and outputs, looped 1:1 (output N -> input N)
+    int roundTripLatencyFrames = 512;       // Never shorter than one block plus the jitter range
+    float noiseFloorDb = -96.0f;            // RMS of the white noise added to every input
+    float gainDb = 0.0f;                    // Gain of the loop path
+    juce::AudioBuffer<float> impulseResponse;  // Optional colouration (e.g. a reverb), empty = dry
+    double impulseResponseSampleRate = 44100.0;
+    float clockJitterFrames = 0.0f;         // Peak wander of the loop delay in (fractional) frames
+    double callbackJitterMs = 0.0;          // Random lateness added to each callback
+    bool runInRealTime = true;              // false = render blocks back to back as fast as possible
+};
+
+//==============================================================================
+/**
+ * Hardware-free loopback audio device
+ *
+ * Renders blocks on its own thread and feeds every output back to the input
+ * with the same number, through a configurable delay, gain, impulse response
+ * and noise floor. Latency measurement, reverb mode and batch processing can
+ * therefore run end-to-end on build machines without an interface attached.
+ *
+ * The loop delay can wander by a fraction of a frame (clockJitterFrames) to
+ * model unsynchronised converter clocks, and callbacks can be delivered late
+ * (callbackJitterMs) to exercise the dropout handling. When the render thread
+ * falls several blocks behind real time the device reports an xrun.
+ */
+class VirtualLoopbackDevice : public juce::AudioIODevice,
+                              private juce::Thread
+{
+public:
+    //==============================================================================
+    VirtualLoopbackDevice(const juce::String& deviceNameToUse, const juce::String& typeNameToUse,
+                          const VirtualLoopbackSettings& settings);
+    ~VirtualLoopbackDevice() override;
+
+    //==============================================================================
+    // AudioIODevice overrides
+
+    juce::StringArray getOutputChannelNames() override;
+    juce::StringArray getInputChannelNames() override;
+    juce::Array<double> getAvailableSampleRates() override;
+    juce::Array<int> getAvailableBufferSizes() override;
+    int getDefaultBufferSize() override;
+
+    juce::String open(const juce::BigInteger& inputChannels, const juce::BigInteger& outputChannels,
+                      double sampleRate, int bufferSizeSamples) override;
+    void close() override;
+    bool isOpen() override;
+
+    void start(juce::AudioIODeviceCallback* callback) override;
+    void stop() override;
+    bool isPlaying() override;
+
+    juce::String getLastError() override;
+    int getCurrentBufferSizeSamples() override;
+    double getCurrentSampleRate() override;
+    int getCurrentBitDepth() override;
+    juce::BigInteger getActiveOutputChannels() const override;
+    juce::BigInteger getActiveInputChannels() const override;
+    int getOutputLatencyInSamples() override;
+    int getInputLatencyInSamples() override;
+    int getXRunCount() const noexcept override;
+
+private:
+    //==============================================================================
+    void run() override;
+
+    /** Renders one block: loop return -> callback -> outputs into the loop */
+    void renderBlock();
+
+    /** Reads one block of channel's delayed loop signal, with the delay ramping across the block */
+    void readLoopReturn(int channel, float* destination, double startDelay, double endDelay);
+
+    VirtualLoopbackSettings settings;
+
+    // Device state
+    bool deviceIsOpen = false;
+    double currentSampleRate = 44100.0;
+    int currentBufferSize = 256;
+    juce::BigInteger activeInputs, activeOutputs;
+    juce::Array<int> activeInputChannels, activeOutputChannels;
+    juce::String lastError;
+
+    juce::CriticalSection callbackLock;
+    juce::AudioIODeviceCallback* currentCallback = nullptr;
+    std::atomic<bool> playing { false };
+    std::atomic<int> xrunCount { 0 };
+
+    // Loop path (render thread only once started)
+    int loopDelayFrames = 0;             // Effective round trip after clamping
+    juce::AudioBuffer<float> delayLines; // One circular line per channel
+    int delayLineMask = 0;
+    juce::int64 writePosition = 0;
+    double currentJitter = 0.0;
+    float loopGain = 1.0f;
+    float noiseAmplitude = 0.0f;
+    juce::OwnedArray<juce::dsp::Convolution> convolutions;  // Per channel, empty when dry
+    juce::AudioBuffer<float> inputBlock, outputBlock, loopBlock;
+    juce::Array<const float*> inputPointers;
+    juce::Array<float*> outputPointers;
+    juce::Random random;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VirtualLoopbackDevice)
+};
+
+//==============================================================================
+/**
+ * Device type that lists the virtual loopback next to the real interfaces
+ *
+ * Register it with AudioDeviceManager::addAudioDeviceType() after the manager
+ * has created the platform types. Settings changes apply the next time the
+ * device is opened.
+ */
+class VirtualLoopbackDeviceType : public juce::AudioIODeviceType
+{
+public:
+    static constexpr const char* loopbackTypeName = "Virtual Loopback";
+    static constexpr const char* loopbackDeviceName = "F9 Virtual Loopback";
+
+    VirtualLoopbackDeviceType();
+
+    void setLoopbackSettings(const VirtualLoopbackSettings& newSettings);
+    VirtualLoopbackSettings getLoopbackSettings() const;
+
+    //==============================================================================
+    // AudioIODeviceType overrides
+
+    void scanForDevices() override {}
+    juce::StringArray getDeviceNames(bool wantInputNames = false) const override;
+    int getDefaultDeviceIndex(bool forInput) const override;
+    int getIndexOfDevice(juce::AudioIODevice* device, bool asInput) const override;
+    bool hasSeparateInputsAndOutputs() const override { return false; }
+    juce::AudioIODevice* createDevice(const juce::String& outputDeviceName,
+                                      const juce::String& inputDeviceName) override;
+
+private:
+    juce::CriticalSection settingsLock;
+    VirtualLoopbackSettings settings;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VirtualLoopbackDeviceType)
+};